@@ -37,6 +37,28 @@ win32 {
 INCLUDEPATH += $$PWD/../
 DEPENDPATH += $$PWD/../
 
+# Link the plugins listed in StaticPlugins.pri into the executable and import them
+# with Q_IMPORT_PLUGIN, so no plugin library is probed or loaded at startup
+static_plugins {
+    include(../Plugins/StaticPlugins.pri)
+
+    CONFIG(debug, debug|release) {
+        STATIC_PLUGIN_DIR = $$PWD/../build/debug/plugins
+    } else {
+        STATIC_PLUGIN_DIR = $$PWD/../build/release/plugins
+    }
+
+    STATIC_PLUGIN_IMPORTS = "$${LITERAL_HASH}include <QtPlugin>"
+    for(plugin, STATIC_PLUGINS) {
+        LIBS = -L$$STATIC_PLUGIN_DIR -l$$plugin $$LIBS
+        unix: PRE_TARGETDEPS += $$STATIC_PLUGIN_DIR/lib$${plugin}.a
+        STATIC_PLUGIN_IMPORTS += "Q_IMPORT_PLUGIN($${plugin}Plugin)"
+    }
+
+    write_file($$OUT_PWD/static_plugins.cpp, STATIC_PLUGIN_IMPORTS)|error("Failed to write static plugin imports")
+    SOURCES += $$OUT_PWD/static_plugins.cpp
+}
+
 # Output directory
 CONFIG(debug, debug|release) {
     DESTDIR = $$PWD/../build/debug
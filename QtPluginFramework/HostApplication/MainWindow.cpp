@@ -6,6 +6,8 @@
 #include "../PluginCore/ConfigManager.h"
 #include "../PluginCore/PermissionManager.h"
 #include "../PluginCore/PluginCommunication.h"
+#include "../PluginCore/PluginMetrics.h"
+#include "../PluginCore/PluginProfiler.h"
 
 #include <QApplication>
 #include <QMessageBox>
@@ -20,6 +22,8 @@
 #include <QGroupBox>
 #include <QTextEdit>
 #include <QDir>
+#include <QFutureWatcher>
+#include <QTimer>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), m_pluginManagerDialog(nullptr)
@@ -55,6 +59,8 @@ MainWindow::~MainWindow()
 
 bool MainWindow::initialize()
 {
+    PROFILE_SCOPE("MainWindow::initialize");
+
     // Initialize plugin manager
     QString appDir = QApplication::applicationDirPath();
     QString pluginDir = QDir(appDir).filePath("plugins");
@@ -90,6 +96,8 @@ bool MainWindow::initialize()
             LOG_WARNING("MainWindow", "Failed to load framework config");
         }
     }
+    PluginProfiler::instance().setEnabled(ConfigManager::instance().getFrameworkValue("profiling", true).toBool());
+    PluginMetrics::instance().setEnabled(ConfigManager::instance().getFrameworkValue("metrics", true).toBool());
     
     // Initialize permission manager
     if (!PermissionManager::instance().initialize()) {
@@ -105,6 +113,18 @@ bool MainWindow::initialize()
         return false;
     }
     
+    // Mailboxes of messages posted with postMessage() and requestAsync()
+    QString overflowPolicy = ConfigManager::instance().getFrameworkValue("mailboxOverflowPolicy", "block").toString();
+    PluginCommunication::instance().setDefaultMailboxPolicy(
+        ConfigManager::instance().getFrameworkValue("mailboxCapacity", 1024).toInt(),
+        overflowPolicy == "dropOldest" ? MailboxOverflowPolicy::DropOldest
+        : overflowPolicy == "reject" ? MailboxOverflowPolicy::Reject
+        : MailboxOverflowPolicy::Block);
+    PluginCommunication::instance().setMailboxBlockTimeout(ConfigManager::instance().getFrameworkValue("mailboxBlockTimeout", 1000).toInt());
+    if (ConfigManager::instance().hasFrameworkKey("mailboxThreads")) {
+        PluginCommunication::instance().setMailboxThreadCount(ConfigManager::instance().getFrameworkValue("mailboxThreads").toInt());
+    }
+    
     // Initialize plugin manager
     if (!PluginManager::instance().initialize(pluginDir, metadataDir)) {
         LOG_ERROR("MainWindow", "Failed to initialize plugin manager");
@@ -112,8 +132,36 @@ bool MainWindow::initialize()
         return false;
     }
     
-    // Scan for plugins
-    QStringList pluginIds = PluginManager::instance().scanForPlugins();
+    // Defer loading plugin libraries until a plugin is first used
+    PluginManager::instance().setLazyLoadingEnabled(ConfigManager::instance().getFrameworkValue("lazyLoading", false).toBool());
+    PluginManager::instance().setHotReloadEnabled(ConfigManager::instance().getFrameworkValue("hotReload", false).toBool());
+    PluginManager::instance().setEmbeddedMetadataEnabled(ConfigManager::instance().getFrameworkValue("embeddedMetadata", false).toBool());
+    PluginManager::instance().setThreadedPlugins(ConfigManager::instance().getFrameworkValue("threadedPlugins").toStringList());
+    PluginManager::instance().setShutdownTimeout(ConfigManager::instance().getFrameworkValue("shutdownTimeout", 2000).toInt());
+    
+    // Unload plugins that have not been used for a while; they are reloaded on their next command
+    PluginManager::instance().setIdleTimeout(ConfigManager::instance().getFrameworkValue("idleTimeout", 0).toInt());
+    PluginManager::instance().setMaxLoadedPlugins(ConfigManager::instance().getFrameworkValue("maxLoadedPlugins", 0).toInt());
+    const QVariantMap pluginIdleTimeouts = ConfigManager::instance().getFrameworkValue("pluginIdleTimeouts").toMap();
+    for (auto it = pluginIdleTimeouts.constBegin(); it != pluginIdleTimeouts.constEnd(); ++it) {
+        PluginManager::instance().setPluginIdleTimeout(it.key(), it.value().toInt());
+    }
+    
+    // Plugins pinned to one of their side-by-side versions
+    const QVariantMap pluginVersions = ConfigManager::instance().getFrameworkValue("pluginVersions").toMap();
+    for (auto it = pluginVersions.constBegin(); it != pluginVersions.constEnd(); ++it) {
+        PluginManager::instance().setPluginVersion(it.key(), it.value().toString());
+    }
+    
+    // Shut plugins down while the event loop's thread can still serve them, not from static destruction
+    connect(qApp, &QCoreApplication::aboutToQuit, this, []() {
+        PluginManager::instance().shutdown();
+        PluginCommunication::instance().shutdown();
+    });
+    
+    // Scan for plugins, optionally discarding the cached metadata index
+    bool rebuildIndex = ConfigManager::instance().getFrameworkValue("rebuildMetadataIndex", false).toBool();
+    QStringList pluginIds = PluginManager::instance().scanForPlugins(rebuildIndex);
     LOG_INFO("MainWindow", QString("Found %1 plugins").arg(pluginIds.size()));
     
     // Create plugin manager dialog
@@ -124,6 +172,16 @@ bool MainWindow::initialize()
     
     LOG_INFO("MainWindow", "Initialized");
     
+    QTimer::singleShot(0, this, &MainWindow::reportStartupProfile);
+    
+    // Warm the libraries of the plugins the operator is likely to use once the window is up
+    int preloadLimit = ConfigManager::instance().getFrameworkValue("preloadLimit", 3).toInt();
+    if (preloadLimit > 0) {
+        QTimer::singleShot(0, this, [preloadLimit]() {
+            PluginManager::instance().preloadPlugins(preloadLimit);
+        });
+    }
+    
     return true;
 }
 
@@ -247,16 +305,45 @@ void MainWindow::executePluginAction()
         return;
     }
     
-    QString pluginId = action->data().toString().split(":").first();
-    QString command = action->data().toString().split(":").last();
+    QVariantMap data = action->data().toMap();
+    QString pluginId = data.value("pluginId").toString();
+    QString command = data.value("command").toString();
     
     LOG_INFO("MainWindow", QString("Executing plugin action: %1 - %2").arg(pluginId, command));
     
-    QVariant result = PluginManager::instance().executePluginCommand(pluginId, command);
+    // Queued on the plugin's thread, so a threaded plugin's command does not block the UI
+    QFutureWatcher<QVariant>* watcher = new QFutureWatcher<QVariant>(this);
+    
+    connect(watcher, &QFutureWatcher<QVariant>::finished, this, [watcher]() {
+        QVariant result = watcher->future().resultCount() > 0 ? watcher->result() : QVariant();
+        if (result.isValid()) {
+            LOG_INFO("MainWindow", QString("Plugin action result: %1").arg(result.toString()));
+        }
+        watcher->deleteLater();
+    });
+    
+    // Published commands are dispatched by ID, generic actions by name
+    if (data.contains("commandId")) {
+        watcher->setFuture(PluginManager::instance().executePluginCommandAsync(pluginId, data.value("commandId").toInt()));
+    } else {
+        watcher->setFuture(PluginManager::instance().executePluginCommandAsync(pluginId, command));
+    }
+}
+
+void MainWindow::exportStartupProfile()
+{
+    QString filePath = QFileDialog::getSaveFileName(this, "Export Startup Profile", "startup_trace.json",
+                                                    "Chrome Trace (*.json)");
+    if (filePath.isEmpty()) {
+        return;
+    }
     
-    if (result.isValid()) {
-        LOG_INFO("MainWindow", QString("Plugin action result: %1").arg(result.toString()));
+    if (!PluginProfiler::instance().writeChromeTrace(filePath)) {
+        QMessageBox::warning(this, "Error", QString("Failed to write profile to %1").arg(filePath));
+        return;
     }
+    
+    LOG_INFO("MainWindow", QString("Exported startup profile to %1").arg(filePath));
 }
 
 void MainWindow::createMenu()
@@ -291,6 +378,10 @@ void MainWindow::createMenu()
                           "A comprehensive plugin framework for enterprise applications.");
     });
     m_helpMenu->addAction(aboutAction);
+    
+    QAction* exportProfileAction = new QAction("Export Startup &Profile...", this);
+    connect(exportProfileAction, &QAction::triggered, this, &MainWindow::exportStartupProfile);
+    m_helpMenu->addAction(exportProfileAction);
 }
 
 void MainWindow::createToolbar()
@@ -356,22 +447,26 @@ void MainWindow::createDockWidgets()
         if (state == PluginState::NotLoaded) {
             QAction* loadAction = contextMenu.addAction("Load");
             connect(loadAction, &QAction::triggered, [this, pluginId]() {
-                PluginManager::instance().loadPlugin(pluginId);
+                watchLifecycleOperation(PluginManager::instance().loadPluginAsync(pluginId),
+                                        QString("Failed to load plugin: %1").arg(pluginId));
             });
-        } else if (state == PluginState::Loaded || state == PluginState::Initialized) {
+        } else if (state == PluginState::Loaded || state == PluginState::Initialized || state == PluginState::Inactive) {
             QAction* activateAction = contextMenu.addAction("Activate");
             connect(activateAction, &QAction::triggered, [this, pluginId]() {
-                PluginManager::instance().activatePlugin(pluginId);
+                watchLifecycleOperation(PluginManager::instance().activatePluginAsync(pluginId),
+                                        QString("Failed to activate plugin: %1").arg(pluginId));
             });
             
             QAction* unloadAction = contextMenu.addAction("Unload");
             connect(unloadAction, &QAction::triggered, [this, pluginId]() {
-                PluginManager::instance().unloadPlugin(pluginId);
+                watchLifecycleOperation(PluginManager::instance().unloadPluginAsync(pluginId),
+                                        QString("Failed to unload plugin: %1").arg(pluginId));
             });
         } else if (state == PluginState::Active) {
             QAction* deactivateAction = contextMenu.addAction("Deactivate");
             connect(deactivateAction, &QAction::triggered, [this, pluginId]() {
-                PluginManager::instance().deactivatePlugin(pluginId);
+                watchLifecycleOperation(PluginManager::instance().deactivatePluginAsync(pluginId),
+                                        QString("Failed to deactivate plugin: %1").arg(pluginId));
             });
         }
         
@@ -413,6 +508,46 @@ void MainWindow::connectSignals()
             this, &MainWindow::onPluginDeactivated);
     connect(&PluginManager::instance(), &PluginManager::pluginFailed,
             this, &MainWindow::onPluginFailed);
+    connect(&PluginManager::instance(), &PluginManager::pluginProgress,
+            this, &MainWindow::onPluginProgress);
+    connect(&PluginManager::instance(), &PluginManager::pluginCommandsChanged,
+            this, &MainWindow::onPluginCommandsChanged);
+}
+
+void MainWindow::onPluginProgress(const QString& pluginId, PluginManager::LifecycleStage stage)
+{
+    m_statusLabel->setText(QString("%1: %2...").arg(pluginId, PluginManager::getLifecycleStageName(stage)));
+}
+
+void MainWindow::watchLifecycleOperation(const QFuture<bool>& future, const QString& errorMessage)
+{
+    QFutureWatcher<bool>* watcher = new QFutureWatcher<bool>(this);
+    
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [this, watcher, errorMessage]() {
+        m_statusLabel->setText(watcher->result() ? "Ready" : errorMessage);
+        watcher->deleteLater();
+    });
+    
+    watcher->setFuture(future);
+}
+
+void MainWindow::reportStartupProfile()
+{
+    PluginProfiler& profiler = PluginProfiler::instance();
+    if (!profiler.isEnabled()) {
+        return;
+    }
+    
+    LOG_INFO("MainWindow", QString("Startup profile:\n%1").arg(profiler.summary()));
+    
+    // A relative trace path is resolved against the application directory
+    QString traceFile = ConfigManager::instance().getFrameworkValue("startupTraceFile").toString();
+    if (!traceFile.isEmpty()) {
+        traceFile = QDir(QApplication::applicationDirPath()).filePath(traceFile);
+        if (!profiler.writeChromeTrace(traceFile)) {
+            LOG_WARNING("MainWindow", QString("Failed to write startup trace to %1").arg(traceFile));
+        }
+    }
 }
 
 void MainWindow::addPluginToUI(IPlugin* plugin, const QString& pluginId)
@@ -450,28 +585,82 @@ void MainWindow::addPluginToUI(IPlugin* plugin, const QString& pluginId)
         connect(plugin, &IPlugin::eventOccurred,
                 this, &MainWindow::onPluginEventOccurred);
         
-        // Add plugin actions
-        QList<QAction*> actions;
+        addPluginActions(pluginId);
+    }
+}
+
+void MainWindow::addPluginActions(const QString& pluginId)
+{
+    QMenu* pluginMenu = m_pluginMenus.value(pluginId);
+    if (!pluginMenu) {
+        return;
+    }
+    
+    // Drop the actions of an earlier build of the menu
+    for (QAction* action : m_pluginActions.value(pluginId)) {
+        delete action;
+    }
+    
+    QList<QAction*> actions;
+    
+    // Commands that take no required parameters can be run from the menu
+    const QList<PluginCommandDescriptor> commands = PluginManager::instance().getPluginCommands(pluginId);
+    for (const PluginCommandDescriptor& descriptor : commands) {
+        if (descriptor.title.isEmpty()) {
+            continue;
+        }
+        
+        bool needsParameters = false;
+        for (const PluginCommandParameter& parameter : descriptor.parameters) {
+            needsParameters = needsParameters || parameter.required;
+        }
+        if (needsParameters) {
+            continue;
+        }
+        
+        QVariantMap data;
+        data["pluginId"] = pluginId;
+        data["commandId"] = descriptor.id;
+        data["command"] = descriptor.name;
+        
+        QAction* action = new QAction(descriptor.title, this);
+        action->setData(data);
+        connect(action, &QAction::triggered, this, &MainWindow::executePluginAction);
+        pluginMenu->addAction(action);
+        actions.append(action);
+    }
+    
+    // Plugins without descriptors, and lazy plugins whose library is not loaded yet,
+    // get the generic actions, which are dispatched by name
+    if (commands.isEmpty()) {
+        QVariantMap infoData;
+        infoData["pluginId"] = pluginId;
+        infoData["command"] = "showInfo";
         
-        // Example: Add a "Show Info" action
         QAction* infoAction = new QAction("Show Info", this);
-        infoAction->setData(QString("%1:showInfo").arg(pluginId));
+        infoAction->setData(infoData);
         connect(infoAction, &QAction::triggered, this, &MainWindow::executePluginAction);
         pluginMenu->addAction(infoAction);
         actions.append(infoAction);
         
-        // Example: Add a "Configure" action
+        QVariantMap configData;
+        configData["pluginId"] = pluginId;
+        configData["command"] = "configure";
+        
         QAction* configAction = new QAction("Configure...", this);
-        configAction->setData(QString("%1:configure").arg(pluginId));
+        configAction->setData(configData);
         connect(configAction, &QAction::triggered, this, &MainWindow::executePluginAction);
         pluginMenu->addAction(configAction);
         actions.append(configAction);
-        
-        // Add plugin-specific actions
-        // In a real implementation, these would be obtained from the plugin
-        
-        m_pluginActions[pluginId] = actions;
     }
+    
+    m_pluginActions[pluginId] = actions;
+}
+
+void MainWindow::onPluginCommandsChanged(const QString& pluginId)
+{
+    // Menus are only built for active plugins; others pick the commands up when activated
+    addPluginActions(pluginId);
 }
 
 void MainWindow::removePluginFromUI(const QString& pluginId)
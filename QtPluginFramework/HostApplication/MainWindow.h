@@ -16,8 +16,10 @@
 #include <QList>
 #include <QAction>
 #include <QVariant>
+#include <QFuture>
 
 #include "../PluginCore/IPlugin.h"
+#include "../PluginCore/PluginManager.h"
 
 class PluginManagerDialog;
 
@@ -95,6 +97,21 @@ public slots:
      */
     void onPluginFailed(const QString& pluginId, const QString& errorMessage);
 
+    /**
+     * @brief Show the progress of an asynchronous lifecycle operation
+     * 
+     * @param pluginId ID of the plugin
+     * @param stage Step the operation is entering
+     */
+    void onPluginProgress(const QString& pluginId, PluginManager::LifecycleStage stage);
+
+    /**
+     * @brief Rebuild a plugin's menu from the commands it published
+     * 
+     * @param pluginId ID of the plugin
+     */
+    void onPluginCommandsChanged(const QString& pluginId);
+
     /**
      * @brief Handle plugin status change
      * 
@@ -115,6 +132,11 @@ public slots:
      */
     void executePluginAction();
 
+    /**
+     * @brief Ask for a file name and export the recorded profile as a Chrome trace
+     */
+    void exportStartupProfile();
+
 private:
     /**
      * @brief Create the main menu
@@ -146,6 +168,21 @@ private:
      */
     void connectSignals();
 
+    /**
+     * @brief Report the outcome of an asynchronous lifecycle operation in the status bar
+     * 
+     * @param future Future returned by the asynchronous PluginManager call
+     * @param errorMessage Message shown if the operation fails
+     */
+    void watchLifecycleOperation(const QFuture<bool>& future, const QString& errorMessage);
+
+    /**
+     * @brief Log the startup profile summary and write the configured trace file
+     * 
+     * Runs from the event loop once initialize() has returned, so its span is complete.
+     */
+    void reportStartupProfile();
+
     /**
      * @brief Add plugin to the UI
      * 
@@ -161,6 +198,16 @@ private:
      */
     void removePluginFromUI(const QString& pluginId);
 
+    /**
+     * @brief Fill a plugin's menu with its actions
+     * 
+     * Plugins that publish command descriptors get one action per titled command;
+     * other plugins get the generic Show Info and Configure actions.
+     * 
+     * @param pluginId ID of the plugin
+     */
+    void addPluginActions(const QString& pluginId);
+
     /**
      * @brief Update plugin in the UI
      * 
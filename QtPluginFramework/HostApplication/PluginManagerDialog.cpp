@@ -1,6 +1,8 @@
 #include "PluginManagerDialog.h"
 #include "../PluginCore/PluginManager.h"
 #include "../PluginCore/LogManager.h"
+#include "../PluginCore/PluginMetrics.h"
+#include "../PluginCore/PluginCommunication.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -10,9 +12,10 @@
 #include <QApplication>
 #include <QDir>
 #include <QFile>
+#include <QFutureWatcher>
 
 PluginManagerDialog::PluginManagerDialog(QWidget *parent)
-    : QDialog(parent)
+    : QDialog(parent), m_busy(false)
 {
     setWindowTitle("Plugin Manager");
     setMinimumSize(800, 600);
@@ -20,8 +23,12 @@ PluginManagerDialog::PluginManagerDialog(QWidget *parent)
     // Create layout
     QVBoxLayout* mainLayout = new QVBoxLayout(this);
     
+    m_tabWidget = new QTabWidget(this);
+    QWidget* pluginsTab = new QWidget(m_tabWidget);
+    QVBoxLayout* pluginsLayout = new QVBoxLayout(pluginsTab);
+    
     // Create plugin table
-    m_pluginTable = new QTableWidget(0, 5, this);
+    m_pluginTable = new QTableWidget(0, 5, pluginsTab);
     m_pluginTable->setHorizontalHeaderLabels(QStringList() << "ID" << "Name" << "Version" << "Vendor" << "Status");
     m_pluginTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
     m_pluginTable->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
@@ -36,10 +43,10 @@ PluginManagerDialog::PluginManagerDialog(QWidget *parent)
     connect(m_pluginTable, &QTableWidget::itemSelectionChanged,
             this, &PluginManagerDialog::onPluginSelectionChanged);
     
-    mainLayout->addWidget(m_pluginTable);
+    pluginsLayout->addWidget(m_pluginTable);
     
     // Create details group
-    m_detailsGroup = new QGroupBox("Plugin Details", this);
+    m_detailsGroup = new QGroupBox("Plugin Details", pluginsTab);
     QVBoxLayout* detailsLayout = new QVBoxLayout(m_detailsGroup);
     
     m_detailsText = new QTextEdit(m_detailsGroup);
@@ -47,7 +54,27 @@ PluginManagerDialog::PluginManagerDialog(QWidget *parent)
     
     detailsLayout->addWidget(m_detailsText);
     
-    mainLayout->addWidget(m_detailsGroup);
+    pluginsLayout->addWidget(m_detailsGroup);
+    
+    m_tabWidget->addTab(pluginsTab, "Plugins");
+    m_tabWidget->addTab(createPerformanceTab(), "Performance");
+    
+    // Refresh the metrics only while they are visible
+    m_metricsTimer = new QTimer(this);
+    m_metricsTimer->setInterval(1000);
+    connect(m_metricsTimer, &QTimer::timeout, this, &PluginManagerDialog::refreshMetrics);
+    connect(m_tabWidget, &QTabWidget::currentChanged, this, &PluginManagerDialog::onTabChanged);
+    
+    mainLayout->addWidget(m_tabWidget);
+    
+    // Create progress label for asynchronous operations
+    m_progressLabel = new QLabel(this);
+    mainLayout->addWidget(m_progressLabel);
+    
+    connect(&PluginManager::instance(), &PluginManager::pluginProgress, this,
+            [this](const QString& pluginId, PluginManager::LifecycleStage stage) {
+        m_progressLabel->setText(QString("%1: %2...").arg(pluginId, PluginManager::getLifecycleStageName(stage)));
+    });
     
     // Create buttons
     QHBoxLayout* buttonLayout = new QHBoxLayout();
@@ -155,11 +182,8 @@ void PluginManagerDialog::loadPlugin()
     int row = selectedItems.first()->row();
     QString pluginId = m_pluginTable->item(row, 0)->text();
     
-    if (PluginManager::instance().loadPlugin(pluginId)) {
-        refresh();
-    } else {
-        QMessageBox::warning(this, "Error", QString("Failed to load plugin: %1").arg(pluginId));
-    }
+    runLifecycleOperation(PluginManager::instance().loadPluginAsync(pluginId),
+                          QString("Failed to load plugin: %1").arg(pluginId));
 }
 
 void PluginManagerDialog::unloadPlugin()
@@ -172,11 +196,8 @@ void PluginManagerDialog::unloadPlugin()
     int row = selectedItems.first()->row();
     QString pluginId = m_pluginTable->item(row, 0)->text();
     
-    if (PluginManager::instance().unloadPlugin(pluginId)) {
-        refresh();
-    } else {
-        QMessageBox::warning(this, "Error", QString("Failed to unload plugin: %1").arg(pluginId));
-    }
+    runLifecycleOperation(PluginManager::instance().unloadPluginAsync(pluginId),
+                          QString("Failed to unload plugin: %1").arg(pluginId));
 }
 
 void PluginManagerDialog::activatePlugin()
@@ -189,11 +210,8 @@ void PluginManagerDialog::activatePlugin()
     int row = selectedItems.first()->row();
     QString pluginId = m_pluginTable->item(row, 0)->text();
     
-    if (PluginManager::instance().activatePlugin(pluginId)) {
-        refresh();
-    } else {
-        QMessageBox::warning(this, "Error", QString("Failed to activate plugin: %1").arg(pluginId));
-    }
+    runLifecycleOperation(PluginManager::instance().activatePluginAsync(pluginId),
+                          QString("Failed to activate plugin: %1").arg(pluginId));
 }
 
 void PluginManagerDialog::deactivatePlugin()
@@ -206,11 +224,8 @@ void PluginManagerDialog::deactivatePlugin()
     int row = selectedItems.first()->row();
     QString pluginId = m_pluginTable->item(row, 0)->text();
     
-    if (PluginManager::instance().deactivatePlugin(pluginId)) {
-        refresh();
-    } else {
-        QMessageBox::warning(this, "Error", QString("Failed to deactivate plugin: %1").arg(pluginId));
-    }
+    runLifecycleOperation(PluginManager::instance().deactivatePluginAsync(pluginId),
+                          QString("Failed to deactivate plugin: %1").arg(pluginId));
 }
 
 void PluginManagerDialog::showPluginDetails()
@@ -296,6 +311,104 @@ void PluginManagerDialog::browseForPlugins()
     refresh();
 }
 
+QWidget* PluginManagerDialog::createPerformanceTab()
+{
+    QWidget* performanceTab = new QWidget(m_tabWidget);
+    QVBoxLayout* performanceLayout = new QVBoxLayout(performanceTab);
+    
+    m_performanceTable = new QTableWidget(0, 17, performanceTab);
+    m_performanceTable->setHorizontalHeaderLabels(QStringList()
+        << "Plugin" << "Commands" << "Failed" << "Mean ms" << "p95 ms" << "Max ms" << "CPU ms"
+        << "Messages" << "Mean ms" << "p95 ms" << "CPU ms" << "Queued" << "Queue p95 ms"
+        << "Initialize ms" << "Activate ms" << "Deactivate ms" << "Shutdown ms");
+    m_performanceTable->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    m_performanceTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_performanceTable->verticalHeader()->setVisible(false);
+    m_performanceTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_performanceTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_performanceTable->setToolTip("Latencies are wall-clock time; CPU is the time the calling thread spent computing. "
+                                   "Lifecycle columns show the last call, with its CPU time in the tooltip.");
+    
+    performanceLayout->addWidget(m_performanceTable);
+    
+    QHBoxLayout* metricsButtonLayout = new QHBoxLayout();
+    
+    QPushButton* refreshButton = new QPushButton("Refresh", performanceTab);
+    QPushButton* resetButton = new QPushButton("Reset", performanceTab);
+    
+    connect(refreshButton, &QPushButton::clicked, this, &PluginManagerDialog::refreshMetrics);
+    connect(resetButton, &QPushButton::clicked, this, &PluginManagerDialog::resetMetrics);
+    
+    metricsButtonLayout->addStretch();
+    metricsButtonLayout->addWidget(refreshButton);
+    metricsButtonLayout->addWidget(resetButton);
+    
+    performanceLayout->addLayout(metricsButtonLayout);
+    
+    return performanceTab;
+}
+
+void PluginManagerDialog::refreshMetrics()
+{
+    auto milliseconds = [](qint64 ns) {
+        return new QTableWidgetItem(QString::number(ns / 1e6, 'f', 3));
+    };
+    
+    const QList<PluginMetricsSnapshot> allMetrics = PluginMetrics::instance().allMetrics();
+    
+    m_performanceTable->setRowCount(allMetrics.size());
+    
+    int row = 0;
+    for (const PluginMetricsSnapshot& metrics : allMetrics) {
+        m_performanceTable->setItem(row, 0, new QTableWidgetItem(metrics.pluginId));
+        m_performanceTable->setItem(row, 1, new QTableWidgetItem(QString::number(metrics.commands.count)));
+        m_performanceTable->setItem(row, 2, new QTableWidgetItem(QString::number(metrics.commands.failures)));
+        m_performanceTable->setItem(row, 3, milliseconds(metrics.commands.meanNs()));
+        m_performanceTable->setItem(row, 4, milliseconds(metrics.commands.percentileNs(95)));
+        m_performanceTable->setItem(row, 5, milliseconds(metrics.commands.maxNs));
+        m_performanceTable->setItem(row, 6, milliseconds(metrics.commands.cpuNs));
+        m_performanceTable->setItem(row, 7, new QTableWidgetItem(QString::number(metrics.messages.count)));
+        m_performanceTable->setItem(row, 8, milliseconds(metrics.messages.meanNs()));
+        m_performanceTable->setItem(row, 9, milliseconds(metrics.messages.percentileNs(95)));
+        m_performanceTable->setItem(row, 10, milliseconds(metrics.messages.cpuNs));
+        
+        MailboxStatistics mailbox = PluginCommunication::instance().getMailboxStatistics(metrics.pluginId);
+        QTableWidgetItem* queuedItem = new QTableWidgetItem(QString::number(mailbox.depth));
+        queuedItem->setToolTip(QString("Capacity %1, peak %2, posted %3, dropped %4, rejected %5")
+                                   .arg(mailbox.capacity).arg(mailbox.maxDepth).arg(mailbox.posted)
+                                   .arg(mailbox.dropped).arg(mailbox.rejected));
+        m_performanceTable->setItem(row, 11, queuedItem);
+        m_performanceTable->setItem(row, 12, milliseconds(metrics.mailboxWait.percentileNs(95)));
+        
+        for (int phase = 0; phase < PluginMetricsSnapshot::LifecyclePhaseCount; ++phase) {
+            QTableWidgetItem* item = metrics.lifecycleNs[phase] >= 0 ? milliseconds(metrics.lifecycleNs[phase])
+                                                                      : new QTableWidgetItem("-");
+            if (metrics.lifecycleNs[phase] >= 0) {
+                item->setToolTip(QString("CPU: %1 ms").arg(metrics.lifecycleCpuNs[phase] / 1e6, 0, 'f', 3));
+            }
+            m_performanceTable->setItem(row, 13 + phase, item);
+        }
+        
+        ++row;
+    }
+}
+
+void PluginManagerDialog::resetMetrics()
+{
+    PluginMetrics::instance().clear();
+    refreshMetrics();
+}
+
+void PluginManagerDialog::onTabChanged(int index)
+{
+    if (m_tabWidget->widget(index) == m_performanceTable->parentWidget()) {
+        refreshMetrics();
+        m_metricsTimer->start();
+    } else {
+        m_metricsTimer->stop();
+    }
+}
+
 void PluginManagerDialog::updateButtonStates()
 {
     QList<QTableWidgetItem*> selectedItems = m_pluginTable->selectedItems();
@@ -306,8 +419,9 @@ void PluginManagerDialog::updateButtonStates()
     m_activateButton->setEnabled(false);
     m_deactivateButton->setEnabled(false);
     m_detailsButton->setEnabled(false);
+    m_browseButton->setEnabled(!m_busy);
     
-    if (hasSelection) {
+    if (hasSelection && !m_busy) {
         int row = selectedItems.first()->row();
         QString pluginId = m_pluginTable->item(row, 0)->text();
         PluginState state = PluginManager::instance().getPluginState(pluginId);
@@ -337,4 +451,27 @@ void PluginManagerDialog::updateButtonStates()
                 break;
         }
     }
+}
+
+void PluginManagerDialog::runLifecycleOperation(const QFuture<bool>& future, const QString& errorMessage)
+{
+    m_busy = true;
+    updateButtonStates();
+    
+    QFutureWatcher<bool>* watcher = new QFutureWatcher<bool>(this);
+    
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [this, watcher, errorMessage]() {
+        bool success = watcher->result();
+        watcher->deleteLater();
+        
+        m_busy = false;
+        m_progressLabel->clear();
+        refresh();
+        
+        if (!success) {
+            QMessageBox::warning(this, "Error", errorMessage);
+        }
+    });
+    
+    watcher->setFuture(future);
 }
\ No newline at end of file
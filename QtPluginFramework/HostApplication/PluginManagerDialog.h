@@ -7,6 +7,9 @@
 #include <QLabel>
 #include <QGroupBox>
 #include <QTextEdit>
+#include <QTabWidget>
+#include <QTimer>
+#include <QFuture>
 
 /**
  * @brief The PluginManagerDialog class provides a dialog for managing plugins.
@@ -69,13 +72,51 @@ private slots:
      */
     void browseForPlugins();
 
+    /**
+     * @brief Refresh the performance table from PluginMetrics
+     */
+    void refreshMetrics();
+
+    /**
+     * @brief Discard the recorded metrics
+     */
+    void resetMetrics();
+
+    /**
+     * @brief Start or stop refreshing the performance table when the current tab changes
+     * 
+     * @param index Index of the current tab
+     */
+    void onTabChanged(int index);
+
 private:
     /**
      * @brief Update button states based on selected plugin
      */
     void updateButtonStates();
 
+    /**
+     * @brief Track an asynchronous lifecycle operation on a plugin
+     * 
+     * The buttons stay disabled until the operation finishes. The list is then
+     * refreshed, or an error is shown if the operation failed.
+     * 
+     * @param future Future returned by the asynchronous PluginManager call
+     * @param errorMessage Message shown if the operation fails
+     */
+    void runLifecycleOperation(const QFuture<bool>& future, const QString& errorMessage);
+
+    /**
+     * @brief Create the tab showing per-plugin metrics
+     * 
+     * @return Tab widget
+     */
+    QWidget* createPerformanceTab();
+
+    QTabWidget* m_tabWidget;
     QTableWidget* m_pluginTable;
+    QTableWidget* m_performanceTable;
+    QTimer* m_metricsTimer;
     
     QPushButton* m_loadButton;
     QPushButton* m_unloadButton;
@@ -87,6 +128,9 @@ private:
     
     QGroupBox* m_detailsGroup;
     QTextEdit* m_detailsText;
+    QLabel* m_progressLabel;
+    
+    bool m_busy;
 };
 
 #endif // PLUGINMANAGERDIALOG_H
\ No newline at end of file
@@ -1,5 +1,6 @@
 ﻿#include "ConfigManager.h"
 #include "LogManager.h"
+#include "DocumentCodec.h"
 
 #include <QRecursiveMutexLocker>
 
@@ -63,23 +64,23 @@ bool ConfigManager::loadFrameworkConfig(const QString& configFile)
         return false;
     }
 
-    QFile file(configFile);
+    QString filePath = existingConfigFile(configFile);
+
+    QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly)) {
-        LOG_WARNING("ConfigManager", QString("Failed to open framework config file: %1").arg(configFile));
+        LOG_WARNING("ConfigManager", QString("Failed to open framework config file: %1").arg(filePath));
         return false;
     }
 
     QByteArray jsonData = file.readAll();
     file.close();
 
-    QJsonDocument doc = QJsonDocument::fromJson(jsonData);
-    if (doc.isNull() || !doc.isObject()) {
-        LOG_ERROR("ConfigManager", QString("Invalid JSON in framework config file: %1").arg(configFile));
+    QJsonObject jsonObj;
+    if (!DocumentCodec::decode(jsonData, jsonObj)) {
+        LOG_ERROR("ConfigManager", QString("Invalid JSON or CBOR in framework config file: %1").arg(filePath));
         return false;
     }
 
-    QJsonObject jsonObj = doc.object();
-
     // Clear existing framework config
     m_frameworkConfig.clear();
 
@@ -109,12 +110,13 @@ bool ConfigManager::saveFrameworkConfig(const QString& configFile)
         jsonObj.insert(it.key(), variantToJsonValue(it.value()));
     }
 
-    QJsonDocument doc(jsonObj);
-    QByteArray jsonData = doc.toJson(QJsonDocument::Indented);
+    // An existing file keeps its format, so a converted config stays binary
+    QString filePath = existingConfigFile(configFile);
+    QByteArray jsonData = DocumentCodec::encode(jsonObj, DocumentCodec::formatForFile(filePath));
 
-    QFile file(configFile);
+    QFile file(filePath);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        LOG_ERROR("ConfigManager", QString("Failed to open framework config file for writing: %1").arg(configFile));
+        LOG_ERROR("ConfigManager", QString("Failed to open framework config file for writing: %1").arg(filePath));
         return false;
     }
 
@@ -122,11 +124,11 @@ bool ConfigManager::saveFrameworkConfig(const QString& configFile)
     file.close();
 
     if (bytesWritten != jsonData.size()) {
-        LOG_ERROR("ConfigManager", QString("Failed to write all data to framework config file: %1").arg(configFile));
+        LOG_ERROR("ConfigManager", QString("Failed to write all data to framework config file: %1").arg(filePath));
         return false;
     }
 
-    LOG_INFO("ConfigManager", QString("Saved framework config to: %1").arg(configFile));
+    LOG_INFO("ConfigManager", QString("Saved framework config to: %1").arg(filePath));
 
     return true;
 }
@@ -140,23 +142,23 @@ bool ConfigManager::loadPluginConfig(const QString& pluginId, const QString& con
         return false;
     }
 
-    QFile file(configFile);
+    QString filePath = existingConfigFile(configFile);
+
+    QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly)) {
-        LOG_WARNING("ConfigManager", QString("Failed to open plugin config file: %1").arg(configFile));
+        LOG_WARNING("ConfigManager", QString("Failed to open plugin config file: %1").arg(filePath));
         return false;
     }
 
     QByteArray jsonData = file.readAll();
     file.close();
 
-    QJsonDocument doc = QJsonDocument::fromJson(jsonData);
-    if (doc.isNull() || !doc.isObject()) {
-        LOG_ERROR("ConfigManager", QString("Invalid JSON in plugin config file: %1").arg(configFile));
+    QJsonObject jsonObj;
+    if (!DocumentCodec::decode(jsonData, jsonObj)) {
+        LOG_ERROR("ConfigManager", QString("Invalid JSON or CBOR in plugin config file: %1").arg(filePath));
         return false;
     }
 
-    QJsonObject jsonObj = doc.object();
-
     // Clear existing plugin config
     m_pluginConfigs[pluginId].clear();
 
@@ -192,12 +194,12 @@ bool ConfigManager::savePluginConfig(const QString& pluginId, const QString& con
         jsonObj.insert(it.key(), variantToJsonValue(it.value()));
     }
 
-    QJsonDocument doc(jsonObj);
-    QByteArray jsonData = doc.toJson(QJsonDocument::Indented);
+    QString filePath = existingConfigFile(configFile);
+    QByteArray jsonData = DocumentCodec::encode(jsonObj, DocumentCodec::formatForFile(filePath));
 
-    QFile file(configFile);
+    QFile file(filePath);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        LOG_ERROR("ConfigManager", QString("Failed to open plugin config file for writing: %1").arg(configFile));
+        LOG_ERROR("ConfigManager", QString("Failed to open plugin config file for writing: %1").arg(filePath));
         return false;
     }
 
@@ -205,11 +207,11 @@ bool ConfigManager::savePluginConfig(const QString& pluginId, const QString& con
     file.close();
 
     if (bytesWritten != jsonData.size()) {
-        LOG_ERROR("ConfigManager", QString("Failed to write all data to plugin config file: %1").arg(configFile));
+        LOG_ERROR("ConfigManager", QString("Failed to write all data to plugin config file: %1").arg(filePath));
         return false;
     }
 
-    LOG_INFO("ConfigManager", QString("Saved config for plugin %1 to: %2").arg(pluginId, configFile));
+    LOG_INFO("ConfigManager", QString("Saved config for plugin %1 to: %2").arg(pluginId, filePath));
 
     return true;
 }
@@ -475,3 +477,17 @@ QVariant ConfigManager::jsonValueToVariant(const QJsonValue& value) const
         return QVariant();
     }
 }
+
+QString ConfigManager::existingConfigFile(const QString& configFile) const
+{
+    if (QFile::exists(configFile)) {
+        return configFile;
+    }
+
+    // A config converted to the other format replaces the file it was converted from
+    QFileInfo fileInfo(configFile);
+    QString otherSuffix = fileInfo.suffix().compare("cbor", Qt::CaseInsensitive) == 0 ? "json" : "cbor";
+    QString otherFile = fileInfo.dir().filePath(fileInfo.completeBaseName() + "." + otherSuffix);
+
+    return QFile::exists(otherFile) ? otherFile : configFile;
+}
@@ -10,6 +10,7 @@
 #include <QJsonValue>
 #include <QJsonArray>
 #include <QFile>
+#include <QFileInfo>
 #include <QDir>
 #include <QMutex>
 #include <QRecursiveMutex>
@@ -49,6 +50,8 @@ public:
     /**
      * @brief Load framework configuration
      * 
+     * The file may be JSON or CBOR; the format is detected from its contents.
+     * 
      * @param configFile Path to the framework configuration file
      * @return True if loading was successful, false otherwise
      */
@@ -57,6 +60,9 @@ public:
     /**
      * @brief Save framework configuration
      * 
+     * An existing file is written in its current format, a new one as CBOR if its
+     * suffix is ".cbor" and as JSON otherwise.
+     * 
      * @param configFile Path to the framework configuration file
      * @return True if saving was successful, false otherwise
      */
@@ -225,6 +231,17 @@ private:
      */
     QVariant jsonValueToVariant(const QJsonValue& value) const;
 
+    /**
+     * @brief Get the file a config is stored in
+     * 
+     * A config may have been converted between JSON and CBOR, so if the file does not
+     * exist, a file with the same base name and the other suffix is used instead.
+     * 
+     * @param configFile Path to the config file
+     * @return Path to the existing file, or configFile if neither exists
+     */
+    QString existingConfigFile(const QString& configFile) const;
+
     QString m_configDir;
     QMap<QString, QVariant> m_frameworkConfig;
     QMap<QString, QMap<QString, QVariant>> m_pluginConfigs;
@@ -0,0 +1,82 @@
+#include "DocumentCodec.h"
+
+#include <QCborMap>
+#include <QCborValue>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+
+bool DocumentCodec::isCbor(const QByteArray& data)
+{
+    if (data.isEmpty()) {
+        return false;
+    }
+
+    // Self-describe tag 55799
+    if (data.startsWith("\xd9\xd9\xf7")) {
+        return true;
+    }
+
+    // A map of major type 5; these bytes cannot start JSON text, not even as UTF-8
+    quint8 first = quint8(data.at(0));
+    return first >= 0xa0 && first <= 0xbf;
+}
+
+bool DocumentCodec::decode(const QByteArray& data, QJsonObject& object, Format* format)
+{
+    if (isCbor(data)) {
+        QCborParserError parseError;
+        QCborValue value = QCborValue::fromCbor(data, &parseError);
+        if (parseError.error != QCborError::NoError) {
+            return false;
+        }
+
+        if (value.isTag() && value.tag() == QCborTag(QCborKnownTags::Signature)) {
+            value = value.taggedValue();
+        }
+
+        if (!value.isMap()) {
+            return false;
+        }
+
+        object = value.toMap().toJsonObject();
+        if (format) {
+            *format = Format::Cbor;
+        }
+        return true;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        return false;
+    }
+
+    object = doc.object();
+    if (format) {
+        *format = Format::Json;
+    }
+    return true;
+}
+
+QByteArray DocumentCodec::encode(const QJsonObject& object, Format format)
+{
+    if (format == Format::Cbor) {
+        return QCborValue(QCborKnownTags::Signature, QCborMap::fromJsonObject(object)).toCbor();
+    }
+
+    return QJsonDocument(object).toJson(QJsonDocument::Indented);
+}
+
+DocumentCodec::Format DocumentCodec::formatForFile(const QString& filePath)
+{
+    QFile file(filePath);
+    if (file.open(QIODevice::ReadOnly)) {
+        QByteArray header = file.read(3);
+        if (!header.isEmpty()) {
+            return isCbor(header) ? Format::Cbor : Format::Json;
+        }
+    }
+
+    return QFileInfo(filePath).suffix().compare("cbor", Qt::CaseInsensitive) == 0 ? Format::Cbor : Format::Json;
+}
\ No newline at end of file
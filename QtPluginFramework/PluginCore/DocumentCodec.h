@@ -0,0 +1,65 @@
+#ifndef DOCUMENTCODEC_H
+#define DOCUMENTCODEC_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+/**
+ * @brief The DocumentCodec class reads and writes metadata and configuration documents.
+ *
+ * A document is a JSON object stored either as JSON text or as CBOR. CBOR files are
+ * written with the self-describe tag (bytes D9 D9 F7), so the format is recognized from
+ * the first bytes of a file regardless of its name; an untagged CBOR map is recognized
+ * as well. CBOR documents are smaller and parse several times faster than indented JSON.
+ */
+class DocumentCodec
+{
+public:
+    /**
+     * @brief Encodings of a document
+     */
+    enum class Format {
+        Json,
+        Cbor
+    };
+
+    /**
+     * @brief Check if data starts like a CBOR document
+     *
+     * @param data Contents of a file, or at least its first three bytes
+     * @return True if the data is CBOR, false if it should be parsed as JSON
+     */
+    static bool isCbor(const QByteArray& data);
+
+    /**
+     * @brief Decode a document in either format
+     *
+     * @param data Contents of the file
+     * @param object Receives the decoded object
+     * @param format Receives the format the data was in
+     * @return True if the data holds an object, false otherwise
+     */
+    static bool decode(const QByteArray& data, QJsonObject& object, Format* format = nullptr);
+
+    /**
+     * @brief Encode a document
+     *
+     * @param object Object to encode
+     * @param format Format to encode in
+     * @return Encoded document, indented if it is JSON
+     */
+    static QByteArray encode(const QJsonObject& object, Format format);
+
+    /**
+     * @brief Get the format a file should be written in
+     *
+     * An existing file keeps its format; a new file is CBOR if its suffix is ".cbor".
+     *
+     * @param filePath Path to the file
+     * @return Format of the file
+     */
+    static Format formatForFile(const QString& filePath);
+};
+
+#endif // DOCUMENTCODEC_H
\ No newline at end of file
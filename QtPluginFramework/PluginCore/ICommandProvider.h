@@ -0,0 +1,78 @@
+#ifndef ICOMMANDPROVIDER_H
+#define ICOMMANDPROVIDER_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QVariant>
+#include <QVariantMap>
+#include <QMetaType>
+
+/**
+ * @brief One parameter of a plugin command
+ */
+struct PluginCommandParameter {
+    QString name;                                   ///< Key of the parameter in the params map
+    QMetaType::Type type = QMetaType::QString;      ///< Expected type; values of other types must convert to it
+    bool required = false;                          ///< True if the command fails without it
+};
+
+/**
+ * @brief Description of a command published by a plugin
+ */
+struct PluginCommandDescriptor {
+    int id = -1;                                    ///< Numeric ID, small and unique within the plugin
+    QString name;                                   ///< Name accepted by IPlugin::executeCommand()
+    QString title;                                  ///< Menu text, or empty to keep the command out of menus
+    QList<PluginCommandParameter> parameters;       ///< Parameter schema
+    bool blocking = false;                          ///< True if the command waits for the user or for long-running work
+    bool idempotent = false;                        ///< True if running the command twice has the same effect as once
+    bool interactive = false;                       ///< True if the command shows dialogs, which keeps the plugin on the application thread
+};
+
+/**
+ * @brief The ICommandProvider class is an optional extension for plugins that publish their commands.
+ *
+ * PluginManager reads the descriptors once, when the plugin instance is loaded, and keeps
+ * them in a table indexed by command ID. Commands addressed by ID are checked against the
+ * table and dispatched through invokeCommand() without comparing command names, and the
+ * host builds the plugin's menu from the descriptors. IPlugin::executeCommand() remains
+ * the entry point for callers that address commands by name.
+ *
+ * Plugins opt in by implementing this interface next to IPlugin and listing it in
+ * Q_INTERFACES.
+ */
+class ICommandProvider
+{
+public:
+    /**
+     * @brief Destructor
+     */
+    virtual ~ICommandProvider() {}
+
+    /**
+     * @brief Get the commands of the plugin
+     *
+     * Called before the plugin is initialized, possibly from another thread than the
+     * plugin's own, so the descriptors must not depend on the plugin's state.
+     *
+     * @return Descriptors of all commands
+     */
+    virtual QList<PluginCommandDescriptor> commandDescriptors() const = 0;
+
+    /**
+     * @brief Execute a command by ID
+     *
+     * @param commandId ID of a published command
+     * @param params Parameters for the command, with all required parameters present and
+     *               every parameter convertible to its declared type
+     * @return Result of the command execution
+     */
+    virtual QVariant invokeCommand(int commandId, const QVariantMap& params) = 0;
+};
+
+// Define the interface ID for Qt's plugin system
+#define CommandProviderInterface_iid "com.enterprise.plugin.ICommandProvider"
+Q_DECLARE_INTERFACE(ICommandProvider, CommandProviderInterface_iid)
+
+#endif // ICOMMANDPROVIDER_H
\ No newline at end of file
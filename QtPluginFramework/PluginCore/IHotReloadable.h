@@ -0,0 +1,48 @@
+#ifndef IHOTRELOADABLE_H
+#define IHOTRELOADABLE_H
+
+#include <QObject>
+#include <QVariant>
+
+/**
+ * @brief The IHotReloadable class is an optional extension for plugins that survive a hot reload.
+ * 
+ * When PluginManager replaces a plugin's library at runtime, it asks the old instance
+ * for its state before shutting it down and hands that state to the new instance after
+ * initializing it and before activating it. Plugins opt in by implementing this interface
+ * next to IPlugin and listing it in Q_INTERFACES.
+ */
+class IHotReloadable
+{
+public:
+    /**
+     * @brief Destructor
+     */
+    virtual ~IHotReloadable() {}
+
+    /**
+     * @brief Capture the state to hand over to the new instance
+     * 
+     * Called on the old instance after it has been deactivated.
+     * 
+     * @return Opaque state, or an invalid QVariant if there is nothing to hand over
+     */
+    virtual QVariant saveReloadState() = 0;
+
+    /**
+     * @brief Take over the state of the previous instance
+     * 
+     * Called on the new instance after initialize() and before activate(). The state
+     * may come from an older build of the plugin, so it should be validated.
+     * 
+     * @param state State returned by saveReloadState() of the old instance
+     * @return True if the state was accepted, false otherwise
+     */
+    virtual bool restoreReloadState(const QVariant& state) = 0;
+};
+
+// Define the interface ID for Qt's plugin system
+#define HotReloadableInterface_iid "com.enterprise.plugin.IHotReloadable"
+Q_DECLARE_INTERFACE(IHotReloadable, HotReloadableInterface_iid)
+
+#endif // IHOTRELOADABLE_H
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "LazyPluginProxy.h"
+#include "PluginManager.h"
+#include "LogManager.h"
+
+LazyPluginProxy::LazyPluginProxy(const PluginMetadata& metadata)
+    : m_metadata(metadata)
+{
+}
+
+LazyPluginProxy::~LazyPluginProxy()
+{
+}
+
+bool LazyPluginProxy::initialize()
+{
+    // Without the real plugin there is nothing to initialize yet; PluginManager
+    // replays the call once the library is loaded
+    return m_target ? m_target->initialize() : true;
+}
+
+bool LazyPluginProxy::activate()
+{
+    return m_target ? m_target->activate() : true;
+}
+
+bool LazyPluginProxy::deactivate()
+{
+    return m_target ? m_target->deactivate() : true;
+}
+
+bool LazyPluginProxy::shutdown()
+{
+    return m_target ? m_target->shutdown() : true;
+}
+
+QString LazyPluginProxy::getPluginId() const
+{
+    return m_metadata.getPluginId();
+}
+
+QString LazyPluginProxy::getPluginName() const
+{
+    return m_metadata.getPluginName();
+}
+
+QString LazyPluginProxy::getPluginVersion() const
+{
+    return m_metadata.getPluginVersion();
+}
+
+QString LazyPluginProxy::getPluginVendor() const
+{
+    return m_metadata.getPluginVendor();
+}
+
+QString LazyPluginProxy::getPluginDescription() const
+{
+    return m_metadata.getPluginDescription();
+}
+
+QStringList LazyPluginProxy::getPluginDependencies() const
+{
+    return m_metadata.getPluginDependencies();
+}
+
+QJsonObject LazyPluginProxy::getPluginMetadata() const
+{
+    return m_metadata.getMetadataJson();
+}
+
+QVariant LazyPluginProxy::executeCommand(const QString& command, const QVariantMap& params)
+{
+    if (!m_target && !PluginManager::instance().realizePlugin(getPluginId())) {
+        LOG_ERROR("LazyPluginProxy", QString("Failed to load plugin %1 for command %2").arg(getPluginId(), command));
+        return QVariant();
+    }
+
+    return m_target->executeCommand(command, params);
+}
+
+bool LazyPluginProxy::isRealized() const
+{
+    return !m_target.isNull();
+}
+
+IPlugin* LazyPluginProxy::target() const
+{
+    return m_target;
+}
+
+void LazyPluginProxy::setTarget(IPlugin* target)
+{
+    if (m_target) {
+        disconnect(m_target.data(), nullptr, this, nullptr);
+    }
+
+    m_target = target;
+
+    if (m_target) {
+        connect(m_target.data(), &IPlugin::statusChanged, this, &IPlugin::statusChanged);
+        connect(m_target.data(), &IPlugin::eventOccurred, this, &IPlugin::eventOccurred);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#ifndef LAZYPLUGINPROXY_H
+#define LAZYPLUGINPROXY_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVariantMap>
+#include <QJsonObject>
+#include <QPointer>
+
+#include "IPlugin.h"
+#include "PluginMetadata.h"
+
+/**
+ * @brief The LazyPluginProxy class stands in for a plugin whose library has not been loaded yet.
+ *
+ * The proxy answers metadata queries from the plugin's PluginMetadata and only records
+ * lifecycle calls. The first command sent to it makes PluginManager load the real library,
+ * replay the recorded lifecycle calls on the real instance and attach it to the proxy.
+ * From then on every call is forwarded to the real plugin.
+ */
+class LazyPluginProxy : public IPlugin
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param metadata Metadata of the plugin the proxy stands in for
+     */
+    explicit LazyPluginProxy(const PluginMetadata& metadata);
+
+    /**
+     * @brief Destructor
+     */
+    ~LazyPluginProxy();
+
+    // IPlugin interface
+    bool initialize() override;
+    bool activate() override;
+    bool deactivate() override;
+    bool shutdown() override;
+
+    QString getPluginId() const override;
+    QString getPluginName() const override;
+    QString getPluginVersion() const override;
+    QString getPluginVendor() const override;
+    QString getPluginDescription() const override;
+    QStringList getPluginDependencies() const override;
+    QJsonObject getPluginMetadata() const override;
+
+    QVariant executeCommand(const QString& command, const QVariantMap& params = QVariantMap()) override;
+
+    /**
+     * @brief Check if the real plugin has been loaded
+     *
+     * @return True if calls are forwarded to the real plugin, false otherwise
+     */
+    bool isRealized() const;
+
+    /**
+     * @brief Get the real plugin instance
+     *
+     * @return Pointer to the real plugin, or nullptr if it has not been loaded
+     */
+    IPlugin* target() const;
+
+    /**
+     * @brief Attach or detach the real plugin instance
+     *
+     * The real plugin's signals are forwarded through the proxy.
+     *
+     * @param target The real plugin, or nullptr to detach it
+     */
+    void setTarget(IPlugin* target);
+
+private:
+    PluginMetadata m_metadata;
+    QPointer<IPlugin> m_target;
+};
+
+#endif // LAZYPLUGINPROXY_H
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "LifecycleMutex.h"
+
+#include <QMetaObject>
+#include <QMutexLocker>
+
+LifecycleMutex::LifecycleMutex()
+    : m_owner(nullptr), m_depth(0)
+{
+}
+
+void LifecycleMutex::lock()
+{
+    QThread* self = QThread::currentThread();
+    QMutexLocker locker(&m_guard);
+
+    while (m_owner && m_owner != self) {
+        // The owner may be waiting for a call on this thread
+        QSharedPointer<LifecycleCall> call = takeCall();
+        if (call) {
+            locker.unlock();
+            run(call);
+            locker.relock();
+        } else {
+            m_changed.wait(&m_guard);
+        }
+    }
+
+    m_owner = self;
+    ++m_depth;
+}
+
+void LifecycleMutex::unlock()
+{
+    QMutexLocker locker(&m_guard);
+
+    if (--m_depth == 0) {
+        m_owner = nullptr;
+        m_changed.wakeAll();
+    }
+}
+
+QSharedPointer<LifecycleCall> LifecycleMutex::post(QObject* context, const std::function<void()>& function, bool lend)
+{
+    QSharedPointer<LifecycleCall> call(new LifecycleCall);
+    call->m_function = function;
+    call->m_thread = context->thread();
+
+    {
+        QMutexLocker locker(&m_guard);
+        if (lend && m_owner == QThread::currentThread()) {
+            call->m_lender = m_owner;
+        }
+        m_calls.append(call);
+        m_changed.wakeAll();
+    }
+
+    // A thread idling in its event loop picks the call up from there
+    QMetaObject::invokeMethod(context, [this, call]() {
+        run(call);
+    }, Qt::QueuedConnection);
+
+    return call;
+}
+
+bool LifecycleMutex::wait(const QSharedPointer<LifecycleCall>& call, QDeadlineTimer deadline)
+{
+    QMutexLocker locker(&m_guard);
+
+    while (!call->isFinished()) {
+        QSharedPointer<LifecycleCall> served = takeCall();
+        if (served) {
+            locker.unlock();
+            run(served);
+            locker.relock();
+        } else if (!m_changed.wait(&m_guard, deadline) && !call->isFinished()) {
+            return false;
+        }
+    }
+
+    locker.unlock();
+
+    if (call->m_error) {
+        std::rethrow_exception(call->m_error);
+    }
+
+    return true;
+}
+
+void LifecycleMutex::serveCalls()
+{
+    QMutexLocker locker(&m_guard);
+
+    while (QSharedPointer<LifecycleCall> call = takeCall()) {
+        locker.unlock();
+        run(call);
+        locker.relock();
+    }
+}
+
+void LifecycleMutex::run(const QSharedPointer<LifecycleCall>& call)
+{
+    // Posted calls are queued twice, so whichever copy comes first runs it
+    if (!call->m_state.testAndSetAcquire(LifecycleCall::Pending, LifecycleCall::Running)) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_guard);
+        m_calls.removeOne(call);
+
+        // The lender does nothing but wait for the call, which therefore acts as the owner
+        if (call->m_lender) {
+            m_owner = QThread::currentThread();
+        }
+    }
+
+    try {
+        call->m_function();
+    } catch (...) {
+        call->m_error = std::current_exception();
+    }
+
+    QMutexLocker locker(&m_guard);
+
+    if (call->m_lender) {
+        m_owner = call->m_lender;
+    }
+    call->m_state.storeRelease(LifecycleCall::Finished);
+    m_changed.wakeAll();
+}
+
+QSharedPointer<LifecycleCall> LifecycleMutex::takeCall()
+{
+    QThread* self = QThread::currentThread();
+
+    for (int i = 0; i < m_calls.size(); ++i) {
+        if (m_calls[i]->m_thread == self) {
+            return m_calls.takeAt(i);
+        }
+    }
+
+    return QSharedPointer<LifecycleCall>();
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#ifndef LIFECYCLEMUTEX_H
+#define LIFECYCLEMUTEX_H
+
+#include <QAtomicInt>
+#include <QDeadlineTimer>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QThread>
+#include <QWaitCondition>
+#include <exception>
+#include <functional>
+
+/**
+ * @brief A function queued by LifecycleMutex::post() to run on another thread
+ */
+class LifecycleCall
+{
+public:
+    /**
+     * @brief Check if the call has run
+     *
+     * @return True if the function returned or threw, false otherwise
+     */
+    bool isFinished() const { return m_state.loadAcquire() == Finished; }
+
+private:
+    friend class LifecycleMutex;
+
+    enum State { Pending, Running, Finished };
+
+    std::function<void()> m_function;
+    QThread* m_thread = nullptr;        // Thread the call runs on
+    QThread* m_lender = nullptr;        // Owner of the lock while the call runs, if the poster held it
+    QAtomicInt m_state;
+    std::exception_ptr m_error;
+};
+
+/**
+ * @brief The LifecycleMutex class is a recursive mutex whose owner can have calls run on
+ * other threads without giving it up.
+ *
+ * It works with QMutexLocker like QRecursiveMutex. The owner posts a call to the thread a
+ * plugin lives in and waits for it; the call runs as the owner, so it may lock the mutex
+ * again, while the waiting owner is inactive until it returns. A thread blocked in lock() or
+ * wait() runs the calls posted to it meanwhile, so a thread waiting for the lock never keeps
+ * its owner waiting in turn, and no nesting level of the lock is ever released early.
+ */
+class LifecycleMutex
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    LifecycleMutex();
+
+    /**
+     * @brief Lock the mutex, running calls posted to this thread while it waits
+     */
+    void lock();
+
+    /**
+     * @brief Unlock the mutex once
+     */
+    void unlock();
+
+    /**
+     * @brief Queue a call on the thread a context object lives in
+     *
+     * The call runs when that thread returns to its event loop or waits in lock() or wait(),
+     * whichever comes first.
+     *
+     * @param context Object whose thread runs the call
+     * @param function Function to run
+     * @param lend True to let the call run as the owner if the calling thread holds the mutex;
+     *             the caller must then wait for it with wait() and no deadline
+     * @return Handle to wait for
+     */
+    QSharedPointer<LifecycleCall> post(QObject* context, const std::function<void()>& function, bool lend = true);
+
+    /**
+     * @brief Wait for a posted call, running calls posted to this thread meanwhile
+     *
+     * Exceptions thrown by the call are rethrown on the calling thread.
+     *
+     * @param call Call returned by post()
+     * @param deadline Time at which to give up waiting
+     * @return True if the call finished, false on timeout
+     */
+    bool wait(const QSharedPointer<LifecycleCall>& call, QDeadlineTimer deadline = QDeadlineTimer(QDeadlineTimer::Forever));
+
+    /**
+     * @brief Run the calls currently posted to this thread
+     */
+    void serveCalls();
+
+private:
+    Q_DISABLE_COPY(LifecycleMutex)
+
+    void run(const QSharedPointer<LifecycleCall>& call);
+    QSharedPointer<LifecycleCall> takeCall();
+
+    QMutex m_guard;
+    QWaitCondition m_changed;           // Lock released, call posted or call finished
+    QThread* m_owner;
+    int m_depth;
+    QList<QSharedPointer<LifecycleCall>> m_calls;   // Posted calls that have not started
+};
+
+#endif // LIFECYCLEMUTEX_H
\ No newline at end of file
@@ -157,16 +157,14 @@ bool PermissionManager::grantPermission(const QString& pluginId, const QString&
         return false;
     }
 
-    if (!m_pluginPermissions.contains(pluginId)) {
-        m_pluginPermissions.insert(pluginId, QSet<QString>());
-    }
+    QSet<QString>& permissions = m_pluginPermissions[PluginHandle::fromId(pluginId)];
 
-    if (m_pluginPermissions[pluginId].contains(permission)) {
+    if (permissions.contains(permission)) {
         LOG_WARNING("PermissionManager", QString("Plugin %1 already has permission: %2").arg(pluginId, permission));
         return true;
     }
 
-    m_pluginPermissions[pluginId].insert(permission);
+    permissions.insert(permission);
 
     LOG_INFO("PermissionManager", QString("Granted permission %1 to plugin %2").arg(permission, pluginId));
 
@@ -184,17 +182,18 @@ bool PermissionManager::revokePermission(const QString& pluginId, const QString&
         return false;
     }
 
-    if (!m_pluginPermissions.contains(pluginId)) {
+    auto it = m_pluginPermissions.find(PluginHandle::find(pluginId));
+    if (it == m_pluginPermissions.end()) {
         LOG_WARNING("PermissionManager", QString("Plugin not registered: %1").arg(pluginId));
         return false;
     }
 
-    if (!m_pluginPermissions[pluginId].contains(permission)) {
+    if (!it.value().contains(permission)) {
         LOG_WARNING("PermissionManager", QString("Plugin %1 does not have permission: %2").arg(pluginId, permission));
         return false;
     }
 
-    m_pluginPermissions[pluginId].remove(permission);
+    it.value().remove(permission);
 
     LOG_INFO("PermissionManager", QString("Revoked permission %1 from plugin %2").arg(permission, pluginId));
 
@@ -204,6 +203,11 @@ bool PermissionManager::revokePermission(const QString& pluginId, const QString&
 }
 
 bool PermissionManager::hasPermission(const QString& pluginId, const QString& permission) const
+{
+    return hasPermission(PluginHandle::find(pluginId), permission);
+}
+
+bool PermissionManager::hasPermission(PluginHandle handle, const QString& permission) const
 {
     QRecursiveMutexLocker locker(&m_mutex);
 
@@ -212,11 +216,12 @@ bool PermissionManager::hasPermission(const QString& pluginId, const QString& pe
         return false;
     }
 
-    if (!m_pluginPermissions.contains(pluginId)) {
+    auto it = m_pluginPermissions.constFind(handle);
+    if (it == m_pluginPermissions.constEnd()) {
         return false;
     }
 
-    return m_pluginPermissions[pluginId].contains(permission);
+    return it.value().contains(permission);
 }
 
 QStringList PermissionManager::getPluginPermissions(const QString& pluginId) const
@@ -228,13 +233,14 @@ QStringList PermissionManager::getPluginPermissions(const QString& pluginId) con
         return QStringList();
     }
 
-    if (!m_pluginPermissions.contains(pluginId)) {
+    auto it = m_pluginPermissions.constFind(PluginHandle::find(pluginId));
+    if (it == m_pluginPermissions.constEnd()) {
         return QStringList();
     }
 
     // Convert QSet to QStringList manually
     QStringList result;
-    const QSet<QString>& permissions = m_pluginPermissions[pluginId];
+    const QSet<QString>& permissions = it.value();
     for (const QString& permission : permissions) {
         result.append(permission);
     }
@@ -252,11 +258,13 @@ QStringList PermissionManager::getPluginsWithPermission(const QString& permissio
 
     QStringList plugins;
 
-    for (auto it = m_pluginPermissions.begin(); it != m_pluginPermissions.end(); ++it) {
+    for (auto it = m_pluginPermissions.constBegin(); it != m_pluginPermissions.constEnd(); ++it) {
         if (it.value().contains(permission)) {
-            plugins.append(it.key());
+            plugins.append(it.key().pluginId());
         }
     }
 
+    plugins.sort();
+
     return plugins;
 }
@@ -6,9 +6,12 @@
 #include <QStringList>
 #include <QMap>
 #include <QSet>
+#include <QHash>
 #include <QMutex>
 #include <QRecursiveMutex>
 
+#include "PluginHandle.h"
+
 /**
  * @brief The PermissionManager class manages permissions for plugins.
  * 
@@ -106,6 +109,15 @@ public:
      */
     bool hasPermission(const QString& pluginId, const QString& permission) const;
 
+    /**
+     * @brief Check if a plugin has a permission
+     * 
+     * @param handle Handle of the plugin
+     * @param permission Permission to check
+     * @return True if the plugin has the permission, false otherwise
+     */
+    bool hasPermission(PluginHandle handle, const QString& permission) const;
+
     /**
      * @brief Get all permissions granted to a plugin
      * 
@@ -166,7 +178,7 @@ private:
     ~PermissionManager();
 
     QMap<QString, QString> m_permissions; // Permission -> Description
-    QMap<QString, QSet<QString>> m_pluginPermissions; // PluginId -> Set of permissions
+    QHash<PluginHandle, QSet<QString>> m_pluginPermissions; // Plugin -> Set of permissions
     mutable QRecursiveMutex m_mutex;
     bool m_initialized;
 };
@@ -1,11 +1,37 @@
 ﻿#include "PluginCommunication.h"
 #include "LogManager.h"
 #include "PermissionManager.h"
+#include "PluginManager.h"
+#include "PluginMetrics.h"
 
 #include <QRecursiveMutexLocker>
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <QMutexLocker>
+
+namespace {
+
+// Messages delivered from one mailbox before its drain task yields the pool thread
+const int MailboxDrainBatch = 64;
+
+// Mailbox whose handler is running on this thread, if any
+thread_local PluginMailbox* drainingMailbox = nullptr;
+
+// Every request gets a result, an invalid QVariant if it was not handled, so that
+// QFuture::result() is safe to call like the return value of sendMessage()
+void finishRequest(QFutureInterface<QVariant>& promise, const QVariant& response = QVariant())
+{
+    promise.reportResult(response);
+    promise.reportFinished();
+}
+
+} // namespace
 
 PluginCommunication::PluginCommunication()
-    : m_initialized(false)
+    : m_initialized(false),
+      m_defaultMailboxPolicy{1024, MailboxOverflowPolicy::Block},
+      m_mailboxBlockTimeout(1000),
+      m_mailboxesOpen(false)
 {
 }
 
@@ -31,6 +57,11 @@ bool PluginCommunication::initialize()
 
     m_initialized = true;
 
+    {
+        QMutexLocker mailboxLocker(&m_mailboxMutex);
+        m_mailboxesOpen = true;
+    }
+
     LOG_INFO("PluginCommunication", "Initialized");
 
     return true;
@@ -40,17 +71,108 @@ void PluginCommunication::shutdown()
 {
     QRecursiveMutexLocker locker(&m_mutex);
 
-    if (m_initialized) {
-        LOG_INFO("PluginCommunication", "Shutting down");
+    if (!m_initialized) {
+        return;
+    }
+
+    LOG_INFO("PluginCommunication", "Shutting down");
 
+    {
+        QWriteLocker handlerLocker(&m_handlerLock);
         m_handlers.clear();
+    }
+    m_subscribers.clear();
 
-        m_initialized = false;
+    m_initialized = false;
+
+    QHash<PluginHandle, QSharedPointer<PluginMailbox>> mailboxes;
+    {
+        QMutexLocker mailboxLocker(&m_mailboxMutex);
+        m_mailboxesOpen = false;
+        mailboxes.swap(m_mailboxes);
     }
+
+    // Running handlers may send messages, so wait for them without our lock
+    locker.unlock();
+
+    for (auto it = mailboxes.constBegin(); it != mailboxes.constEnd(); ++it) {
+        QList<PluginMailbox::Message> pending = it.value()->close();
+        for (PluginMailbox::Message& message : pending) {
+            if (message.hasPromise) {
+                finishRequest(message.promise);
+            }
+        }
+
+        if (!pending.isEmpty()) {
+            LOG_WARNING("PluginCommunication", QString("Discarded %1 undelivered messages to plugin %2").arg(pending.size()).arg(it.key().pluginId()));
+        }
+    }
+
+    m_mailboxPool.waitForDone();
 }
 
 QVariant PluginCommunication::sendMessage(const QString& sender, const QString& receiver, const QString& messageType, const QVariant& data)
 {
+    // A lazily loaded receiver registers its handlers once its library is loaded.
+    // Do this before taking our lock, PluginManager calls back into us while loading.
+    PluginManager& pluginManager = PluginManager::instance();
+    if (!pluginManager.isPluginRealized(receiver)) {
+        pluginManager.realizePlugin(receiver);
+    }
+    pluginManager.markPluginUsed(receiver);
+
+    QRecursiveMutexLocker locker(&m_mutex);
+
+    if (!m_initialized) {
+        LOG_ERROR("PluginCommunication", "Not initialized");
+        return QVariant();
+    }
+
+    return deliverMessage(sender, receiver, messageType, findHandler(PluginHandle::find(receiver), messageType), data);
+}
+
+PluginCommunication::Route PluginCommunication::resolveRoute(const QString& receiver, const QString& messageType)
+{
+    // Same as sendMessage, the handlers of a lazily loaded receiver only exist once it is loaded
+    PluginManager& pluginManager = PluginManager::instance();
+    if (!pluginManager.isPluginRealized(receiver)) {
+        pluginManager.realizePlugin(receiver);
+    }
+
+    QRecursiveMutexLocker locker(&m_mutex);
+
+    Route route;
+    route.m_receiver = receiver;
+    route.m_messageType = messageType;
+
+    if (!m_initialized) {
+        LOG_ERROR("PluginCommunication", "Not initialized");
+        return route;
+    }
+
+    route.m_handler = findHandler(PluginHandle::find(receiver), messageType);
+    if (!route.isValid()) {
+        LOG_WARNING("PluginCommunication", QString("No handler registered for message type %1 in plugin %2").arg(messageType, receiver));
+    }
+
+    return route;
+}
+
+QVariant PluginCommunication::sendMessage(const QString& sender, const Route& route, const QVariant& data)
+{
+    if (route.m_receiver.isEmpty()) {
+        LOG_ERROR("PluginCommunication", QString("Plugin %1 sent a message through an invalid route").arg(sender));
+        return QVariant();
+    }
+
+    // An expired route falls back to a lookup, which also reloads an unloaded receiver
+    QSharedPointer<MessageHandlerFunc> handler = route.m_handler.toStrongRef();
+    if (!handler) {
+        return sendMessage(sender, route.m_receiver, route.m_messageType, data);
+    }
+
+    PluginManager::instance().markPluginUsed(route.m_receiver);
+
     QRecursiveMutexLocker locker(&m_mutex);
 
     if (!m_initialized) {
@@ -58,6 +180,12 @@ QVariant PluginCommunication::sendMessage(const QString& sender, const QString&
         return QVariant();
     }
 
+    return deliverMessage(sender, route.m_receiver, route.m_messageType, handler, data);
+}
+
+QVariant PluginCommunication::deliverMessage(const QString& sender, const QString& receiver, const QString& messageType,
+                                             const QSharedPointer<MessageHandlerFunc>& handler, const QVariant& data)
+{
     // Check if sender has permission to send messages
     if (!PermissionManager::instance().hasPermission(sender, "communication.send")) {
         LOG_WARNING("PluginCommunication", QString("Plugin %1 does not have permission to send messages").arg(sender));
@@ -70,9 +198,7 @@ QVariant PluginCommunication::sendMessage(const QString& sender, const QString&
         return QVariant();
     }
 
-    QString handlerKey = QString("%1:%2").arg(receiver, messageType);
-
-    if (!m_handlers.contains(handlerKey)) {
+    if (!handler) {
         LOG_WARNING("PluginCommunication", QString("No handler registered for message type %1 in plugin %2").arg(messageType, receiver));
         return QVariant();
     }
@@ -81,13 +207,23 @@ QVariant PluginCommunication::sendMessage(const QString& sender, const QString&
 
     emit messageSent(sender, receiver, messageType, data);
 
-    QVariant response = m_handlers[handlerKey](sender, data);
+    QVariant response = callHandler(receiver, *handler, sender, data);
 
     emit messageReceived(receiver, sender, messageType, data, response);
 
     return response;
 }
 
+QSharedPointer<PluginCommunication::MessageHandlerFunc> PluginCommunication::findHandler(PluginHandle receiver, const QString& messageType) const
+{
+    auto plugin = m_handlers.constFind(receiver);
+    if (plugin == m_handlers.constEnd()) {
+        return QSharedPointer<MessageHandlerFunc>();
+    }
+
+    return plugin->value(messageType);
+}
+
 QMap<QString, QVariant> PluginCommunication::broadcastMessage(const QString& sender, const QString& messageType, const QVariant& data)
 {
     QRecursiveMutexLocker locker(&m_mutex);
@@ -105,34 +241,332 @@ QMap<QString, QVariant> PluginCommunication::broadcastMessage(const QString& sen
 
     QMap<QString, QVariant> responses;
 
-    // Find all handlers for this message type
-    QStringList handlerKeys = m_handlers.keys();
+    // Handlers may register or unregister handlers while being called, so iterate a copy
+    // of the subscribers and skip those whose handler is gone by the time they are reached
+    const QVector<PluginHandle> subscribers = m_subscribers.value(messageType);
 
     LOG_DEBUG("PluginCommunication", QString("Broadcasting message from %1: %2").arg(sender, messageType));
 
     emit messageBroadcast(sender, messageType, data);
 
-    for (const QString& handlerKey : handlerKeys) {
-        QStringList parts = handlerKey.split(':');
-        if (parts.size() == 2 && parts[1] == messageType) {
-            QString receiver = parts[0];
-
-            // Check if receiver has permission to receive messages
-            if (!PermissionManager::instance().hasPermission(receiver, "communication.receive")) {
-                LOG_WARNING("PluginCommunication", QString("Plugin %1 does not have permission to receive messages").arg(receiver));
-                continue;
-            }
+    for (PluginHandle subscriber : subscribers) {
+        QSharedPointer<MessageHandlerFunc> handler = findHandler(subscriber, messageType);
+        if (!handler) {
+            continue;
+        }
 
-            QVariant response = m_handlers[handlerKey](sender, data);
-            responses.insert(receiver, response);
+        QString receiver = subscriber.pluginId();
 
-            emit messageReceived(receiver, sender, messageType, data, response);
+        // Check if receiver has permission to receive messages
+        if (!PermissionManager::instance().hasPermission(receiver, "communication.receive")) {
+            LOG_WARNING("PluginCommunication", QString("Plugin %1 does not have permission to receive messages").arg(receiver));
+            continue;
         }
+
+        QVariant response = callHandler(receiver, *handler, sender, data);
+        responses.insert(receiver, response);
+
+        emit messageReceived(receiver, sender, messageType, data, response);
     }
 
     return responses;
 }
 
+bool PluginCommunication::postMessage(const QString& sender, const QString& receiver, const QString& messageType, const QVariant& data)
+{
+    return enqueueMessage(sender, receiver, messageType, data, nullptr);
+}
+
+QFuture<QVariant> PluginCommunication::requestAsync(const QString& sender, const QString& receiver, const QString& messageType, const QVariant& data)
+{
+    QFutureInterface<QVariant> promise;
+    promise.reportStarted();
+    QFuture<QVariant> future = promise.future();
+
+    if (!enqueueMessage(sender, receiver, messageType, data, &promise)) {
+        finishRequest(promise);
+    }
+
+    return future;
+}
+
+bool PluginCommunication::enqueueMessage(const QString& sender, const QString& receiver, const QString& messageType,
+                                         const QVariant& data, const QFutureInterface<QVariant>* promise)
+{
+    // The communication lock is not taken here, so posting never waits for a running handler
+    PluginHandle receiverHandle = PluginHandle::find(receiver);
+    if (!receiverHandle.isValid()) {
+        LOG_WARNING("PluginCommunication", QString("Cannot post message type %1 to unknown plugin %2").arg(messageType, receiver));
+        return false;
+    }
+
+    // Check if sender has permission to send messages
+    if (!PermissionManager::instance().hasPermission(sender, "communication.send")) {
+        LOG_WARNING("PluginCommunication", QString("Plugin %1 does not have permission to send messages").arg(sender));
+        return false;
+    }
+
+    // Check if receiver has permission to receive messages
+    if (!PermissionManager::instance().hasPermission(receiver, "communication.receive")) {
+        LOG_WARNING("PluginCommunication", QString("Plugin %1 does not have permission to receive messages").arg(receiver));
+        return false;
+    }
+
+    QSharedPointer<PluginMailbox> mailbox;
+    int blockTimeout = 0;
+    {
+        QMutexLocker mailboxLocker(&m_mailboxMutex);
+
+        if (!m_mailboxesOpen) {
+            LOG_ERROR("PluginCommunication", "Not initialized");
+            return false;
+        }
+
+        mailbox = findOrCreateMailbox(receiverHandle);
+
+        // Only the handler being posted to could make room in its own mailbox
+        blockTimeout = drainingMailbox == mailbox.data() ? 0 : m_mailboxBlockTimeout;
+    }
+
+    PluginMailbox::Message message;
+    message.sender = sender;
+    message.messageType = messageType;
+    message.data = data;
+    if (promise) {
+        message.promise = *promise;
+        message.hasPromise = true;
+    }
+
+    bool scheduleDrain = false;
+    QList<PluginMailbox::Message> dropped;
+    bool queued = mailbox->push(message, blockTimeout, &scheduleDrain, &dropped);
+
+    for (PluginMailbox::Message& droppedMessage : dropped) {
+        if (droppedMessage.hasPromise) {
+            finishRequest(droppedMessage.promise);
+        }
+    }
+
+    if (!dropped.isEmpty()) {
+        LOG_DEBUG("PluginCommunication", QString("Mailbox of plugin %1 full, dropped %2 oldest messages").arg(receiver).arg(dropped.size()));
+    }
+
+    if (!queued) {
+        LOG_WARNING("PluginCommunication", QString("Mailbox of plugin %1 full or closed, message type %2 from %3 rejected").arg(receiver, messageType, sender));
+        return false;
+    }
+
+    LOG_DEBUG("PluginCommunication", QString("Posting message from %1 to %2: %3").arg(sender, receiver, messageType));
+
+    emit messageSent(sender, receiver, messageType, data);
+
+    if (scheduleDrain) {
+        m_mailboxPool.start([this, receiverHandle, mailbox]() {
+            drainMailbox(receiverHandle, mailbox);
+        });
+    }
+
+    return true;
+}
+
+void PluginCommunication::drainMailbox(PluginHandle receiver, const QSharedPointer<PluginMailbox>& mailbox)
+{
+    for (int i = 0; i < MailboxDrainBatch; ++i) {
+        PluginMailbox::Message message;
+        if (!mailbox->takeNext(message)) {
+            return;
+        }
+
+        deliverPostedMessage(receiver, mailbox.data(), message);
+        mailbox->finishDelivery();
+    }
+
+    // Yield the pool thread so that a busy mailbox does not starve the others; the
+    // mailbox still counts as scheduled, so this stays its only drain task
+    m_mailboxPool.start([this, receiver, mailbox]() {
+        drainMailbox(receiver, mailbox);
+    });
+}
+
+void PluginCommunication::deliverPostedMessage(PluginHandle receiver, PluginMailbox* mailbox, PluginMailbox::Message& message)
+{
+    QString receiverId = receiver.pluginId();
+
+    if (PluginMetrics::instance().isEnabled()) {
+        PluginMetrics::instance().recordMailboxWait(receiverId, message.queuedTimer.nsecsElapsed());
+    }
+
+    // As for sendMessage, a lazily loaded or evicted receiver is loaded first
+    PluginManager& pluginManager = PluginManager::instance();
+    if (!pluginManager.isPluginRealized(receiverId)) {
+        pluginManager.realizePlugin(receiverId);
+    }
+    pluginManager.markPluginUsed(receiverId);
+
+    // The receiver is not torn down before the drain task reports the end of this delivery
+    bool delivered = false;
+    QVariant response;
+
+    QSharedPointer<MessageHandlerFunc> handler;
+    {
+        QReadLocker handlerLocker(&m_handlerLock);
+        handler = findHandler(receiver, message.messageType);
+    }
+
+    if (!handler) {
+        LOG_WARNING("PluginCommunication", QString("No handler registered for message type %1 in plugin %2").arg(message.messageType, receiverId));
+    } else {
+        drainingMailbox = mailbox;
+
+        try {
+            response = callHandler(receiverId, *handler, message.sender, message.data);
+            delivered = true;
+        } catch (const std::exception& ex) {
+            LOG_ERROR("PluginCommunication", QString("Exception in handler for message type %1 in plugin %2: %3")
+                      .arg(message.messageType, receiverId, ex.what()));
+        } catch (...) {
+            LOG_ERROR("PluginCommunication", QString("Unknown exception in handler for message type %1 in plugin %2")
+                      .arg(message.messageType, receiverId));
+        }
+
+        drainingMailbox = nullptr;
+    }
+
+    if (delivered) {
+        emit messageReceived(receiverId, message.sender, message.messageType, message.data, response);
+    }
+
+    if (message.hasPromise) {
+        finishRequest(message.promise, response);
+    }
+}
+
+void PluginCommunication::setDefaultMailboxPolicy(int capacity, MailboxOverflowPolicy policy)
+{
+    QMutexLocker locker(&m_mailboxMutex);
+
+    m_defaultMailboxPolicy = MailboxPolicy{qMax(1, capacity), policy};
+
+    for (auto it = m_mailboxes.constBegin(); it != m_mailboxes.constEnd(); ++it) {
+        if (!m_mailboxPolicies.contains(it.key())) {
+            it.value()->setPolicy(m_defaultMailboxPolicy.capacity, m_defaultMailboxPolicy.policy);
+        }
+    }
+}
+
+void PluginCommunication::setMailboxPolicy(const QString& pluginId, int capacity, MailboxOverflowPolicy policy)
+{
+    QMutexLocker locker(&m_mailboxMutex);
+
+    PluginHandle pluginHandle = PluginHandle::fromId(pluginId);
+    m_mailboxPolicies.insert(pluginHandle, MailboxPolicy{qMax(1, capacity), policy});
+
+    QSharedPointer<PluginMailbox> mailbox = m_mailboxes.value(pluginHandle);
+    if (mailbox) {
+        mailbox->setPolicy(qMax(1, capacity), policy);
+    }
+}
+
+void PluginCommunication::setMailboxBlockTimeout(int timeoutMs)
+{
+    QMutexLocker locker(&m_mailboxMutex);
+
+    m_mailboxBlockTimeout = timeoutMs < 0 ? -1 : timeoutMs;
+}
+
+int PluginCommunication::getMailboxBlockTimeout() const
+{
+    QMutexLocker locker(&m_mailboxMutex);
+
+    return m_mailboxBlockTimeout;
+}
+
+void PluginCommunication::setMailboxThreadCount(int threadCount)
+{
+    m_mailboxPool.setMaxThreadCount(qMax(1, threadCount));
+}
+
+MailboxStatistics PluginCommunication::getMailboxStatistics(const QString& pluginId) const
+{
+    QMutexLocker locker(&m_mailboxMutex);
+
+    QSharedPointer<PluginMailbox> mailbox = m_mailboxes.value(PluginHandle::find(pluginId));
+    return mailbox ? mailbox->statistics() : MailboxStatistics();
+}
+
+bool PluginCommunication::suspendMailbox(const QString& pluginId, QDeadlineTimer deadline)
+{
+    QSharedPointer<PluginMailbox> mailbox;
+    {
+        QMutexLocker mailboxLocker(&m_mailboxMutex);
+
+        if (!m_mailboxesOpen) {
+            return true;
+        }
+
+        // Created if missing, so that a message posted from now on is held as well
+        mailbox = findOrCreateMailbox(PluginHandle::fromId(pluginId));
+    }
+
+    // A handler suspending its own receiver's mailbox cannot wait for itself
+    if (drainingMailbox == mailbox.data()) {
+        mailbox->suspend(QDeadlineTimer(0));
+        return true;
+    }
+
+    return mailbox->suspend(deadline);
+}
+
+void PluginCommunication::resumeMailbox(const QString& pluginId)
+{
+    QSharedPointer<PluginMailbox> mailbox;
+    {
+        QMutexLocker mailboxLocker(&m_mailboxMutex);
+        mailbox = m_mailboxes.value(PluginHandle::find(pluginId));
+    }
+
+    if (mailbox && mailbox->resume()) {
+        PluginHandle receiver = PluginHandle::find(pluginId);
+        m_mailboxPool.start([this, receiver, mailbox]() {
+            drainMailbox(receiver, mailbox);
+        });
+    }
+}
+
+QSharedPointer<PluginMailbox> PluginCommunication::findOrCreateMailbox(PluginHandle receiver)
+{
+    QSharedPointer<PluginMailbox> mailbox = m_mailboxes.value(receiver);
+    if (!mailbox) {
+        MailboxPolicy policy = m_mailboxPolicies.value(receiver, m_defaultMailboxPolicy);
+        mailbox = QSharedPointer<PluginMailbox>::create(policy.capacity, policy.policy);
+        m_mailboxes.insert(receiver, mailbox);
+    }
+
+    return mailbox;
+}
+
+QVariant PluginCommunication::callHandler(const QString& receiver, const MessageHandlerFunc& handler,
+                                          const QString& sender, const QVariant& data)
+{
+    CallTimer timer;
+    QVariant response;
+
+    try {
+        response = handler(sender, data);
+    } catch (...) {
+        if (timer.isActive()) {
+            PluginMetrics::instance().recordMessage(receiver, timer.wallNs(), timer.cpuNs(), true);
+        }
+        throw;
+    }
+
+    if (timer.isActive()) {
+        PluginMetrics::instance().recordMessage(receiver, timer.wallNs(), timer.cpuNs(), false);
+    }
+
+    return response;
+}
+
 bool PluginCommunication::registerMessageHandler(const QString& pluginId, const QString& messageType, MessageHandlerFunc handler)
 {
     QRecursiveMutexLocker locker(&m_mutex);
@@ -142,14 +576,18 @@ bool PluginCommunication::registerMessageHandler(const QString& pluginId, const
         return false;
     }
 
-    QString handlerKey = QString("%1:%2").arg(pluginId, messageType);
+    PluginHandle pluginHandle = PluginHandle::fromId(pluginId);
 
-    if (m_handlers.contains(handlerKey)) {
+    if (findHandler(pluginHandle, messageType)) {
         LOG_WARNING("PluginCommunication", QString("Handler already registered for message type %1 in plugin %2").arg(messageType, pluginId));
         return false;
     }
 
-    m_handlers.insert(handlerKey, handler);
+    {
+        QWriteLocker handlerLocker(&m_handlerLock);
+        m_handlers[pluginHandle].insert(messageType, QSharedPointer<MessageHandlerFunc>::create(std::move(handler)));
+    }
+    m_subscribers[messageType].append(pluginHandle);
 
     LOG_INFO("PluginCommunication", QString("Registered handler for message type %1 in plugin %2").arg(messageType, pluginId));
 
@@ -165,14 +603,22 @@ bool PluginCommunication::unregisterMessageHandler(const QString& pluginId, cons
         return false;
     }
 
-    QString handlerKey = QString("%1:%2").arg(pluginId, messageType);
+    PluginHandle pluginHandle = PluginHandle::find(pluginId);
+    auto plugin = m_handlers.find(pluginHandle);
 
-    if (!m_handlers.contains(handlerKey)) {
+    if (plugin == m_handlers.end() || !plugin->contains(messageType)) {
         LOG_WARNING("PluginCommunication", QString("No handler registered for message type %1 in plugin %2").arg(messageType, pluginId));
         return false;
     }
 
-    m_handlers.remove(handlerKey);
+    {
+        QWriteLocker handlerLocker(&m_handlerLock);
+        plugin->remove(messageType);
+        if (plugin->isEmpty()) {
+            m_handlers.erase(plugin);
+        }
+    }
+    removeSubscriber(messageType, pluginHandle);
 
     LOG_INFO("PluginCommunication", QString("Unregistered handler for message type %1 in plugin %2").arg(messageType, pluginId));
 
@@ -188,20 +634,31 @@ bool PluginCommunication::unregisterAllMessageHandlers(const QString& pluginId)
         return false;
     }
 
-    QStringList keysToRemove;
-
-    for (auto it = m_handlers.begin(); it != m_handlers.end(); ++it) {
-        QStringList parts = it.key().split(':');
-        if (parts.size() == 2 && parts[0] == pluginId) {
-            keysToRemove.append(it.key());
-        }
+    PluginHandle pluginHandle = PluginHandle::find(pluginId);
+    QHash<QString, QSharedPointer<MessageHandlerFunc>> pluginHandlers;
+    {
+        QWriteLocker handlerLocker(&m_handlerLock);
+        pluginHandlers = m_handlers.take(pluginHandle);
     }
 
-    for (const QString& key : keysToRemove) {
-        m_handlers.remove(key);
+    for (auto it = pluginHandlers.constBegin(); it != pluginHandlers.constEnd(); ++it) {
+        removeSubscriber(it.key(), pluginHandle);
     }
 
     LOG_INFO("PluginCommunication", QString("Unregistered all handlers for plugin %1").arg(pluginId));
 
     return true;
 }
+
+void PluginCommunication::removeSubscriber(const QString& messageType, PluginHandle pluginHandle)
+{
+    auto subscribers = m_subscribers.find(messageType);
+    if (subscribers == m_subscribers.end()) {
+        return;
+    }
+
+    subscribers->removeOne(pluginHandle);
+    if (subscribers->isEmpty()) {
+        m_subscribers.erase(subscribers);
+    }
+}
@@ -5,10 +5,22 @@
 #include <QString>
 #include <QVariant>
 #include <QMap>
+#include <QHash>
+#include <QVector>
 #include <QMutex>
 #include <QRecursiveMutex>
+#include <QSharedPointer>
+#include <QWeakPointer>
+#include <QReadWriteLock>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QThreadPool>
+#include <QDeadlineTimer>
 #include <functional>
 
+#include "PluginHandle.h"
+#include "PluginMailbox.h"
+
 /**
  * @brief The PluginCommunication class provides a mechanism for inter-plugin communication.
  * 
@@ -24,6 +36,51 @@ public:
      * @brief Type definition for message handler function
      */
     using MessageHandlerFunc = std::function<QVariant(const QString&, const QVariant&)>;
+
+    /**
+     * @brief A pre-resolved destination for repeated messages to one handler
+     * 
+     * A route refers to the handler registered when it was resolved. Sending through it
+     * skips the handler lookup; if the handler has been unregistered since, for example
+     * because the receiver was unloaded, the message is delivered as by sendMessage()
+     * with the receiver ID and message type of the route.
+     */
+    class Route
+    {
+    public:
+        /**
+         * @brief Constructs an invalid route
+         */
+        Route() {}
+
+        /**
+         * @brief Check if the route still refers to a registered handler
+         * 
+         * @return True if the handler is registered, false otherwise
+         */
+        bool isValid() const { return !m_handler.isNull(); }
+
+        /**
+         * @brief Get the ID of the receiving plugin
+         * 
+         * @return ID of the receiver
+         */
+        QString receiver() const { return m_receiver; }
+
+        /**
+         * @brief Get the type of the messages sent through the route
+         * 
+         * @return Message type
+         */
+        QString messageType() const { return m_messageType; }
+
+    private:
+        friend class PluginCommunication;
+
+        QString m_receiver;
+        QString m_messageType;
+        QWeakPointer<MessageHandlerFunc> m_handler;
+    };
     
     /**
      * @brief Get the singleton instance of PluginCommunication
@@ -55,6 +112,29 @@ public:
      */
     QVariant sendMessage(const QString& sender, const QString& receiver, const QString& messageType, const QVariant& data = QVariant());
 
+    /**
+     * @brief Resolve the handler of a message type once for repeated sends
+     * 
+     * A lazily loaded receiver is loaded, so that its handlers are registered.
+     * 
+     * @param receiver ID of the receiving plugin
+     * @param messageType Type of the message
+     * @return Route to the handler, or an invalid route if no handler is registered
+     */
+    Route resolveRoute(const QString& receiver, const QString& messageType);
+
+    /**
+     * @brief Send a message through a resolved route
+     * 
+     * Permissions are checked as by the other overload.
+     * 
+     * @param sender ID of the sending plugin
+     * @param route Route returned by resolveRoute()
+     * @param data Data associated with the message
+     * @return Response from the receiver, or an invalid QVariant if no response
+     */
+    QVariant sendMessage(const QString& sender, const Route& route, const QVariant& data = QVariant());
+
     /**
      * @brief Broadcast a message to all plugins
      * 
@@ -65,6 +145,107 @@ public:
      */
     QMap<QString, QVariant> broadcastMessage(const QString& sender, const QString& messageType, const QVariant& data = QVariant());
 
+    /**
+     * @brief Queue a message to a specific plugin without waiting for it to be handled
+     * 
+     * The message goes into the receiver's mailbox and its handler runs later on the
+     * mailbox thread pool, without the communication lock held, so a slow handler holds
+     * up only its own mailbox. Messages posted to one receiver are handled in order.
+     * Permissions are checked when the message is posted, the handler is looked up
+     * when it is delivered.
+     * 
+     * @param sender ID of the sending plugin
+     * @param receiver ID of the receiving plugin
+     * @param messageType Type of the message
+     * @param data Data associated with the message
+     * @return True if the message was queued, false if it was not permitted or the mailbox is full
+     */
+    bool postMessage(const QString& sender, const QString& receiver, const QString& messageType, const QVariant& data = QVariant());
+
+    /**
+     * @brief Queue a message to a specific plugin and receive the response later
+     * 
+     * The message is delivered as by postMessage().
+     * 
+     * @param sender ID of the sending plugin
+     * @param receiver ID of the receiving plugin
+     * @param messageType Type of the message
+     * @param data Data associated with the message
+     * @return Future that receives the response; the response is an invalid QVariant if the
+     *         message is refused, dropped, has no handler or the handler throws
+     */
+    QFuture<QVariant> requestAsync(const QString& sender, const QString& receiver, const QString& messageType, const QVariant& data = QVariant());
+
+    /**
+     * @brief Set the capacity and overflow policy of mailboxes without a policy of their own
+     * 
+     * @param capacity Maximum number of queued messages per plugin
+     * @param policy What to do when a mailbox is full
+     */
+    void setDefaultMailboxPolicy(int capacity, MailboxOverflowPolicy policy);
+
+    /**
+     * @brief Set the capacity and overflow policy of the mailbox of one plugin
+     * 
+     * @param pluginId ID of the plugin
+     * @param capacity Maximum number of queued messages
+     * @param policy What to do when the mailbox is full
+     */
+    void setMailboxPolicy(const QString& pluginId, int capacity, MailboxOverflowPolicy policy);
+
+    /**
+     * @brief Set how long posting to a full mailbox with the Block policy waits for room
+     * 
+     * A handler posting to its own full mailbox never waits, since only it could make room.
+     * 
+     * @param timeoutMs Timeout in milliseconds, or -1 to wait indefinitely
+     */
+    void setMailboxBlockTimeout(int timeoutMs);
+
+    /**
+     * @brief Get how long posting to a full mailbox with the Block policy waits for room
+     * 
+     * @return Timeout in milliseconds, or -1 to wait indefinitely
+     */
+    int getMailboxBlockTimeout() const;
+
+    /**
+     * @brief Set the number of threads delivering posted messages
+     * 
+     * @param threadCount Maximum number of mailboxes drained at the same time
+     */
+    void setMailboxThreadCount(int threadCount);
+
+    /**
+     * @brief Get the counters of the mailbox of a plugin
+     * 
+     * The time messages waited in the mailbox is recorded in PluginMetrics.
+     * 
+     * @param pluginId ID of the plugin
+     * @return Copy of the counters, empty if nothing was posted to the plugin
+     */
+    MailboxStatistics getMailboxStatistics(const QString& pluginId) const;
+
+    /**
+     * @brief Stop delivering posted messages to a plugin
+     * 
+     * Messages posted meanwhile stay queued. Waits for a message the plugin is handling,
+     * unless called from that handler, so the caller must not hold a lock the handler may
+     * need. PluginManager suspends a plugin's mailbox before tearing the plugin down.
+     * 
+     * @param pluginId ID of the plugin
+     * @param deadline Time at which to give up waiting for the handler
+     * @return True if the plugin is not handling a posted message anymore, false on timeout
+     */
+    bool suspendMailbox(const QString& pluginId, QDeadlineTimer deadline = QDeadlineTimer(QDeadlineTimer::Forever));
+
+    /**
+     * @brief Deliver the messages queued for a plugin again after suspendMailbox()
+     * 
+     * @param pluginId ID of the plugin
+     */
+    void resumeMailbox(const QString& pluginId);
+
     /**
      * @brief Register a message handler for a plugin
      * 
@@ -134,10 +315,112 @@ private:
     // Destructor
     ~PluginCommunication();
 
-    // Key: pluginId:messageType
-    QMap<QString, MessageHandlerFunc> m_handlers;
+    /**
+     * @brief Call a message handler and record the call in PluginMetrics
+     * 
+     * @param receiver ID of the plugin owning the handler
+     * @param handler Handler to call
+     * @param sender ID of the sending plugin
+     * @param data Message data
+     * @return Response of the handler
+     */
+    QVariant callHandler(const QString& receiver, const MessageHandlerFunc& handler,
+                         const QString& sender, const QVariant& data);
+
+    /**
+     * @brief Check permissions and deliver a message to a handler
+     * 
+     * @param sender ID of the sending plugin
+     * @param receiver ID of the receiving plugin
+     * @param messageType Type of the message
+     * @param handler Handler of the receiver
+     * @param data Message data
+     * @return Response of the handler, or an invalid QVariant if delivery is not permitted
+     */
+    QVariant deliverMessage(const QString& sender, const QString& receiver, const QString& messageType,
+                            const QSharedPointer<MessageHandlerFunc>& handler, const QVariant& data);
+
+    /**
+     * @brief Find the handler of a message type in a plugin
+     * 
+     * @param receiver Handle of the receiving plugin
+     * @param messageType Type of the message
+     * @return The handler, or a null pointer if none is registered
+     */
+    QSharedPointer<MessageHandlerFunc> findHandler(PluginHandle receiver, const QString& messageType) const;
+
+    /**
+     * @brief Remove a plugin from the subscribers of a message type
+     * 
+     * @param messageType Type of the message
+     * @param pluginHandle Handle of the plugin
+     */
+    void removeSubscriber(const QString& messageType, PluginHandle pluginHandle);
+
+    /**
+     * @brief Check permissions and queue a message in the receiver's mailbox
+     * 
+     * @param sender ID of the sending plugin
+     * @param receiver ID of the receiving plugin
+     * @param messageType Type of the message
+     * @param data Message data
+     * @param promise Receives the response, or null for a message without response
+     * @return True if the message was queued, false otherwise
+     */
+    bool enqueueMessage(const QString& sender, const QString& receiver, const QString& messageType,
+                        const QVariant& data, const QFutureInterface<QVariant>* promise);
+
+    /**
+     * @brief Deliver queued messages of a mailbox, run on the mailbox thread pool
+     * 
+     * @param receiver Handle of the plugin owning the mailbox
+     * @param mailbox The mailbox
+     */
+    void drainMailbox(PluginHandle receiver, const QSharedPointer<PluginMailbox>& mailbox);
+
+    /**
+     * @brief Call the handler of a posted message and complete its promise
+     * 
+     * @param receiver Handle of the receiving plugin
+     * @param mailbox Mailbox the message was taken from
+     * @param message The message
+     */
+    void deliverPostedMessage(PluginHandle receiver, PluginMailbox* mailbox, PluginMailbox::Message& message);
+
+    /**
+     * @brief Get the mailbox of a plugin, creating it with the plugin's policy if missing
+     * 
+     * Must be called with m_mailboxMutex held.
+     * 
+     * @param receiver Handle of the plugin
+     * @return The mailbox
+     */
+    QSharedPointer<PluginMailbox> findOrCreateMailbox(PluginHandle receiver);
+
+    struct MailboxPolicy {
+        int capacity;
+        MailboxOverflowPolicy policy;
+    };
+
+    // Receiver -> message type -> handler. Handlers are shared so that a call in progress
+    // and resolved routes are not affected by the handler being unregistered.
+    QHash<PluginHandle, QHash<QString, QSharedPointer<MessageHandlerFunc>>> m_handlers;
+    // Message type -> plugins with a handler for it, in registration order
+    QHash<QString, QVector<PluginHandle>> m_subscribers;
     mutable QRecursiveMutex m_mutex;
+    // Lets drain tasks look handlers up while m_mutex is held by a synchronous send;
+    // writers of m_handlers hold both
+    mutable QReadWriteLock m_handlerLock;
     bool m_initialized;
+
+    // Posted messages. m_mailboxMutex guards these members, never a handler call.
+    mutable QMutex m_mailboxMutex;
+    QHash<PluginHandle, QSharedPointer<PluginMailbox>> m_mailboxes;
+    QHash<PluginHandle, MailboxPolicy> m_mailboxPolicies;
+    MailboxPolicy m_defaultMailboxPolicy;
+    int m_mailboxBlockTimeout;
+    bool m_mailboxesOpen;
+    QThreadPool m_mailboxPool;
 };
 
 #endif // PLUGINCOMMUNICATION_H
\ No newline at end of file
@@ -1,4 +1,4 @@
-QT += core gui widgets
+QT += core gui widgets concurrent
 
 TARGET = PluginCore
 TEMPLATE = lib
@@ -17,22 +17,52 @@ DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs depr
 
 SOURCES += \
     ConfigManager.cpp \
+    DocumentCodec.cpp \
     ExceptionHandler.cpp \
+    LazyPluginProxy.cpp \
+    LifecycleMutex.cpp \
     LogManager.cpp \
     PermissionManager.cpp \
     PluginCommunication.cpp \
+    PluginDependencyGraph.cpp \
+    PluginHandle.cpp \
+    PluginMailbox.cpp \
     PluginManager.cpp \
-    PluginMetadata.cpp
+    PluginMetadata.cpp \
+    PluginMetadataIndex.cpp \
+    PluginMetrics.cpp \
+    PluginProfiler.cpp \
+    PluginRegistry.cpp \
+    PluginStateTable.cpp \
+    PluginUsageHistory.cpp \
+    PluginVersionRange.cpp \
+    PluginVersionResolver.cpp
 
 HEADERS += \
     ConfigManager.h \
+    DocumentCodec.h \
     ExceptionHandler.h \
+    ICommandProvider.h \
+    IHotReloadable.h \
     IPlugin.h \
+    LazyPluginProxy.h \
+    LifecycleMutex.h \
     LogManager.h \
     PermissionManager.h \
     PluginCommunication.h \
+    PluginDependencyGraph.h \
+    PluginHandle.h \
+    PluginMailbox.h \
     PluginManager.h \
-    PluginMetadata.h
+    PluginMetadata.h \
+    PluginMetadataIndex.h \
+    PluginMetrics.h \
+    PluginProfiler.h \
+    PluginRegistry.h \
+    PluginStateTable.h \
+    PluginUsageHistory.h \
+    PluginVersionRange.h \
+    PluginVersionResolver.h
 
 unix {
     target.path = /usr/lib
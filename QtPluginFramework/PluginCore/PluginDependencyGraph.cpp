@@ -0,0 +1,294 @@
+#include "PluginDependencyGraph.h"
+
+#include <QPair>
+
+PluginDependencyGraph::PluginDependencyGraph()
+{
+}
+
+bool PluginDependencyGraph::setDependencies(const QString& pluginId, const QStringList& dependencies, QStringList* cycle)
+{
+    int index = intern(pluginId);
+
+    QVector<int> dependencyIndices;
+    for (const QString& depId : dependencies) {
+        int depIndex = intern(depId);
+        if (!dependencyIndices.contains(depIndex)) {
+            dependencyIndices.append(depIndex);
+        }
+    }
+
+    QStringList path = findCycle(index, dependencyIndices);
+    if (!path.isEmpty()) {
+        if (cycle) {
+            *cycle = path;
+        }
+        return false;
+    }
+
+    for (int depIndex : m_dependencies[index]) {
+        m_dependents[depIndex].removeOne(index);
+    }
+
+    for (int depIndex : dependencyIndices) {
+        m_dependents[depIndex].append(index);
+    }
+
+    m_dependencies[index] = dependencyIndices;
+    m_present[index] = true;
+
+    return true;
+}
+
+void PluginDependencyGraph::removePlugin(const QString& pluginId)
+{
+    int index = indexOf(pluginId);
+    if (index < 0) {
+        return;
+    }
+
+    for (int depIndex : m_dependencies[index]) {
+        m_dependents[depIndex].removeOne(index);
+    }
+
+    m_dependencies[index].clear();
+    m_present[index] = false;
+}
+
+void PluginDependencyGraph::clear()
+{
+    m_indices.clear();
+    m_pluginIds.clear();
+    m_present.clear();
+    m_dependencies.clear();
+    m_dependents.clear();
+}
+
+bool PluginDependencyGraph::contains(const QString& pluginId) const
+{
+    int index = indexOf(pluginId);
+
+    return index >= 0 && m_present[index];
+}
+
+QStringList PluginDependencyGraph::dependencies(const QString& pluginId) const
+{
+    QStringList result;
+
+    int index = indexOf(pluginId);
+    if (index >= 0) {
+        for (int depIndex : m_dependencies[index]) {
+            result.append(m_pluginIds[depIndex]);
+        }
+    }
+
+    return result;
+}
+
+QStringList PluginDependencyGraph::dependents(const QString& pluginId) const
+{
+    QStringList result;
+
+    int index = indexOf(pluginId);
+    if (index >= 0) {
+        for (int dependentIndex : m_dependents[index]) {
+            result.append(m_pluginIds[dependentIndex]);
+        }
+    }
+
+    return result;
+}
+
+bool PluginDependencyGraph::dependsOn(const QString& pluginId, const QString& dependencyId) const
+{
+    int index = indexOf(pluginId);
+    int depIndex = indexOf(dependencyId);
+
+    return index >= 0 && depIndex >= 0 && m_dependencies[index].contains(depIndex);
+}
+
+QStringList PluginDependencyGraph::transitiveDependencies(const QString& pluginId) const
+{
+    QStringList result;
+
+    int index = indexOf(pluginId);
+    if (index >= 0) {
+        QSet<int> visited;
+        visitPostOrder(index, m_dependencies, visited, result);
+        result.removeLast();
+    }
+
+    return result;
+}
+
+QStringList PluginDependencyGraph::transitiveDependents(const QString& pluginId) const
+{
+    QStringList result;
+
+    int index = indexOf(pluginId);
+    if (index >= 0) {
+        QSet<int> visited;
+        visitPostOrder(index, m_dependents, visited, result);
+        result.removeLast();
+    }
+
+    return result;
+}
+
+QStringList PluginDependencyGraph::loadOrder(const QStringList& pluginIds) const
+{
+    QStringList result;
+    QSet<int> visited;
+    QSet<QString> unknown;
+
+    for (const QString& pluginId : pluginIds) {
+        int index = indexOf(pluginId);
+        if (index >= 0) {
+            visitPostOrder(index, m_dependencies, visited, result);
+        } else if (!unknown.contains(pluginId)) {
+            unknown.insert(pluginId);
+            result.append(pluginId);
+        }
+    }
+
+    return result;
+}
+
+QStringList PluginDependencyGraph::unloadOrder(const QStringList& pluginIds) const
+{
+    QStringList result;
+    QSet<int> visited;
+    QSet<QString> unknown;
+
+    for (const QString& pluginId : pluginIds) {
+        int index = indexOf(pluginId);
+        if (index >= 0) {
+            visitPostOrder(index, m_dependents, visited, result);
+        } else if (!unknown.contains(pluginId)) {
+            unknown.insert(pluginId);
+            result.append(pluginId);
+        }
+    }
+
+    return result;
+}
+
+int PluginDependencyGraph::intern(const QString& pluginId)
+{
+    auto it = m_indices.constFind(pluginId);
+    if (it != m_indices.constEnd()) {
+        return it.value();
+    }
+
+    int index = m_pluginIds.size();
+    m_indices.insert(pluginId, index);
+    m_pluginIds.append(pluginId);
+    m_present.append(false);
+    m_dependencies.append(QVector<int>());
+    m_dependents.append(QVector<int>());
+
+    return index;
+}
+
+int PluginDependencyGraph::indexOf(const QString& pluginId) const
+{
+    return m_indices.value(pluginId, -1);
+}
+
+void PluginDependencyGraph::visitPostOrder(int root, const QVector<QVector<int>>& adjacency, QSet<int>& visited, QStringList& order) const
+{
+    if (visited.contains(root)) {
+        return;
+    }
+
+    // Iterative so that long dependency chains cannot overflow the stack
+    QVector<QPair<int, int>> stack;
+    stack.append(qMakePair(root, 0));
+    visited.insert(root);
+
+    while (!stack.isEmpty()) {
+        QPair<int, int>& top = stack.last();
+        const QVector<int>& edges = adjacency[top.first];
+
+        if (top.second < edges.size()) {
+            int next = edges[top.second++];
+            if (!visited.contains(next)) {
+                visited.insert(next);
+                stack.append(qMakePair(next, 0));
+            }
+        } else {
+            order.append(m_pluginIds[top.first]);
+            stack.removeLast();
+        }
+    }
+}
+
+QStringList PluginDependencyGraph::findCycle(int index, const QVector<int>& dependencyIndices) const
+{
+    // The new edges close a cycle if a plugin reachable from the dependencies depends on the
+    // plugin. One search runs forward from all dependencies at once and one backward from the
+    // plugin, taking a step each in turn, so the check stops as soon as the smaller side is
+    // exhausted; a plugin added before or after everything connected to it costs one step.
+    QHash<int, int> forward;        // Reached from a dependency, mapped to the node before it
+    QHash<int, int> backward;       // Reached from the plugin against the edges, mapped likewise
+    QVector<int> forwardStack;
+    QVector<int> backwardStack;
+    int meeting = -1;
+
+    backward.insert(index, -1);
+    backwardStack.append(index);
+
+    for (int depIndex : dependencyIndices) {
+        forward.insert(depIndex, -1);
+        forwardStack.append(depIndex);
+        if (depIndex == index) {
+            meeting = index;
+        }
+    }
+
+    while (meeting < 0 && !forwardStack.isEmpty() && !backwardStack.isEmpty()) {
+        int current = forwardStack.takeLast();
+        for (int next : m_dependencies[current]) {
+            if (!forward.contains(next)) {
+                forward.insert(next, current);
+                forwardStack.append(next);
+                if (backward.contains(next)) {
+                    meeting = next;
+                    break;
+                }
+            }
+        }
+
+        if (meeting >= 0) {
+            break;
+        }
+
+        current = backwardStack.takeLast();
+        for (int next : m_dependents[current]) {
+            if (!backward.contains(next)) {
+                backward.insert(next, current);
+                backwardStack.append(next);
+                if (forward.contains(next)) {
+                    meeting = next;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (meeting < 0) {
+        return QStringList();
+    }
+
+    // Dependency to meeting point, then on to the plugin
+    QStringList path;
+    for (int node = meeting; node >= 0; node = forward.value(node)) {
+        path.prepend(m_pluginIds[node]);
+    }
+    for (int node = backward.value(meeting); node >= 0; node = backward.value(node)) {
+        path.append(m_pluginIds[node]);
+    }
+    path.prepend(m_pluginIds[index]);
+
+    return path;
+}
\ No newline at end of file
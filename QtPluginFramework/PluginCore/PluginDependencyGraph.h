@@ -0,0 +1,163 @@
+#ifndef PLUGINDEPENDENCYGRAPH_H
+#define PLUGINDEPENDENCYGRAPH_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+/**
+ * @brief The PluginDependencyGraph class keeps the dependency relations between plugins.
+ *
+ * Plugin IDs are interned into dense indices, and the graph stores both the forward
+ * (plugin to dependency) and the reverse (dependency to dependent) adjacency lists.
+ * It is updated incrementally as metadata is registered, rejects dependency lists that
+ * would create a cycle with one search from both ends of the new edges, and answers traversal queries in time proportional to the size of the answer.
+ *
+ * Dependencies may name plugins whose metadata is not known yet. Such plugins take
+ * part in traversals but are not reported as dependents.
+ */
+class PluginDependencyGraph
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    PluginDependencyGraph();
+
+    /**
+     * @brief Add a plugin or replace its dependencies
+     *
+     * The graph is left unchanged if the dependencies would create a cycle.
+     *
+     * @param pluginId ID of the plugin
+     * @param dependencies IDs of the plugins it depends on
+     * @param cycle Receives the plugins forming the cycle, starting and ending with pluginId
+     * @return True if the plugin was added, false if it would create a cycle
+     */
+    bool setDependencies(const QString& pluginId, const QStringList& dependencies, QStringList* cycle = nullptr);
+
+    /**
+     * @brief Remove a plugin and its outgoing edges
+     *
+     * Edges from other plugins to it are kept, so it remains known as a dependency.
+     *
+     * @param pluginId ID of the plugin
+     */
+    void removePlugin(const QString& pluginId);
+
+    /**
+     * @brief Remove all plugins
+     */
+    void clear();
+
+    /**
+     * @brief Check if a plugin was added
+     *
+     * @param pluginId ID of the plugin
+     * @return True if the plugin was added, false otherwise
+     */
+    bool contains(const QString& pluginId) const;
+
+    /**
+     * @brief Get the direct dependencies of a plugin
+     *
+     * @param pluginId ID of the plugin
+     * @return IDs of the plugins it depends on
+     */
+    QStringList dependencies(const QString& pluginId) const;
+
+    /**
+     * @brief Get the plugins that directly depend on a plugin
+     *
+     * @param pluginId ID of the plugin
+     * @return IDs of the dependent plugins
+     */
+    QStringList dependents(const QString& pluginId) const;
+
+    /**
+     * @brief Check if a plugin directly depends on another
+     *
+     * @param pluginId ID of the plugin
+     * @param dependencyId ID of the possible dependency
+     * @return True if pluginId lists dependencyId as a dependency, false otherwise
+     */
+    bool dependsOn(const QString& pluginId, const QString& dependencyId) const;
+
+    /**
+     * @brief Get all plugins a plugin depends on, directly or indirectly
+     *
+     * @param pluginId ID of the plugin
+     * @return IDs of the dependencies, each dependency before the plugins that need it
+     */
+    QStringList transitiveDependencies(const QString& pluginId) const;
+
+    /**
+     * @brief Get all plugins that depend on a plugin, directly or indirectly
+     *
+     * @param pluginId ID of the plugin
+     * @return IDs of the dependents, each dependent before the plugins it needs
+     */
+    QStringList transitiveDependents(const QString& pluginId) const;
+
+    /**
+     * @brief Order plugins so that every plugin follows its dependencies
+     *
+     * Dependencies that are not in the list are included as well.
+     *
+     * @param pluginIds IDs of the plugins to order
+     * @return IDs in load order
+     */
+    QStringList loadOrder(const QStringList& pluginIds) const;
+
+    /**
+     * @brief Order plugins so that every plugin precedes its dependencies
+     *
+     * Dependents that are not in the list are included as well.
+     *
+     * @param pluginIds IDs of the plugins to order
+     * @return IDs in unload order
+     */
+    QStringList unloadOrder(const QStringList& pluginIds) const;
+
+private:
+    /**
+     * @brief Get the index of a plugin ID, adding it if it is new
+     */
+    int intern(const QString& pluginId);
+
+    /**
+     * @brief Get the index of a plugin ID
+     *
+     * @return Index of the plugin, or -1 if it is unknown
+     */
+    int indexOf(const QString& pluginId) const;
+
+    /**
+     * @brief Depth-first traversal appending nodes in post-order
+     *
+     * @param root Index to start from
+     * @param adjacency Adjacency lists to follow
+     * @param visited Nodes visited so far, updated by the traversal
+     * @param order Receives the IDs of newly visited nodes
+     */
+    void visitPostOrder(int root, const QVector<QVector<int>>& adjacency, QSet<int>& visited, QStringList& order) const;
+
+    /**
+     * @brief Check if giving a plugin new dependencies would create a cycle
+     *
+     * @param index Index of the plugin
+     * @param dependencyIndices Indices of its new dependencies
+     * @return IDs forming the cycle, starting and ending with the plugin, or an empty list if there is none
+     */
+    QStringList findCycle(int index, const QVector<int>& dependencyIndices) const;
+
+    QHash<QString, int> m_indices;
+    QVector<QString> m_pluginIds;
+    QVector<bool> m_present;               // False for plugins only known as a dependency
+    QVector<QVector<int>> m_dependencies;  // Forward edges
+    QVector<QVector<int>> m_dependents;    // Reverse edges
+};
+
+#endif // PLUGINDEPENDENCYGRAPH_H
\ No newline at end of file
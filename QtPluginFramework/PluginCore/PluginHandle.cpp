@@ -0,0 +1,167 @@
+#include "PluginHandle.h"
+
+#include <QAtomicPointer>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace {
+
+// Interned IDs are never changed or freed, so a reader holding one needs no lock
+struct HandleEntry {
+    QString pluginId;
+    size_t hash;
+    int value;
+};
+
+// Open addressing index from ID to entry, kept at most half full so probes are short and
+// always reach an empty slot. Writers fill empty slots in place and replace the index by a
+// larger one when it would get fuller; replaced indices stay alive for readers still probing.
+struct HandleIndex {
+    explicit HandleIndex(int capacity) : mask(capacity - 1), slots(new QAtomicPointer<const HandleEntry>[capacity]) {}
+    ~HandleIndex() { delete[] slots; }
+
+    int capacity() const { return mask + 1; }
+
+    const int mask;
+    QAtomicPointer<const HandleEntry>* const slots;
+};
+
+const int InitialIndexCapacity = 256;
+const int EntryChunkShift = 6;
+const int EntryChunkSize = 1 << EntryChunkShift;
+const int MaxEntryChunks = 1024;    // Room for 65536 plugin IDs, as in PluginStateTable
+
+struct EntryChunk {
+    QAtomicPointer<const HandleEntry> entries[EntryChunkSize];
+};
+
+struct HandleTable {
+    HandleTable() : index(new HandleIndex(InitialIndexCapacity)) {}
+
+    ~HandleTable()
+    {
+        for (int i = 0; i < MaxEntryChunks; ++i) {
+            EntryChunk* chunk = chunks[i].loadRelaxed();
+            if (!chunk) {
+                continue;
+            }
+            for (int j = 0; j < EntryChunkSize; ++j) {
+                delete chunk->entries[j].loadRelaxed();
+            }
+            delete chunk;
+        }
+        qDeleteAll(retiredIndices);
+        delete index.loadRelaxed();
+    }
+
+    QMutex writeMutex;                          // Serializes interning
+    QAtomicPointer<HandleIndex> index;
+    QAtomicPointer<EntryChunk> chunks[MaxEntryChunks];   // Entries by handle value
+    QList<HandleIndex*> retiredIndices;
+    int count = 0;
+};
+
+HandleTable& handleTable()
+{
+    static HandleTable table;
+    return table;
+}
+
+const HandleEntry* lookup(const HandleIndex* index, const QString& pluginId, size_t hash)
+{
+    for (int i = int(hash) & index->mask; ; i = (i + 1) & index->mask) {
+        const HandleEntry* entry = index->slots[i].loadAcquire();
+        if (!entry) {
+            return nullptr;
+        }
+        if (entry->hash == hash && entry->pluginId == pluginId) {
+            return entry;
+        }
+    }
+}
+
+void insert(HandleIndex* index, const HandleEntry* entry)
+{
+    int i = int(entry->hash) & index->mask;
+    while (index->slots[i].loadRelaxed()) {
+        i = (i + 1) & index->mask;
+    }
+    index->slots[i].storeRelease(entry);
+}
+
+} // namespace
+
+PluginHandle PluginHandle::fromId(const QString& pluginId)
+{
+    if (pluginId.isEmpty()) {
+        return PluginHandle();
+    }
+
+    HandleTable& table = handleTable();
+    size_t hash = qHash(pluginId);
+
+    if (const HandleEntry* entry = lookup(table.index.loadAcquire(), pluginId, hash)) {
+        return PluginHandle(entry->value);
+    }
+
+    QMutexLocker locker(&table.writeMutex);
+
+    // Another thread may have interned the ID before we got the lock
+    HandleIndex* index = table.index.loadRelaxed();
+    if (const HandleEntry* entry = lookup(index, pluginId, hash)) {
+        return PluginHandle(entry->value);
+    }
+
+    int value = table.count;
+    if ((value >> EntryChunkShift) >= MaxEntryChunks) {
+        qFatal("PluginHandle: more than %d plugin IDs interned", MaxEntryChunks * EntryChunkSize);
+    }
+
+    // Readers must see a complete index, so a larger one is filled before it is published
+    if (2 * (value + 1) > index->capacity()) {
+        HandleIndex* larger = new HandleIndex(2 * index->capacity());
+        for (int i = 0; i < index->capacity(); ++i) {
+            if (const HandleEntry* entry = index->slots[i].loadRelaxed()) {
+                insert(larger, entry);
+            }
+        }
+        table.retiredIndices.append(index);
+        table.index.storeRelease(larger);
+        index = larger;
+    }
+
+    EntryChunk* chunk = table.chunks[value >> EntryChunkShift].loadRelaxed();
+    if (!chunk) {
+        chunk = new EntryChunk();
+        table.chunks[value >> EntryChunkShift].storeRelease(chunk);
+    }
+
+    const HandleEntry* entry = new HandleEntry{pluginId, hash, value};
+    chunk->entries[value & (EntryChunkSize - 1)].storeRelease(entry);
+    insert(index, entry);
+    ++table.count;
+
+    return PluginHandle(value);
+}
+
+PluginHandle PluginHandle::find(const QString& pluginId)
+{
+    if (pluginId.isEmpty()) {
+        return PluginHandle();
+    }
+
+    const HandleEntry* entry = lookup(handleTable().index.loadAcquire(), pluginId, qHash(pluginId));
+    return entry ? PluginHandle(entry->value) : PluginHandle();
+}
+
+QString PluginHandle::pluginId() const
+{
+    if (!isValid() || (m_value >> EntryChunkShift) >= MaxEntryChunks) {
+        return QString();
+    }
+
+    const EntryChunk* chunk = handleTable().chunks[m_value >> EntryChunkShift].loadAcquire();
+    const HandleEntry* entry = chunk ? chunk->entries[m_value & (EntryChunkSize - 1)].loadAcquire() : nullptr;
+
+    return entry ? entry->pluginId : QString();
@@ -0,0 +1,86 @@
+#ifndef PLUGINHANDLE_H
+#define PLUGINHANDLE_H
+
+#include <QString>
+#include <QHash>
+#include <QtGlobal>
+
+/**
+ * @brief The PluginHandle class is a dense integer identifying a plugin.
+ *
+ * Plugin IDs are interned once into a framework-wide table, so the same ID always
+ * yields the same handle for the lifetime of the process. Handles are cheap to copy,
+ * compare and hash, and index directly into per-plugin arrays, which makes them
+ * suitable for hot paths that would otherwise look plugins up by string.
+ *
+ * Looking up an interned ID, in either direction, takes no lock: the table is published
+ * with atomic stores and interned IDs are never changed or removed. Only interning a new
+ * ID is serialized.
+ */
+class PluginHandle
+{
+public:
+    /**
+     * @brief Constructs an invalid handle
+     */
+    PluginHandle() : m_value(-1) {}
+
+    /**
+     * @brief Get the handle of a plugin ID, interning the ID if it is new
+     *
+     * @param pluginId ID of the plugin
+     * @return Handle of the plugin, or an invalid handle if the ID is empty
+     */
+    static PluginHandle fromId(const QString& pluginId);
+
+    /**
+     * @brief Get the handle of a plugin ID that has been interned before
+     *
+     * @param pluginId ID of the plugin
+     * @return Handle of the plugin, or an invalid handle if the ID is unknown
+     */
+    static PluginHandle find(const QString& pluginId);
+
+    /**
+     * @brief Check if the handle refers to a plugin ID
+     *
+     * @return True if the handle is valid, false otherwise
+     */
+    bool isValid() const { return m_value >= 0; }
+
+    /**
+     * @brief Get the dense index of the handle
+     *
+     * @return Index starting at 0, or -1 for an invalid handle
+     */
+    int value() const { return m_value; }
+
+    /**
+     * @brief Get the plugin ID the handle was interned from
+     *
+     * @return ID of the plugin, or an empty string for an invalid handle
+     */
+    QString pluginId() const;
+
+    bool operator==(const PluginHandle& other) const { return m_value == other.m_value; }
+    bool operator!=(const PluginHandle& other) const { return m_value != other.m_value; }
+    bool operator<(const PluginHandle& other) const { return m_value < other.m_value; }
+
+private:
+    friend class PluginRegistry;
+
+    explicit PluginHandle(int value) : m_value(value) {}
+
+    int m_value;
+};
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+inline size_t qHash(const PluginHandle& handle, size_t seed = 0) noexcept
+#else
+inline uint qHash(const PluginHandle& handle, uint seed = 0) noexcept
+#endif
+{
+    return qHash(handle.value(), seed);
+}
+
+#endif // PLUGINHANDLE_H
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "PluginMailbox.h"
+
+#include <QDeadlineTimer>
+#include <QMutexLocker>
+
+PluginMailbox::PluginMailbox(int capacity, MailboxOverflowPolicy policy)
+    : m_scheduled(false),
+      m_suspended(false),
+      m_delivering(false),
+      m_closed(false)
+{
+    m_statistics.capacity = qMax(1, capacity);
+    m_statistics.policy = policy;
+}
+
+void PluginMailbox::setPolicy(int capacity, MailboxOverflowPolicy policy)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_statistics.capacity = qMax(1, capacity);
+    m_statistics.policy = policy;
+
+    // Blocked posters may now fit, or have to give up under the new policy
+    m_notFull.wakeAll();
+}
+
+bool PluginMailbox::push(Message& message, int blockTimeoutMs, bool* scheduleDrain, QList<Message>* dropped)
+{
+    *scheduleDrain = false;
+
+    QMutexLocker locker(&m_mutex);
+
+    QDeadlineTimer deadline = blockTimeoutMs < 0 ? QDeadlineTimer(QDeadlineTimer::Forever) : QDeadlineTimer(blockTimeoutMs);
+
+    while (!m_closed && m_queue.size() >= m_statistics.capacity) {
+        if (m_statistics.policy == MailboxOverflowPolicy::DropOldest) {
+            dropped->append(m_queue.dequeue());
+            ++m_statistics.dropped;
+            continue;
+        }
+
+        if (m_statistics.policy == MailboxOverflowPolicy::Reject || !m_notFull.wait(&m_mutex, deadline)) {
+            ++m_statistics.rejected;
+            return false;
+        }
+    }
+
+    if (m_closed) {
+        return false;
+    }
+
+    message.queuedTimer.start();
+    m_queue.enqueue(message);
+
+    ++m_statistics.posted;
+    m_statistics.maxDepth = qMax(m_statistics.maxDepth, int(m_queue.size()));
+
+    if (!m_scheduled && !m_suspended) {
+        m_scheduled = true;
+        *scheduleDrain = true;
+    }
+
+    return true;
+}
+
+bool PluginMailbox::takeNext(Message& message)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_closed || m_suspended || m_queue.isEmpty()) {
+        m_scheduled = false;
+        return false;
+    }
+
+    message = m_queue.dequeue();
+    ++m_statistics.delivered;
+    m_delivering = true;
+
+    m_notFull.wakeOne();
+
+    return true;
+}
+
+void PluginMailbox::finishDelivery()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_delivering = false;
+    m_deliveryFinished.wakeAll();
+}
+
+bool PluginMailbox::suspend(QDeadlineTimer deadline)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_suspended = true;
+
+    while (m_delivering) {
+        if (!m_deliveryFinished.wait(&m_mutex, deadline)) {
+            return !m_delivering;
+        }
+    }
+
+    return true;
+}
+
+bool PluginMailbox::resume()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_suspended = false;
+
+    if (m_scheduled || m_closed || m_queue.isEmpty()) {
+        return false;
+    }
+
+    m_scheduled = true;
+    return true;
+}
+
+QList<PluginMailbox::Message> PluginMailbox::close()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_closed = true;
+    m_notFull.wakeAll();
+
+    QList<Message> pending = m_queue;
+    m_queue.clear();
+
+    return pending;
+}
+
+MailboxStatistics PluginMailbox::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    MailboxStatistics statistics = m_statistics;
+    statistics.depth = m_queue.size();
+
+    return statistics;
+}
\ No newline at end of file
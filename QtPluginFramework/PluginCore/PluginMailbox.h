@@ -0,0 +1,157 @@
+#ifndef PLUGINMAILBOX_H
+#define PLUGINMAILBOX_H
+
+#include <QString>
+#include <QVariant>
+#include <QList>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QDeadlineTimer>
+#include <QFutureInterface>
+
+/**
+ * @brief What happens to a message posted to a full mailbox
+ */
+enum class MailboxOverflowPolicy {
+    Block,      ///< Wait for the receiver to make room, up to the block timeout
+    DropOldest, ///< Discard the oldest queued message to make room
+    Reject      ///< Refuse the new message
+};
+
+/**
+ * @brief Counters of one mailbox
+ */
+struct MailboxStatistics {
+    int capacity = 0;                                           ///< Maximum number of queued messages
+    MailboxOverflowPolicy policy = MailboxOverflowPolicy::Block;
+    int depth = 0;                                              ///< Messages queued now
+    int maxDepth = 0;                                           ///< Most messages ever queued at once
+    quint64 posted = 0;                                         ///< Messages accepted into the queue
+    quint64 delivered = 0;                                      ///< Messages taken out for delivery
+    quint64 dropped = 0;                                        ///< Messages discarded by DropOldest
+    quint64 rejected = 0;                                       ///< Messages refused because the mailbox was full
+};
+
+/**
+ * @brief The PluginMailbox class is a bounded queue of messages posted to one plugin.
+ *
+ * Any number of threads post into the mailbox, and one drain task at a time takes
+ * messages out, so a receiver sees its posted messages in the order they were queued.
+ * The mailbox only tracks whether a drain task is scheduled; running it is up to the
+ * owner, which schedules one whenever push() asks for it.
+ *
+ * Handlers run without the mailbox lock. The drain task reports the end of each delivery,
+ * so that a plugin about to be torn down can suspend its mailbox and wait for the message
+ * it is handling. A suspended mailbox keeps accepting messages and delivers them once it
+ * is resumed.
+ */
+class PluginMailbox
+{
+public:
+    /**
+     * @brief A posted message waiting for delivery
+     */
+    struct Message {
+        QString sender;
+        QString messageType;
+        QVariant data;
+        QFutureInterface<QVariant> promise;     // Receives the response of a request
+        bool hasPromise = false;
+        QElapsedTimer queuedTimer;              // Started when the message is queued
+    };
+
+    /**
+     * @brief Constructor
+     *
+     * @param capacity Maximum number of queued messages, at least 1
+     * @param policy What to do when the mailbox is full
+     */
+    PluginMailbox(int capacity, MailboxOverflowPolicy policy);
+
+    /**
+     * @brief Change the capacity and overflow policy
+     *
+     * Messages above a reduced capacity stay queued.
+     *
+     * @param capacity Maximum number of queued messages, at least 1
+     * @param policy What to do when the mailbox is full
+     */
+    void setPolicy(int capacity, MailboxOverflowPolicy policy);
+
+    /**
+     * @brief Queue a message
+     *
+     * With the Block policy, the call waits for room for up to blockTimeoutMs, or
+     * indefinitely if it is negative; with a timeout of 0 it is rejected at once.
+     *
+     * @param message Message to queue; its timer is started here
+     * @param blockTimeoutMs How long the Block policy waits for room
+     * @param scheduleDrain Set to true if the caller must schedule a drain task
+     * @param dropped Receives the messages discarded to make room
+     * @return True if the message was queued, false if it was rejected or the mailbox is closed
+     */
+    bool push(Message& message, int blockTimeoutMs, bool* scheduleDrain, QList<Message>* dropped);
+
+    /**
+     * @brief Take the next message, called by the drain task
+     *
+     * When the mailbox is empty, suspended or closed, the drain task is considered finished
+     * and the next push() or resume() schedules a new one. A message taken must be followed
+     * by finishDelivery() once its handler has returned.
+     *
+     * @param message Receives the message
+     * @return True if a message was taken, false if the drain task should end
+     */
+    bool takeNext(Message& message);
+
+    /**
+     * @brief Report that the message taken by takeNext() was delivered
+     */
+    void finishDelivery();
+
+    /**
+     * @brief Stop handing out messages and wait for the one being delivered
+     *
+     * The mailbox stays suspended even if the wait times out.
+     *
+     * @param deadline Time at which to give up waiting
+     * @return True if no delivery is in progress anymore, false on timeout
+     */
+    bool suspend(QDeadlineTimer deadline);
+
+    /**
+     * @brief Hand out messages again after suspend()
+     *
+     * @return True if the caller must schedule a drain task for messages queued meanwhile
+     */
+    bool resume();
+
+    /**
+     * @brief Refuse further messages and wake blocked posters
+     *
+     * @return Messages that were still queued
+     */
+    QList<Message> close();
+
+    /**
+     * @brief Get the counters of the mailbox
+     *
+     * @return Copy of the counters
+     */
+    MailboxStatistics statistics() const;
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_notFull;
+    QQueue<Message> m_queue;
+    MailboxStatistics m_statistics;
+    bool m_scheduled;                   // A drain task is queued or running
+    bool m_suspended;
+    bool m_delivering;                  // A taken message has not been delivered yet
+    QWaitCondition m_deliveryFinished;
+    bool m_closed;
+};
+
+#endif // PLUGINMAILBOX_H
\ No newline at end of file
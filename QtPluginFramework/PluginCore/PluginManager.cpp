@@ -1,19 +1,47 @@
 ﻿#include "PluginManager.h"
 #include "ExceptionHandler.h"
+#include "IHotReloadable.h"
+#include "LazyPluginProxy.h"
 #include "LogManager.h"
 #include "PluginCommunication.h"
+#include "PluginMetrics.h"
+#include "PluginProfiler.h"
 
 #include <QCoreApplication>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileSystemWatcher>
 #include <QFileInfo>
+#include <QFutureInterface>
+#include <QHash>
+#include <QLibrary>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QThread>
+#include <QTimer>
+#include <QtConcurrent>
+
+#include <exception>
+#include <limits>
 
 #include <QMutexLocker>
+#include <QReadLocker>
 #include <QRecursiveMutex>
+#include <QWriteLocker>
 
 PluginManager::PluginManager()
-    : m_initialized(false)
+    : m_metadataIndexLoaded(false), m_lazyLoading(false), m_embeddedMetadata(false),
+      m_libraryWatcher(nullptr), m_reloadTimer(nullptr), m_idleTimer(nullptr), m_idleTimeout(0), m_maxLoadedPlugins(0),
+      m_preloadThread(nullptr), m_preloadCancelled(0),
+      m_commandDrainTimeout(30000), m_shutdownTimeout(2000), m_initialized(false)
 {
+    // A single worker keeps asynchronous lifecycle operations in submission order
+    m_lifecyclePool.setMaxThreadCount(1);
+    m_idleClock.start();
+    m_versionResolver.setFrameworkVersion(m_frameworkVersionNumber);
+
+    qRegisterMetaType<PluginManager::LifecycleStage>();
 }
 
 PluginManager::~PluginManager()
@@ -29,7 +57,7 @@ PluginManager& PluginManager::instance()
 
 bool PluginManager::initialize(const QString& pluginDir, const QString& metadataDir)
 {
-    QRecursiveMutex locker(&m_mutex);
+    QMutexLocker locker(&m_mutex);
 
     if (m_initialized) {
         LOG_WARNING("PluginManager", "Already initialized");
@@ -54,70 +82,378 @@ bool PluginManager::initialize(const QString& pluginDir, const QString& metadata
         }
     }
 
+    QWriteLocker stateLocker(&m_stateLock);
     m_pluginDir = pluginDir;
     m_metadataDir = metadataDir;
     m_initialized = true;
+    stateLocker.unlock();
+
+    discoverStaticPlugins();
+    m_usageHistory.load(usageHistoryPath());
 
     LOG_INFO("PluginManager", QString("Initialized with plugin directory: %1, metadata directory: %2").arg(pluginDir, metadataDir));
 
     return true;
 }
 
-void PluginManager::shutdown()
+namespace {
+
+// How long a thread waiting for plugins goes without running the calls posted to it
+const int ServeIntervalMs = 10;
+
+// Deactivation and shutdown of one plugin, run on the plugin's thread while shutdown() waits
+struct ShutdownJob {
+    QString pluginId;
+    IPlugin* plugin = nullptr;
+    bool wasActive = false;
+    bool deactivated = false;
+    QString errorMessage;
+    QSharedPointer<LifecycleCall> call;     // Null if the job ran on the calling thread
+};
+
+} // namespace
+
+QList<PluginLevelReport> PluginManager::shutdown()
 {
-    QRecursiveMutexLocker locker(&m_mutex);
+    // Drop queued asynchronous operations and let the running one finish. The running
+    // operation may be waiting for a call on this thread, so keep running those.
+    m_lifecyclePool.clear();
+    while (!m_lifecyclePool.waitForDone(ServeIntervalMs)) {
+        m_mutex.serveCalls();
+    }
+
+    stopPreloader();
+
+    // The timeout bounds the whole teardown, so levels left late get what remains of it
+    QDeadlineTimer deadline(m_shutdownTimeout < 0 ? -1 : m_shutdownTimeout);
+
+    // Running commands and message handlers may need the lifecycle lock to finish, so they are
+    // waited for before it is taken. The lock is then held until the teardown is over; work the
+    // idle or hot reload timer starts meanwhile waits for it and finds the manager shut down.
+    QStringList quiescedPluginIds;
+    {
+        QReadLocker stateLocker(&m_stateLock);
+        if (m_initialized) {
+            quiescedPluginIds = m_registry.loadedPluginIds();
+        }
+    }
+    for (const QString& pluginId : quiescedPluginIds) {
+        drainPluginCommands(pluginId, deadline);
+        suspendPluginMailbox(pluginId, deadline);
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    QList<PluginLevelReport> reports;
 
     if (m_initialized) {
         LOG_INFO("PluginManager", "Shutting down");
 
-        // Deactivate and unload all plugins in reverse dependency order
-        QStringList pluginIds = m_plugins.keys();
-        QStringList sortedPluginIds = sortPluginsByDependency(pluginIds);
+        // Tear down the plugins level by level, dependents before their dependencies
+        QList<QStringList> levels = groupPluginsByLevel(sortPluginsByDependency(m_registry.loadedPluginIds()));
+        QSet<QString> retainedPlugins;
+        QElapsedTimer timer;
+        timer.start();
+
+        for (int level = levels.size() - 1; level >= 0; --level) {
+            PluginLevelReport report;
+            report.level = level;
+            for (const QString& pluginId : levels[level]) {
+                if (m_registry.isLoaded(PluginHandle::find(pluginId))) {
+                    report.pluginIds.append(pluginId);
+                }
+            }
+            if (report.pluginIds.isEmpty()) {
+                continue;
+            }
+
+            shutdownPluginLevel(report, deadline, retainedPlugins);
+
+            LOG_INFO("PluginManager", QString("Level %1: shut down %2 plugins in %3 ms, unloaded in %4 ms, %5 failed, %6 timed out")
+                     .arg(level).arg(report.pluginIds.size()).arg(report.deactivateMs).arg(report.unloadMs)
+                     .arg(report.failedPluginIds.size()).arg(report.timedOutPluginIds.size()));
 
-        // Reverse the order for unloading
-        for (int i = 0; i < sortedPluginIds.size() / 2; ++i) {
-            sortedPluginIds.swapItemsAt(i, sortedPluginIds.size() - 1 - i);
+            reports.append(report);
         }
 
-        for (const QString& pluginId : sortedPluginIds) {
-            if (isPluginActive(pluginId)) {
-                deactivatePlugin(pluginId);
-            }
-            unloadPlugin(pluginId);
+        LOG_INFO("PluginManager", QString("Shutdown finished in %1 ms").arg(timer.elapsed()));
+
+        // Libraries preloaded for plugins that were never used
+        const QStringList preloadedPluginIds = m_preloadedLibraries.keys();
+        for (const QString& pluginId : preloadedPluginIds) {
+            releasePreloadedLibrary(pluginId);
+        }
+
+        saveUsageHistory();
+
+        if (m_metadataIndex.isDirty() && !m_metadataIndex.save(metadataIndexPath())) {
+            LOG_WARNING("PluginManager", QString("Failed to save metadata index: %1").arg(metadataIndexPath()));
+        }
+
+        // A later initialize() may point at another metadata directory
+        m_metadataIndex.clear();
+        m_metadataIndexLoaded = false;
+
+        m_evictedStates.clear();
+        m_deferredReactivations.clear();
+        {
+            QMutexLocker pinLocker(&m_pinMutex);
+            m_lastUsed.clear();
         }
 
-        m_pluginLoaders.clear();
-        m_plugins.clear();
-        m_pluginMetadata.clear();
-        m_pluginStates.clear();
+        QWriteLocker stateLocker(&m_stateLock);
+        m_registry.clear();
+        m_dependencyGraph.clear();
+        m_versionResolver.clear();
 
         m_initialized = false;
     }
+
+    // A later initialize() starts with plugins that accept commands
+    for (const QString& pluginId : quiescedPluginIds) {
+        endCommandDrain(pluginId);
+    }
+
+    return reports;
+}
+
+void PluginManager::shutdownPluginLevel(PluginLevelReport& report, const QDeadlineTimer& deadline, QSet<QString>& retainedPlugins)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<QSharedPointer<ShutdownJob>> jobs;
+    QStringList drainedPluginIds;
+
+    auto runJob = [](ShutdownJob& job) {
+        try {
+            if (job.wasActive) {
+                job.deactivated = callLifecycleMethod(job.plugin, &IPlugin::deactivate);
+                if (!job.deactivated) {
+                    job.errorMessage = "Failed to deactivate";
+                    return;
+                }
+            }
+            if (!callLifecycleMethod(job.plugin, &IPlugin::shutdown)) {
+                job.errorMessage = "Failed to shutdown";
+            }
+        } catch (const PluginException& ex) {
+            job.errorMessage = QString("Exception during shutdown: %1").arg(ex.getMessage());
+        } catch (const std::exception& ex) {
+            job.errorMessage = QString("Exception during shutdown: %1").arg(ex.what());
+        } catch (...) {
+            job.errorMessage = "Unknown exception during shutdown";
+        }
+    };
+
+    for (const QString& pluginId : report.pluginIds) {
+        // Running commands get the same deadline as the lifecycle calls
+        if (!drainPluginCommands(pluginId, deadline)) {
+            LOG_ERROR("PluginManager", QString("Commands of plugin %1 did not finish before the shutdown deadline").arg(pluginId));
+            report.timedOutPluginIds.append(pluginId);
+            abandonPlugin(pluginId);
+            continue;
+        }
+
+        // So do posted messages; the mailbox stays suspended, as nothing is delivered after shutdown
+        if (!suspendPluginMailbox(pluginId, deadline)) {
+            LOG_ERROR("PluginManager", QString("A message handler of plugin %1 did not finish before the shutdown deadline").arg(pluginId));
+            report.timedOutPluginIds.append(pluginId);
+            abandonPlugin(pluginId);
+            continue;
+        }
+        drainedPluginIds.append(pluginId);
+
+        PluginState state = pluginState(pluginId);
+        if (state != PluginState::Active && state != PluginState::Initialized && state != PluginState::Inactive) {
+            continue;
+        }
+
+        QSharedPointer<ShutdownJob> job(new ShutdownJob);
+        job->pluginId = pluginId;
+        job->plugin = m_registry.instance(PluginHandle::find(pluginId));
+        job->wasActive = state == PluginState::Active;
+        jobs.append(job);
+
+        emit pluginProgress(pluginId, job->wasActive ? LifecycleStage::Deactivating : LifecycleStage::ShuttingDown);
+
+        // A proxy that was never used has nothing to run; everything else on this thread
+        // moves to a thread of its own so that a hanging plugin cannot stall shutdown
+        QObject* context = pluginContext(job->plugin);
+        if (context->thread() == QThread::currentThread()) {
+            LazyPluginProxy* proxy = qobject_cast<LazyPluginProxy*>(context);
+            if (proxy) {
+                runJob(*job);
+                continue;
+            }
+            placePluginInstance(pluginId, context, true);
+        }
+
+        // The jobs run side by side and may outlive the deadline, so none of them runs as the
+        // owner of the lifecycle lock
+        job->call = m_mutex.post(context, [job, runJob]() {
+            runJob(*job);
+        }, false);
+    }
+
+    // Plugins may call back into this thread while they shut down; waiting runs those calls
+    for (const QSharedPointer<ShutdownJob>& job : jobs) {
+        if (job->call) {
+            m_mutex.wait(job->call, deadline);
+        }
+    }
+
+    report.deactivateMs = timer.restart();
+
+    for (const QSharedPointer<ShutdownJob>& job : jobs) {
+        if (job->call && !job->call->isFinished()) {
+            LOG_ERROR("PluginManager", QString("Plugin %1 did not shut down before the shutdown deadline of %2 ms and is left loaded").arg(job->pluginId).arg(m_shutdownTimeout));
+            report.timedOutPluginIds.append(job->pluginId);
+            drainedPluginIds.removeOne(job->pluginId);
+            abandonPlugin(job->pluginId);
+            continue;
+        }
+
+        if (job->deactivated) {
+            emit pluginDeactivated(job->pluginId);
+        }
+
+        if (!job->errorMessage.isEmpty()) {
+            LOG_ERROR("PluginManager", QString("Error shutting down plugin %1: %2").arg(job->pluginId, job->errorMessage));
+            report.failedPluginIds.append(job->pluginId);
+        }
+
+        // The plugin is shut down, so releasing it below only unloads it
+        setPluginState(job->pluginId, PluginState::Loaded);
+    }
+
+    // A plugin that is still running may call into its dependencies, so their code has to stay mapped
+    for (const QString& pluginId : report.timedOutPluginIds) {
+        const QStringList dependencies = m_dependencyGraph.transitiveDependencies(pluginId);
+        for (const QString& depId : dependencies) {
+            retainedPlugins.insert(depId);
+        }
+    }
+
+    for (const QString& pluginId : drainedPluginIds) {
+        if (retainedPlugins.contains(pluginId)) {
+            LOG_WARNING("PluginManager", QString("Keeping plugin %1 loaded for a plugin that did not shut down").arg(pluginId));
+            endCommandDrain(pluginId);
+            continue;
+        }
+
+        if (!releasePlugin(pluginId, nullptr) && !report.failedPluginIds.contains(pluginId)) {
+            report.failedPluginIds.append(pluginId);
+        }
+        endCommandDrain(pluginId);
+    }
+
+    for (const QString& pluginId : report.timedOutPluginIds) {
+        if (!report.failedPluginIds.contains(pluginId)) {
+            report.failedPluginIds.append(pluginId);
+        }
+    }
+
+    report.unloadMs = timer.elapsed();
+}
+
+void PluginManager::abandonPlugin(const QString& pluginId)
+{
+    // The thread may still be inside the plugin, so it must neither be joined nor deleted
+    {
+        QWriteLocker stateLocker(&m_stateLock);
+        m_pluginThreads.remove(pluginId);
+    }
+
+    markPluginFailed(pluginId, "Did not shut down before the deadline");
+}
+
+namespace {
+
+// A metadata file is named after its plugin, or after a side-by-side version of it
+bool isMetadataFileOf(const QFileInfo& fileInfo, const PluginMetadata& metadata)
+{
+    QString fileName = fileInfo.completeBaseName();
+    return fileName == metadata.getPluginId() || fileName == metadata.getPluginId() + "-" + metadata.getPluginVersion();
 }
 
-QStringList PluginManager::scanForPlugins()
+} // namespace
+
+QStringList PluginManager::scanForPlugins(bool rebuildIndex)
 {
-    QRecursiveMutexLocker locker(&m_mutex);
+    QMutexLocker locker(&m_mutex);
+    PROFILE_SCOPE("PluginManager::scanForPlugins");
 
     if (!m_initialized) {
         LOG_ERROR("PluginManager", "Not initialized");
         return QStringList();
     }
 
+    if (rebuildIndex) {
+        m_metadataIndex.clear();
+        m_metadataIndexLoaded = true;
+    } else if (!m_metadataIndexLoaded) {
+        m_metadataIndex.load(metadataIndexPath());
+        m_metadataIndexLoaded = true;
+    }
+
     QStringList pluginIds;
+    QSet<QString> metadataPaths;
 
-    // Scan metadata directory for JSON files
+    // Scan metadata directory for JSON and CBOR files
     QDir metaDir(m_metadataDir);
-    QStringList metadataFiles = metaDir.entryList(QStringList() << "*.json", QDir::Files);
+    const QFileInfoList metadataFiles = metaDir.entryInfoList(QStringList() << "*.json" << "*.cbor", QDir::Files);
 
-    for (const QString& metadataFile : metadataFiles) {
-        QString pluginId = QFileInfo(metadataFile).baseName();
+    for (const QFileInfo& metadataFile : metadataFiles) {
+        // The index and the usage history live here too, and dot files are not hidden on Windows
+        if (metadataFile.fileName().startsWith('.')) {
+            continue;
+        }
+
+        metadataPaths.insert(metadataFile.absoluteFilePath());
+
+        PluginMetadata metadata;
+        if (!readPluginMetadata(metadataFile, metadata)) {
+            LOG_ERROR("PluginManager", QString("Failed to load metadata from file: %1").arg(metadataFile.filePath()));
+            continue;
+        }
 
-        if (loadPluginMetadata(pluginId)) {
+        QString pluginId = metadata.getPluginId();
+        if (!isMetadataFileOf(metadataFile, metadata)) {
+            LOG_ERROR("PluginManager", QString("Metadata file %1 does not match plugin %2 %3")
+                      .arg(metadataFile.fileName(), pluginId, metadata.getPluginVersion()));
+            continue;
+        }
+
+        if (registerPluginMetadata(pluginId, metadata) && !pluginIds.contains(pluginId)) {
             pluginIds.append(pluginId);
         }
     }
 
+    // Libraries without a metadata file describe themselves
+    if (m_embeddedMetadata) {
+        scanEmbeddedMetadata(pluginIds, metadataPaths);
+    }
+
+    // So do plugins linked into the host
+    for (auto it = m_staticPlugins.constBegin(); it != m_staticPlugins.constEnd(); ++it) {
+        if (pluginIds.contains(it.key())) {
+            continue;
+        }
+
+        PluginMetadata metadata(it.value().metaData.value("MetaData").toObject());
+        if (registerPluginMetadata(it.key(), metadata)) {
+            pluginIds.append(it.key());
+        }
+    }
+
+    // Forget files that were removed since the last scan
+    m_metadataIndex.retain(metadataPaths);
+
+    if (m_metadataIndex.isDirty() && !m_metadataIndex.save(metadataIndexPath())) {
+        LOG_WARNING("PluginManager", QString("Failed to save metadata index: %1").arg(metadataIndexPath()));
+    }
+
     LOG_INFO("PluginManager", QString("Found %1 plugins").arg(pluginIds.size()));
 
     return pluginIds;
@@ -125,7 +461,14 @@ QStringList PluginManager::scanForPlugins()
 
 bool PluginManager::loadPlugin(const QString& pluginId)
 {
-    QRecursiveMutexLocker locker(&m_mutex);
+    QMutexLocker locker(&m_mutex);
+
+    return loadPluginInstance(pluginId, m_lazyLoading);
+}
+
+bool PluginManager::loadPluginInstance(const QString& pluginId, bool allowLazy)
+{
+    QMutexLocker locker(&m_mutex);
 
     if (!m_initialized) {
         LOG_ERROR("PluginManager", "Not initialized");
@@ -138,98 +481,74 @@ bool PluginManager::loadPlugin(const QString& pluginId)
     }
 
     // Load metadata if not already loaded
-    if (!m_pluginMetadata.contains(pluginId)) {
+    if (!m_registry.hasMetadata(PluginHandle::find(pluginId))) {
         if (!loadPluginMetadata(pluginId)) {
             LOG_ERROR("PluginManager", QString("Failed to load metadata for plugin: %1").arg(pluginId));
             return false;
         }
     }
 
-    // Check if plugin is compatible with framework
-    const PluginMetadata& metadata = m_pluginMetadata[pluginId];
-    if (!metadata.isCompatibleWithFramework(m_frameworkVersion)) {
-        LOG_ERROR("PluginManager", QString("Plugin %1 is not compatible with framework version %2").arg(pluginId, m_frameworkVersion));
-        m_pluginStates[pluginId] = PluginState::Failed;
-        emit pluginFailed(pluginId, QString("Incompatible with framework version %1").arg(m_frameworkVersion));
-        return false;
-    }
+    emit pluginProgress(pluginId, LifecycleStage::ResolvingDependencies);
 
-    // Check dependencies
-    if (!checkPluginDependencies(pluginId)) {
-        LOG_ERROR("PluginManager", QString("Plugin %1 has unsatisfied dependencies").arg(pluginId));
-        m_pluginStates[pluginId] = PluginState::Failed;
-        emit pluginFailed(pluginId, "Unsatisfied dependencies");
+    QString pluginPath;
+    if (!preparePluginLoad(pluginId, pluginPath)) {
         return false;
     }
 
-    // Load plugin library
-    QString pluginPath = QDir(m_pluginDir).filePath(metadata.getPluginId() + ".dll"); // Windows
-    if (!QFile::exists(pluginPath)) {
-        pluginPath = QDir(m_pluginDir).filePath("lib" + metadata.getPluginId() + ".so"); // Linux
-    }
-    if (!QFile::exists(pluginPath)) {
-        pluginPath = QDir(m_pluginDir).filePath("lib" + metadata.getPluginId() + ".dylib"); // macOS
-    }
-
-    if (!QFile::exists(pluginPath)) {
-        LOG_ERROR("PluginManager", QString("Plugin library not found: %1").arg(pluginPath));
-        m_pluginStates[pluginId] = PluginState::Failed;
-        emit pluginFailed(pluginId, "Plugin library not found");
-        return false;
+    if (allowLazy) {
+        attachLazyProxy(pluginId);
+        return true;
     }
 
-    QPluginLoader* loader = new QPluginLoader(pluginPath);
+    emit pluginProgress(pluginId, LifecycleStage::LoadingLibrary);
 
-    if (!loader->load()) {
-        LOG_ERROR("PluginManager", QString("Failed to load plugin %1: %2").arg(pluginId, loader->errorString()));
-        delete loader;
-        m_pluginStates[pluginId] = PluginState::Failed;
-        emit pluginFailed(pluginId, QString("Failed to load: %1").arg(loader->errorString()));
-        return false;
-    }
+    // Static plugins are already linked in and have no library to load
+    QPluginLoader* loader = nullptr;
+    if (!pluginPath.isEmpty()) {
+        loader = new QPluginLoader(pluginPath);
 
-    QObject* pluginInstance = loader->instance();
-    if (!pluginInstance) {
-        LOG_ERROR("PluginManager", QString("Failed to get plugin instance for %1: %2").arg(pluginId, loader->errorString()));
-        loader->unload();
-        delete loader;
-        m_pluginStates[pluginId] = PluginState::Failed;
-        emit pluginFailed(pluginId, QString("Failed to get instance: %1").arg(loader->errorString()));
-        return false;
-    }
+        bool libraryLoaded;
+        {
+            PROFILE_PLUGIN_SCOPE("QPluginLoader::load", pluginId);
+            libraryLoaded = loader->load();
+        }
 
-    IPlugin* plugin = qobject_cast<IPlugin*>(pluginInstance);
-    if (!plugin) {
-        LOG_ERROR("PluginManager", QString("Plugin %1 does not implement IPlugin interface").arg(pluginId));
-        loader->unload();
-        delete loader;
-        m_pluginStates[pluginId] = PluginState::Failed;
-        emit pluginFailed(pluginId, "Does not implement IPlugin interface");
-        return false;
+        if (!libraryLoaded) {
+            QString errorString = loader->errorString();
+            LOG_ERROR("PluginManager", QString("Failed to load plugin %1: %2").arg(pluginId, errorString));
+            delete loader;
+            markPluginFailed(pluginId, QString("Failed to load: %1").arg(errorString));
+            return false;
+        }
     }
 
-    m_pluginLoaders[pluginId] = loader;
-    m_plugins[pluginId] = plugin;
-    m_pluginStates[pluginId] = PluginState::Loaded;
-
-    LOG_INFO("PluginManager", QString("Loaded plugin: %1").arg(pluginId));
-
-    emit pluginLoaded(pluginId);
-
-    return true;
+    return attachPluginInstance(pluginId, loader);
 }
 
 bool PluginManager::unloadPlugin(const QString& pluginId)
 {
-    QRecursiveMutexLocker locker(&m_mutex);
+    // Running commands and message handlers may need the lifecycle lock to finish, so wait
+    // for them before taking it
+    if (!drainPluginCommands(pluginId)) {
+        LOG_ERROR("PluginManager", QString("Cannot unload plugin %1 because commands are still running").arg(pluginId));
+        endCommandDrain(pluginId);
+        return false;
+    }
+    suspendPluginMailbox(pluginId);
+
+    QMutexLocker locker(&m_mutex);
 
     if (!m_initialized) {
         LOG_ERROR("PluginManager", "Not initialized");
+        PluginCommunication::instance().resumeMailbox(pluginId);
+        endCommandDrain(pluginId);
         return false;
     }
 
     if (!isPluginLoaded(pluginId)) {
         LOG_WARNING("PluginManager", QString("Plugin not loaded: %1").arg(pluginId));
+        PluginCommunication::instance().resumeMailbox(pluginId);
+        endCommandDrain(pluginId);
         return true;
     }
 
@@ -237,9 +556,27 @@ bool PluginManager::unloadPlugin(const QString& pluginId)
     QStringList dependentPlugins = getDependentPlugins(pluginId);
     if (!dependentPlugins.isEmpty()) {
         LOG_ERROR("PluginManager", QString("Cannot unload plugin %1 because other plugins depend on it: %2").arg(pluginId, dependentPlugins.join(", ")));
+        PluginCommunication::instance().resumeMailbox(pluginId);
+        endCommandDrain(pluginId);
         return false;
     }
 
+    bool released = releasePlugin(pluginId, nullptr);
+    endCommandDrain(pluginId);
+
+    // Messages posted meanwhile find no handler and complete their requests empty, or reach
+    // the plugin if it could not be unloaded
+    PluginCommunication::instance().resumeMailbox(pluginId);
+
+    if (released) {
+        saveUsageHistory();
+    }
+
+    return released;
+}
+
+bool PluginManager::releasePlugin(const QString& pluginId, QVariant* reloadState)
+{
     // Deactivate plugin if active
     if (isPluginActive(pluginId)) {
         if (!deactivatePlugin(pluginId)) {
@@ -248,10 +585,33 @@ bool PluginManager::unloadPlugin(const QString& pluginId)
         }
     }
 
+    IPlugin* plugin = m_registry.instance(PluginHandle::find(pluginId));
+
+    // Let a reloadable plugin capture its state before it shuts down
+    if (reloadState) {
+        LazyPluginProxy* lazyProxy = m_registry.proxy(PluginHandle::find(pluginId));
+        IHotReloadable* reloadable = qobject_cast<IHotReloadable*>(lazyProxy ? lazyProxy->target() : plugin);
+        if (reloadable) {
+            try {
+                runOnPluginThread(plugin, [reloadable, reloadState]() {
+                    *reloadState = reloadable->saveReloadState();
+                });
+            } catch (const PluginException& ex) {
+                LOG_WARNING("PluginManager", QString("Exception while saving reload state of %1: %2").arg(pluginId, ex.getMessage()));
+            } catch (const std::exception& ex) {
+                LOG_WARNING("PluginManager", QString("Exception while saving reload state of %1: %2").arg(pluginId, ex.what()));
+            } catch (...) {
+                LOG_WARNING("PluginManager", QString("Unknown exception while saving reload state of %1").arg(pluginId));
+            }
+        }
+    }
+
     // Shutdown plugin
-    IPlugin* plugin = m_plugins[pluginId];
-    if (m_pluginStates[pluginId] == PluginState::Initialized) {
-        if (!plugin->shutdown()) {
+    PluginState state = pluginState(pluginId);
+    if (state == PluginState::Initialized || state == PluginState::Inactive) {
+        emit pluginProgress(pluginId, LifecycleStage::ShuttingDown);
+
+        if (!invokeOnPluginThread(plugin, &IPlugin::shutdown)) {
             LOG_ERROR("PluginManager", QString("Failed to shutdown plugin: %1").arg(pluginId));
             return false;
         }
@@ -260,17 +620,53 @@ bool PluginManager::unloadPlugin(const QString& pluginId)
     // Unregister all message handlers
     PluginCommunication::instance().unregisterAllMessageHandlers(pluginId);
 
-    // Unload plugin
-    QPluginLoader* loader = m_pluginLoaders[pluginId];
-    if (!loader->unload()) {
+    // Detach a lazy proxy before its target is destroyed with the library
+    LazyPluginProxy* proxy = m_registry.proxy(PluginHandle::find(pluginId));
+    IPlugin* instance = proxy ? proxy->target() : plugin;
+    if (proxy) {
+        proxy->setTarget(nullptr);
+    }
+
+    // The instance is destroyed on this thread, so bring it back from its own
+    retirePluginThread(pluginId, instance);
+
+    emit pluginProgress(pluginId, LifecycleStage::Unloading);
+
+    // Unload plugin; a lazy proxy that was never used has no library to unload
+    QPluginLoader* loader = m_registry.loader(PluginHandle::find(pluginId));
+
+    // A static plugin cannot be unloaded; deleting its instance has the same effect,
+    // and the next load creates a fresh one
+    IPlugin* staticInstance = nullptr;
+    if (!loader && m_staticPlugins.contains(pluginId)) {
+        staticInstance = instance;
+    }
+
+    if (loader && !loader->unload()) {
         LOG_ERROR("PluginManager", QString("Failed to unload plugin %1: %2").arg(pluginId, loader->errorString()));
+        if (instance) {
+            placePluginInstance(pluginId, instance);
+        }
+        if (proxy) {
+            proxy->setTarget(instance);
+        }
         return false;
     }
 
+    {
+        QWriteLocker stateLocker(&m_stateLock);
+        PluginHandle handle = PluginHandle::find(pluginId);
+        m_registry.detach(handle);
+        m_registry.setState(handle, PluginState::NotLoaded);
+    }
+
+    m_libraryTimestamps.remove(pluginId);
+    m_evictedStates.remove(pluginId);
     delete loader;
-    m_pluginLoaders.remove(pluginId);
-    m_plugins.remove(pluginId);
-    m_pluginStates[pluginId] = PluginState::NotLoaded;
+    delete proxy;
+    if (staticInstance) {
+        destroyStaticInstance(staticInstance);
+    }
 
     LOG_INFO("PluginManager", QString("Unloaded plugin: %1").arg(pluginId));
 
@@ -281,7 +677,7 @@ bool PluginManager::unloadPlugin(const QString& pluginId)
 
 bool PluginManager::initializePlugin(const QString& pluginId)
 {
-    QRecursiveMutexLocker locker(&m_mutex);
+    QMutexLocker locker(&m_mutex);
 
     if (!m_initialized) {
         LOG_ERROR("PluginManager", "Not initialized");
@@ -293,34 +689,37 @@ bool PluginManager::initializePlugin(const QString& pluginId)
         return false;
     }
 
-    if (m_pluginStates[pluginId] == PluginState::Initialized || m_pluginStates[pluginId] == PluginState::Active) {
+    PluginState state = pluginState(pluginId);
+    if (state == PluginState::Initialized || state == PluginState::Active || state == PluginState::Inactive) {
         LOG_WARNING("PluginManager", QString("Plugin already initialized: %1").arg(pluginId));
         return true;
     }
 
-    if (m_pluginStates[pluginId] == PluginState::Failed) {
+    if (pluginState(pluginId) == PluginState::Failed) {
         LOG_ERROR("PluginManager", QString("Plugin in failed state: %1").arg(pluginId));
         return false;
     }
 
     // Initialize dependencies first
-    const PluginMetadata& metadata = m_pluginMetadata[pluginId];
-    QStringList dependencies = metadata.getPluginDependencies();
+    emit pluginProgress(pluginId, LifecycleStage::ResolvingDependencies);
+
+    QStringList dependencies = m_dependencyGraph.dependencies(pluginId);
 
     for (const QString& depId : dependencies) {
         if (!isPluginLoaded(depId)) {
             if (!loadPlugin(depId)) {
                 LOG_ERROR("PluginManager", QString("Failed to load dependency %1 for plugin %2").arg(depId, pluginId));
-                m_pluginStates[pluginId] = PluginState::Failed;
+                setPluginState(pluginId, PluginState::Failed);
                 emit pluginFailed(pluginId, QString("Failed to load dependency: %1").arg(depId));
                 return false;
             }
         }
 
-        if (m_pluginStates[depId] != PluginState::Initialized && m_pluginStates[depId] != PluginState::Active) {
+        PluginState depState = pluginState(depId);
+        if (depState != PluginState::Initialized && depState != PluginState::Active && depState != PluginState::Inactive) {
             if (!initializePlugin(depId)) {
                 LOG_ERROR("PluginManager", QString("Failed to initialize dependency %1 for plugin %2").arg(depId, pluginId));
-                m_pluginStates[pluginId] = PluginState::Failed;
+                setPluginState(pluginId, PluginState::Failed);
                 emit pluginFailed(pluginId, QString("Failed to initialize dependency: %1").arg(depId));
                 return false;
             }
@@ -328,33 +727,39 @@ bool PluginManager::initializePlugin(const QString& pluginId)
     }
 
     // Initialize plugin
-    IPlugin* plugin = m_plugins[pluginId];
+    IPlugin* plugin = m_registry.instance(PluginHandle::find(pluginId));
+
+    emit pluginProgress(pluginId, LifecycleStage::Initializing);
 
     try {
-        if (!plugin->initialize()) {
+        PROFILE_PLUGIN_SCOPE("IPlugin::initialize", pluginId);
+        // Plugins on the application thread initialize on the calling thread, so that a
+        // slow initialize() called from the lifecycle worker does not block the UI
+        bool initialized = invokeOnPluginThread(plugin, &IPlugin::initialize);
+        if (!initialized) {
             LOG_ERROR("PluginManager", QString("Failed to initialize plugin: %1").arg(pluginId));
-            m_pluginStates[pluginId] = PluginState::Failed;
+            setPluginState(pluginId, PluginState::Failed);
             emit pluginFailed(pluginId, "Failed to initialize");
             return false;
         }
     } catch (const PluginException& ex) {
         LOG_ERROR("PluginManager", QString("Exception during plugin initialization: %1").arg(ex.getMessage()));
-        m_pluginStates[pluginId] = PluginState::Failed;
+        setPluginState(pluginId, PluginState::Failed);
         emit pluginFailed(pluginId, QString("Exception during initialization: %1").arg(ex.getMessage()));
         return false;
     } catch (const std::exception& ex) {
         LOG_ERROR("PluginManager", QString("Exception during plugin initialization: %1").arg(ex.what()));
-        m_pluginStates[pluginId] = PluginState::Failed;
+        setPluginState(pluginId, PluginState::Failed);
         emit pluginFailed(pluginId, QString("Exception during initialization: %1").arg(ex.what()));
         return false;
     } catch (...) {
         LOG_ERROR("PluginManager", "Unknown exception during plugin initialization");
-        m_pluginStates[pluginId] = PluginState::Failed;
+        setPluginState(pluginId, PluginState::Failed);
         emit pluginFailed(pluginId, "Unknown exception during initialization");
         return false;
     }
 
-    m_pluginStates[pluginId] = PluginState::Initialized;
+    setPluginState(pluginId, PluginState::Initialized);
 
     LOG_INFO("PluginManager", QString("Initialized plugin: %1").arg(pluginId));
 
@@ -365,7 +770,7 @@ bool PluginManager::initializePlugin(const QString& pluginId)
 
 bool PluginManager::activatePlugin(const QString& pluginId)
 {
-    QRecursiveMutexLocker locker(&m_mutex);
+    QMutexLocker locker(&m_mutex);
 
     if (!m_initialized) {
         LOG_ERROR("PluginManager", "Not initialized");
@@ -377,18 +782,18 @@ bool PluginManager::activatePlugin(const QString& pluginId)
         return false;
     }
 
-    if (m_pluginStates[pluginId] == PluginState::Active) {
+    if (pluginState(pluginId) == PluginState::Active) {
         LOG_WARNING("PluginManager", QString("Plugin already active: %1").arg(pluginId));
         return true;
     }
 
-    if (m_pluginStates[pluginId] == PluginState::Failed) {
+    if (pluginState(pluginId) == PluginState::Failed) {
         LOG_ERROR("PluginManager", QString("Plugin in failed state: %1").arg(pluginId));
         return false;
     }
 
     // Initialize plugin if not already initialized
-    if (m_pluginStates[pluginId] != PluginState::Initialized) {
+    if (pluginState(pluginId) != PluginState::Initialized && pluginState(pluginId) != PluginState::Inactive) {
         if (!initializePlugin(pluginId)) {
             LOG_ERROR("PluginManager", QString("Failed to initialize plugin: %1").arg(pluginId));
             return false;
@@ -396,11 +801,12 @@ bool PluginManager::activatePlugin(const QString& pluginId)
     }
 
     // Activate dependencies first
-    const PluginMetadata& metadata = m_pluginMetadata[pluginId];
-    QStringList dependencies = metadata.getPluginDependencies();
+    emit pluginProgress(pluginId, LifecycleStage::ResolvingDependencies);
+
+    QStringList dependencies = m_dependencyGraph.dependencies(pluginId);
 
     for (const QString& depId : dependencies) {
-        if (m_pluginStates[depId] != PluginState::Active) {
+        if (pluginState(depId) != PluginState::Active) {
             if (!activatePlugin(depId)) {
                 LOG_ERROR("PluginManager", QString("Failed to activate dependency %1 for plugin %2").arg(depId, pluginId));
                 return false;
@@ -409,44 +815,60 @@ bool PluginManager::activatePlugin(const QString& pluginId)
     }
 
     // Activate plugin
-    IPlugin* plugin = m_plugins[pluginId];
+    IPlugin* plugin = m_registry.instance(PluginHandle::find(pluginId));
+
+    emit pluginProgress(pluginId, LifecycleStage::Activating);
 
     try {
-        if (!plugin->activate()) {
+        PROFILE_PLUGIN_SCOPE("IPlugin::activate", pluginId);
+        if (!invokeOnPluginThread(plugin, &IPlugin::activate)) {
             LOG_ERROR("PluginManager", QString("Failed to activate plugin: %1").arg(pluginId));
-            m_pluginStates[pluginId] = PluginState::Failed;
+            setPluginState(pluginId, PluginState::Failed);
             emit pluginFailed(pluginId, "Failed to activate");
             return false;
         }
     } catch (const PluginException& ex) {
         LOG_ERROR("PluginManager", QString("Exception during plugin activation: %1").arg(ex.getMessage()));
-        m_pluginStates[pluginId] = PluginState::Failed;
+        setPluginState(pluginId, PluginState::Failed);
         emit pluginFailed(pluginId, QString("Exception during activation: %1").arg(ex.getMessage()));
         return false;
     } catch (const std::exception& ex) {
         LOG_ERROR("PluginManager", QString("Exception during plugin activation: %1").arg(ex.what()));
-        m_pluginStates[pluginId] = PluginState::Failed;
+        setPluginState(pluginId, PluginState::Failed);
         emit pluginFailed(pluginId, QString("Exception during activation: %1").arg(ex.what()));
         return false;
     } catch (...) {
         LOG_ERROR("PluginManager", "Unknown exception during plugin activation");
-        m_pluginStates[pluginId] = PluginState::Failed;
+        setPluginState(pluginId, PluginState::Failed);
         emit pluginFailed(pluginId, "Unknown exception during activation");
         return false;
     }
 
-    m_pluginStates[pluginId] = PluginState::Active;
+    setPluginState(pluginId, PluginState::Active);
+
+    // Activating an unrealized proxy runs no plugin code; its use is recorded once the library is loaded
+    if (isPluginRealized(pluginId)) {
+        m_usageHistory.recordActivation(pluginId);
+    }
 
     LOG_INFO("PluginManager", QString("Activated plugin: %1").arg(pluginId));
 
     emit pluginActivated(pluginId);
 
+    // Dependents left inactive by a failed reload come back with the plugin
+    const QStringList deferredPluginIds = m_deferredReactivations.take(pluginId);
+    for (const QString& depId : deferredPluginIds) {
+        if (isPluginLoaded(depId) && pluginState(depId) == PluginState::Inactive) {
+            activatePlugin(depId);
+        }
+    }
+
     return true;
 }
 
 bool PluginManager::deactivatePlugin(const QString& pluginId)
 {
-    QRecursiveMutexLocker locker(&m_mutex);
+    QMutexLocker locker(&m_mutex);
 
     if (!m_initialized) {
         LOG_ERROR("PluginManager", "Not initialized");
@@ -458,19 +880,17 @@ bool PluginManager::deactivatePlugin(const QString& pluginId)
         return false;
     }
 
-    if (m_pluginStates[pluginId] != PluginState::Active) {
+    if (pluginState(pluginId) != PluginState::Active) {
         LOG_WARNING("PluginManager", QString("Plugin not active: %1").arg(pluginId));
         return true;
     }
 
     // Check if other active plugins depend on this one
     QStringList dependentPlugins;
-    for (auto it = m_plugins.begin(); it != m_plugins.end(); ++it) {
-        if (it.key() != pluginId && m_pluginStates[it.key()] == PluginState::Active) {
-            const PluginMetadata& metadata = m_pluginMetadata[it.key()];
-            if (metadata.dependsOn(pluginId)) {
-                dependentPlugins.append(it.key());
-            }
+    const QStringList dependents = m_dependencyGraph.dependents(pluginId);
+    for (const QString& depId : dependents) {
+        if (pluginState(depId) == PluginState::Active) {
+            dependentPlugins.append(depId);
         }
     }
 
@@ -482,26 +902,41 @@ bool PluginManager::deactivatePlugin(const QString& pluginId)
         }
     }
 
+    // Wait for running commands so none of them sees a half-deactivated plugin
+    if (!drainPluginCommands(pluginId)) {
+        LOG_ERROR("PluginManager", QString("Cannot deactivate plugin %1 because commands are still running").arg(pluginId));
+        endCommandDrain(pluginId);
+        return false;
+    }
+
     // Deactivate plugin
-    IPlugin* plugin = m_plugins[pluginId];
+    IPlugin* plugin = m_registry.instance(PluginHandle::find(pluginId));
+    bool deactivated = false;
+
+    emit pluginProgress(pluginId, LifecycleStage::Deactivating);
 
     try {
-        if (!plugin->deactivate()) {
+        deactivated = invokeOnPluginThread(plugin, &IPlugin::deactivate);
+        if (!deactivated) {
             LOG_ERROR("PluginManager", QString("Failed to deactivate plugin: %1").arg(pluginId));
-            return false;
         }
     } catch (const PluginException& ex) {
         LOG_ERROR("PluginManager", QString("Exception during plugin deactivation: %1").arg(ex.getMessage()));
-        return false;
     } catch (const std::exception& ex) {
         LOG_ERROR("PluginManager", QString("Exception during plugin deactivation: %1").arg(ex.what()));
-        return false;
     } catch (...) {
         LOG_ERROR("PluginManager", "Unknown exception during plugin deactivation");
-        return false;
     }
 
-    m_pluginStates[pluginId] = PluginState::Initialized;
+    if (deactivated) {
+        setPluginState(pluginId, PluginState::Inactive);
+    }
+
+    endCommandDrain(pluginId);
+
+    if (!deactivated) {
+        return false;
+    }
 
     LOG_INFO("PluginManager", QString("Deactivated plugin: %1").arg(pluginId));
 
@@ -510,251 +945,2694 @@ bool PluginManager::deactivatePlugin(const QString& pluginId)
     return true;
 }
 
-IPlugin* PluginManager::getPlugin(const QString& pluginId) const
+QList<PluginLevelReport> PluginManager::loadAll()
 {
-    QRecursiveMutexLocker locker(&m_mutex);
-
-    if (!m_initialized) {
-        LOG_ERROR("PluginManager", "Not initialized");
-        return nullptr;
-    }
+    QList<QStringList> levels;
 
-    return m_plugins.value(pluginId, nullptr);
-}
+    {
+        QMutexLocker locker(&m_mutex);
 
-QMap<QString, IPlugin*> PluginManager::getLoadedPlugins() const
-{
-    QRecursiveMutexLocker locker(&m_mutex);
+        if (!m_initialized) {
+            LOG_ERROR("PluginManager", "Not initialized");
+            return QList<PluginLevelReport>();
+        }
 
-    if (!m_initialized) {
-        LOG_ERROR("PluginManager", "Not initialized");
-        return QMap<QString, IPlugin*>();
+        levels = groupPluginsByLevel(sortPluginsByDependency(m_registry.availablePluginIds()));
     }
 
-    return m_plugins;
-}
+    QList<PluginLevelReport> reports;
+    QSet<QString> failedPlugins;
+    QElapsedTimer timer;
 
-QMap<QString, IPlugin*> PluginManager::getActivePlugins() const
-{
-    QRecursiveMutexLocker locker(&m_mutex);
+    for (int level = 0; level < levels.size(); ++level) {
+        PluginLevelReport report;
+        report.level = level;
+        report.pluginIds = levels[level];
 
-    if (!m_initialized) {
-        LOG_ERROR("PluginManager", "Not initialized");
-        return QMap<QString, IPlugin*>();
-    }
+        timer.start();
+        QStringList loadedPluginIds = loadPluginLevel(report.pluginIds, failedPlugins);
+        report.loadMs = timer.restart();
 
-    QMap<QString, IPlugin*> activePlugins;
+        initializePluginLevel(loadedPluginIds, failedPlugins);
+        report.initializeMs = timer.elapsed();
 
-    for (auto it = m_plugins.begin(); it != m_plugins.end(); ++it) {
-        if (m_pluginStates[it.key()] == PluginState::Active) {
-            activePlugins.insert(it.key(), it.value());
+        for (const QString& pluginId : report.pluginIds) {
+            if (failedPlugins.contains(pluginId)) {
+                report.failedPluginIds.append(pluginId);
+            }
         }
-    }
 
-    return activePlugins;
-}
-
-PluginState PluginManager::getPluginState(const QString& pluginId) const
-{
-    QRecursiveMutexLocker locker(&m_mutex);
+        LOG_INFO("PluginManager", QString("Level %1: loaded %2 plugins in %3 ms, initialized in %4 ms, %5 failed")
+                 .arg(level).arg(report.pluginIds.size()).arg(report.loadMs).arg(report.initializeMs)
+                 .arg(report.failedPluginIds.size()));
 
-    if (!m_initialized) {
-        LOG_ERROR("PluginManager", "Not initialized");
-        return PluginState::NotLoaded;
+        reports.append(report);
     }
 
-    return m_pluginStates.value(pluginId, PluginState::NotLoaded);
+    return reports;
 }
 
-PluginMetadata PluginManager::getPluginMetadata(const QString& pluginId) const
+QList<PluginLevelReport> PluginManager::activateAll()
 {
-    QRecursiveMutexLocker locker(&m_mutex);
+    QList<PluginLevelReport> reports = loadAll();
+    QElapsedTimer timer;
 
-    if (!m_initialized) {
-        LOG_ERROR("PluginManager", "Not initialized");
-        return PluginMetadata();
-    }
+    for (PluginLevelReport& report : reports) {
+        timer.start();
 
-    return m_pluginMetadata.value(pluginId, PluginMetadata());
-}
+        for (const QString& pluginId : report.pluginIds) {
+            if (report.failedPluginIds.contains(pluginId)) {
+                continue;
+            }
 
-QMap<QString, PluginMetadata> PluginManager::getAvailablePlugins() const
-{
-    QRecursiveMutexLocker locker(&m_mutex);
+            if (!activatePlugin(pluginId)) {
+                report.failedPluginIds.append(pluginId);
+            }
+        }
 
-    if (!m_initialized) {
-        LOG_ERROR("PluginManager", "Not initialized");
-        return QMap<QString, PluginMetadata>();
+        report.activateMs = timer.elapsed();
+
+        LOG_INFO("PluginManager", QString("Level %1: activated in %2 ms").arg(report.level).arg(report.activateMs));
     }
 
-    return m_pluginMetadata;
+    return reports;
 }
 
-bool PluginManager::isPluginLoaded(const QString& pluginId) const
+QFuture<bool> PluginManager::loadPluginAsync(const QString& pluginId)
 {
-    QRecursiveMutexLocker locker(&m_mutex);
+    return QtConcurrent::run(&m_lifecyclePool, [this, pluginId]() {
+        return loadPlugin(pluginId);
+    });
+}
 
-    if (!m_initialized) {
-        LOG_ERROR("PluginManager", "Not initialized");
-        return false;
-    }
+QFuture<bool> PluginManager::activatePluginAsync(const QString& pluginId)
+{
+    return QtConcurrent::run(&m_lifecyclePool, [this, pluginId]() {
+        return activatePlugin(pluginId);
+    });
+}
 
-    return m_plugins.contains(pluginId);
+QFuture<bool> PluginManager::deactivatePluginAsync(const QString& pluginId)
+{
+    return QtConcurrent::run(&m_lifecyclePool, [this, pluginId]() {
+        return deactivatePlugin(pluginId);
+    });
 }
 
-bool PluginManager::isPluginActive(const QString& pluginId) const
+QFuture<bool> PluginManager::unloadPluginAsync(const QString& pluginId)
 {
-    QRecursiveMutexLocker locker(&m_mutex);
+    return QtConcurrent::run(&m_lifecyclePool, [this, pluginId]() {
+        return unloadPlugin(pluginId);
+    });
+}
 
-    if (!m_initialized) {
-        LOG_ERROR("PluginManager", "Not initialized");
+bool PluginManager::reloadPlugin(const QString& pluginId)
+{
+    // Running commands and message handlers may need the lifecycle lock to finish, so wait
+    // for them before taking it
+    if (!drainPluginCommands(pluginId)) {
+        LOG_ERROR("PluginManager", QString("Cannot reload plugin %1 because commands are still running").arg(pluginId));
+        endCommandDrain(pluginId);
         return false;
     }
+    suspendPluginMailbox(pluginId);
 
-    return m_pluginStates.value(pluginId, PluginState::NotLoaded) == PluginState::Active;
-}
-
-QVariant PluginManager::executePluginCommand(const QString& pluginId, const QString& command, const QVariantMap& params)
-{
-    QRecursiveMutexLocker locker(&m_mutex);
+    QMutexLocker locker(&m_mutex);
 
     if (!m_initialized) {
         LOG_ERROR("PluginManager", "Not initialized");
-        return QVariant();
+        PluginCommunication::instance().resumeMailbox(pluginId);
+        endCommandDrain(pluginId);
+        return false;
     }
 
     if (!isPluginLoaded(pluginId)) {
         LOG_ERROR("PluginManager", QString("Plugin not loaded: %1").arg(pluginId));
-        return QVariant();
+        PluginCommunication::instance().resumeMailbox(pluginId);
+        endCommandDrain(pluginId);
+        return false;
     }
 
-    if (!isPluginActive(pluginId)) {
-        LOG_ERROR("PluginManager", QString("Plugin not active: %1").arg(pluginId));
-        return QVariant();
+    LOG_INFO("PluginManager", QString("Reloading plugin: %1").arg(pluginId));
+
+    PluginState previousState = pluginState(pluginId);
+
+    // A plugin whose last reload failed was active before, and is brought back to that
+    if (m_deferredReactivations.contains(pluginId)) {
+        previousState = PluginState::Active;
     }
 
-    IPlugin* plugin = m_plugins[pluginId];
+    // Deactivate active dependents, each before the plugins it needs
+    QStringList reactivatePlugins;
+    const QStringList dependents = m_dependencyGraph.transitiveDependents(pluginId);
+    for (const QString& depId : dependents) {
+        if (pluginState(depId) != PluginState::Active) {
+            continue;
+        }
 
+        if (!deactivatePlugin(depId)) {
+            LOG_ERROR("PluginManager", QString("Failed to deactivate dependent plugin %1 for reload of %2").arg(depId, pluginId));
+            activatePlugins(reactivatePlugins);
+            PluginCommunication::instance().resumeMailbox(pluginId);
+            endCommandDrain(pluginId);
+            return false;
+        }
+
+        reactivatePlugins.prepend(depId);
+    }
+
+    QVariant reloadState;
+    bool released = releasePlugin(pluginId, &reloadState);
+    endCommandDrain(pluginId);
+
+    if (!released) {
+        LOG_ERROR("PluginManager", QString("Failed to unload plugin for reload: %1").arg(pluginId));
+        PluginCommunication::instance().resumeMailbox(pluginId);
+        activatePlugins(reactivatePlugins);
+        return false;
+    }
+
+    // The point of a reload is the new library, so it is loaded right away even in lazy mode
+    if (!loadPluginInstance(pluginId, false)) {
+        LOG_ERROR("PluginManager", QString("Failed to load new library of plugin: %1").arg(pluginId));
+        PluginCommunication::instance().resumeMailbox(pluginId);
+        deferReactivation(pluginId, reactivatePlugins);
+        return false;
+    }
+
+    if (previousState == PluginState::Initialized || previousState == PluginState::Active || previousState == PluginState::Inactive) {
+        if (!initializePlugin(pluginId)) {
+            PluginCommunication::instance().resumeMailbox(pluginId);
+            deferReactivation(pluginId, reactivatePlugins);
+            return false;
+        }
+
+        restoreReloadState(pluginId, m_registry.instance(PluginHandle::find(pluginId)), reloadState);
+    }
+
+    if (previousState == PluginState::Active && !activatePlugin(pluginId)) {
+        PluginCommunication::instance().resumeMailbox(pluginId);
+        deferReactivation(pluginId, reactivatePlugins);
+        return false;
+    }
+
+    // Messages posted during the reload go to the new instance
+    PluginCommunication::instance().resumeMailbox(pluginId);
+
+    activatePlugins(reactivatePlugins);
+
+    LOG_INFO("PluginManager", QString("Reloaded plugin: %1").arg(pluginId));
+
+    emit pluginReloaded(pluginId);
+
+    return true;
+}
+
+QFuture<bool> PluginManager::reloadPluginAsync(const QString& pluginId)
+{
+    return QtConcurrent::run(&m_lifecyclePool, [this, pluginId]() {
+        return reloadPlugin(pluginId);
+    });
+}
+
+void PluginManager::setHotReloadEnabled(bool enable)
+{
+    if (enable == isHotReloadEnabled()) {
+        return;
+    }
+
+    if (!enable) {
+        delete m_libraryWatcher;
+        delete m_reloadTimer;
+        m_libraryWatcher = nullptr;
+        m_reloadTimer = nullptr;
+
+        LOG_INFO("PluginManager", "Hot reload disabled");
+        return;
+    }
+
+    // Library writes arrive as bursts of change notifications, so act once they settle
+    m_reloadTimer = new QTimer(this);
+    m_reloadTimer->setSingleShot(true);
+    m_reloadTimer->setInterval(500);
+
+    m_libraryWatcher = new QFileSystemWatcher(this);
+    connect(m_libraryWatcher, &QFileSystemWatcher::directoryChanged, m_reloadTimer, QOverload<>::of(&QTimer::start));
+    connect(m_libraryWatcher, &QFileSystemWatcher::fileChanged, m_reloadTimer, QOverload<>::of(&QTimer::start));
+    connect(m_reloadTimer, &QTimer::timeout, this, [this]() {
+        // Replacing a file drops it from the watcher, so watch the current libraries again
+        watchPluginLibraries();
+        m_lifecyclePool.start([this]() {
+            reloadChangedPlugins();
+        });
+    });
+    connect(this, &PluginManager::pluginLoaded, m_libraryWatcher, [this]() {
+        watchPluginLibraries();
+    });
+
+    watchPluginLibraries();
+
+    LOG_INFO("PluginManager", "Hot reload enabled");
+}
+
+bool PluginManager::isHotReloadEnabled() const
+{
+    return m_libraryWatcher != nullptr;
+}
+
+void PluginManager::setIdleTimeout(int timeoutMs)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_idleTimeout = qMax(0, timeoutMs);
+    }
+
+    updateIdleTimer();
+}
+
+int PluginManager::getIdleTimeout() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_idleTimeout;
+}
+
+void PluginManager::setPluginIdleTimeout(const QString& pluginId, int timeoutMs)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (timeoutMs < 0) {
+            m_pluginIdleTimeouts.remove(pluginId);
+        } else {
+            m_pluginIdleTimeouts.insert(pluginId, timeoutMs);
+        }
+    }
+
+    updateIdleTimer();
+}
+
+void PluginManager::setMaxLoadedPlugins(int maxPlugins)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_maxLoadedPlugins = qMax(0, maxPlugins);
+    }
+
+    updateIdleTimer();
+}
+
+int PluginManager::getMaxLoadedPlugins() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_maxLoadedPlugins;
+}
+
+QStringList PluginManager::unloadIdlePlugins()
+{
+    struct Candidate {
+        QString pluginId;
+        qint64 lastUsedMs;
+        int timeoutMs;
+    };
+
+    // Plugins whose library is loaded, least recently used first. They are picked under
+    // the lifecycle lock, and each eviction takes it again on its own, so that the lock
+    // is not held from one plugin's thread call to the next.
+    QList<Candidate> candidates;
+    qint64 nowMs = m_idleClock.elapsed();
+    int maxLoadedPlugins = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // The idle timer keeps running across shutdown(), so this is not an error
+        if (!m_initialized) {
+            return QStringList();
+        }
+
+        maxLoadedPlugins = m_maxLoadedPlugins;
+
+        QMutexLocker pinLocker(&m_pinMutex);
+
+        const QList<PluginHandle> handles = m_registry.loadedPlugins();
+        for (const PluginHandle& handle : handles) {
+            LazyPluginProxy* proxy = m_registry.proxy(handle);
+            if ((proxy && !proxy->isRealized()) || m_registry.state(handle) == PluginState::Failed) {
+                continue;
+            }
+
+            // A plugin that has not been used since tracking started counts as used now
+            auto it = m_lastUsed.constFind(handle);
+            if (it == m_lastUsed.constEnd()) {
+                it = m_lastUsed.insert(handle, nowMs);
+            }
+            QString pluginId = handle.pluginId();
+            candidates.append(Candidate{pluginId, it.value(), m_pluginIdleTimeouts.value(pluginId, m_idleTimeout)});
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.lastUsedMs < b.lastUsedMs;
+    });
+
+    QStringList evictedPluginIds;
+    int loadedCount = candidates.size();
+
+    for (const Candidate& candidate : candidates) {
+        bool idle = candidate.timeoutMs > 0 && nowMs - candidate.lastUsedMs >= candidate.timeoutMs;
+        bool overLimit = maxLoadedPlugins > 0 && loadedCount > maxLoadedPlugins;
+        if (!idle && !overLimit) {
+            continue;
+        }
+
+        if (evictPlugin(candidate.pluginId)) {
+            evictedPluginIds.append(candidate.pluginId);
+            --loadedCount;
+        }
+    }
+
+    if (!evictedPluginIds.isEmpty()) {
+        LOG_INFO("PluginManager", QString("Unloaded idle plugins: %1, %2 plugins remain loaded")
+                 .arg(evictedPluginIds.join(", ")).arg(loadedCount));
+    }
+
+    return evictedPluginIds;
+}
+
+void PluginManager::markPluginUsed(const QString& pluginId)
+{
+    PluginHandle handle = PluginHandle::find(pluginId);
+    if (!handle.isValid()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_pinMutex);
+    m_lastUsed.insert(handle, m_idleClock.elapsed());
+}
+
+void PluginManager::updateIdleTimer()
+{
+    // Check at half the shortest timeout, so that a plugin stays loaded at most 1.5 times as long
+    int intervalMs = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (m_idleTimeout > 0) {
+            intervalMs = m_idleTimeout / 2;
+        }
+        const QList<int> pluginTimeouts = m_pluginIdleTimeouts.values();
+        for (int timeoutMs : pluginTimeouts) {
+            if (timeoutMs > 0 && (intervalMs == 0 || timeoutMs / 2 < intervalMs)) {
+                intervalMs = timeoutMs / 2;
+            }
+        }
+        if (intervalMs == 0 && m_maxLoadedPlugins > 0) {
+            intervalMs = 30000;
+        }
+    }
+
+    if (intervalMs == 0) {
+        delete m_idleTimer;
+        m_idleTimer = nullptr;
+        return;
+    }
+
+    if (!m_idleTimer) {
+        m_idleTimer = new QTimer(this);
+        connect(m_idleTimer, &QTimer::timeout, this, [this]() {
+            m_lifecyclePool.start([this]() {
+                unloadIdlePlugins();
+            });
+        });
+    }
+
+    m_idleTimer->start(qBound(1000, intervalMs, 60000));
+}
+
+bool PluginManager::evictPlugin(const QString& pluginId)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_initialized) {
+        return false;
+    }
+
+    // The plugin may have changed since it was picked
+    IPlugin* plugin = m_registry.instance(PluginHandle::find(pluginId));
+    LazyPluginProxy* proxy = m_registry.proxy(PluginHandle::find(pluginId));
+    if (!plugin || (proxy && !proxy->isRealized()) || pluginState(pluginId) == PluginState::Failed) {
+        return false;
+    }
+
+    // A dependent running real code may call into this plugin at any time
+    const QStringList dependents = m_dependencyGraph.dependents(pluginId);
+    for (const QString& depId : dependents) {
+        if (isPluginLoaded(depId) && isPluginRealized(depId)) {
+            return false;
+        }
+    }
+
+    // A running timer means the plugin does work of its own, such as scheduled backups
+    if (hasActiveTimers(plugin)) {
+        return false;
+    }
+
+    // Leave a plugin alone while it runs a command or handles a message; the next check tries again
+    if (!drainPluginCommands(pluginId, QDeadlineTimer(0)) || !suspendPluginMailbox(pluginId, QDeadlineTimer(0))) {
+        PluginCommunication::instance().resumeMailbox(pluginId);
+        endCommandDrain(pluginId);
+        return false;
+    }
+
+    PluginState state = pluginState(pluginId);
+    QVariant reloadState;
+    bool released = releasePlugin(pluginId, &reloadState);
+    endCommandDrain(pluginId);
+
+    if (!released) {
+        LOG_WARNING("PluginManager", QString("Failed to unload idle plugin: %1").arg(pluginId));
+        PluginCommunication::instance().resumeMailbox(pluginId);
+        return false;
+    }
+
+    // The proxy remembers the state, so the next command or message replays it on a fresh instance
+    if (reloadState.isValid()) {
+        m_evictedStates.insert(pluginId, reloadState);
+    }
+    attachLazyProxy(pluginId, state);
+
+    // Messages posted meanwhile load the plugin again through the proxy
+    PluginCommunication::instance().resumeMailbox(pluginId);
+
+    // Unloading reported the plugin deactivated and unloaded, and the host took its menu down;
+    // to everyone outside the manager it is still active
+    if (state == PluginState::Active) {
+        emit pluginActivated(pluginId);
+    }
+
+    saveUsageHistory();
+
+    LOG_INFO("PluginManager", QString("Unloaded idle plugin: %1").arg(pluginId));
+
+    return true;
+}
+
+bool PluginManager::hasActiveTimers(IPlugin* plugin)
+{
+    QObject* context = pluginContext(plugin);
+    bool active = false;
+
+    runOnPluginThread(plugin, [context, &active]() {
+        const QList<QTimer*> timers = context->findChildren<QTimer*>();
+        for (QTimer* timer : timers) {
+            if (timer->isActive()) {
+                active = true;
+                break;
+            }
+        }
+    });
+
+    return active;
+}
+
+void PluginManager::restoreReloadState(const QString& pluginId, IPlugin* plugin, const QVariant& reloadState)
+{
+    IHotReloadable* reloadable = plugin ? qobject_cast<IHotReloadable*>(pluginContext(plugin)) : nullptr;
+    if (!reloadable || !reloadState.isValid()) {
+        return;
+    }
+
+    try {
+        bool restored = false;
+        runOnPluginThread(plugin, [reloadable, &reloadState, &restored]() {
+            restored = reloadable->restoreReloadState(reloadState);
+        });
+        if (!restored) {
+            LOG_WARNING("PluginManager", QString("Plugin %1 rejected its reload state").arg(pluginId));
+        }
+    } catch (const PluginException& ex) {
+        LOG_WARNING("PluginManager", QString("Exception while restoring reload state of %1: %2").arg(pluginId, ex.getMessage()));
+    } catch (const std::exception& ex) {
+        LOG_WARNING("PluginManager", QString("Exception while restoring reload state of %1: %2").arg(pluginId, ex.what()));
+    } catch (...) {
+        LOG_WARNING("PluginManager", QString("Unknown exception while restoring reload state of %1").arg(pluginId));
+    }
+}
+
+IPlugin* PluginManager::getPlugin(const QString& pluginId) const
+{
+    return getPlugin(PluginHandle::find(pluginId));
+}
+
+IPlugin* PluginManager::getPlugin(PluginHandle handle) const
+{
+    QReadLocker locker(&m_stateLock);
+
+    if (!m_initialized) {
+        LOG_ERROR("PluginManager", "Not initialized");
+        return nullptr;
+    }
+
+    return m_registry.instance(handle);
+}
+
+PluginHandle PluginManager::getPluginHandle(const QString& pluginId) const
+{
+    return PluginHandle::find(pluginId);
+}
+
+QMap<QString, IPlugin*> PluginManager::getLoadedPlugins() const
+{
+    QReadLocker locker(&m_stateLock);
+
+    if (!m_initialized) {
+        LOG_ERROR("PluginManager", "Not initialized");
+        return QMap<QString, IPlugin*>();
+    }
+
+    QMap<QString, IPlugin*> loadedPlugins;
+
+    const QList<PluginHandle> handles = m_registry.loadedPlugins();
+    for (PluginHandle handle : handles) {
+        loadedPlugins.insert(handle.pluginId(), m_registry.instance(handle));
+    }
+
+    return loadedPlugins;
+}
+
+QMap<QString, IPlugin*> PluginManager::getActivePlugins() const
+{
+    QReadLocker locker(&m_stateLock);
+
+    if (!m_initialized) {
+        LOG_ERROR("PluginManager", "Not initialized");
+        return QMap<QString, IPlugin*>();
+    }
+
+    QMap<QString, IPlugin*> activePlugins;
+
+    const QList<PluginHandle> handles = m_registry.loadedPlugins();
+    for (PluginHandle handle : handles) {
+        if (m_registry.state(handle) == PluginState::Active) {
+            activePlugins.insert(handle.pluginId(), m_registry.instance(handle));
+        }
+    }
+
+    return activePlugins;
+}
+
+PluginState PluginManager::getPluginState(const QString& pluginId) const
+{
+    return getPluginState(PluginHandle::find(pluginId));
+}
+
+PluginState PluginManager::getPluginState(PluginHandle handle) const
+{
+    // Before initialize() and after shutdown() every slot reads NotLoaded
+    return m_registry.state(handle);
+}
+
+PluginMetadata PluginManager::getPluginMetadata(const QString& pluginId) const
+{
+    QReadLocker locker(&m_stateLock);
+
+    if (!m_initialized) {
+        LOG_ERROR("PluginManager", "Not initialized");
+        return PluginMetadata();
+    }
+
+    return m_registry.metadata(PluginHandle::find(pluginId));
+}
+
+QStringList PluginManager::getInstalledVersions(const QString& pluginId) const
+{
+    QReadLocker locker(&m_stateLock);
+
+    QStringList versions;
+    const QList<PluginMetadata> installed = m_versionResolver.versions(pluginId);
+    for (const PluginMetadata& metadata : installed) {
+        versions.append(metadata.getPluginVersion());
+    }
+
+    return versions;
+}
+
+bool PluginManager::setPluginVersion(const QString& pluginId, const QString& version)
+{
+    QVersionNumber versionNumber;
+    if (!version.isEmpty()) {
+        int suffixIndex = 0;
+        versionNumber = QVersionNumber::fromString(version, &suffixIndex);
+        if (versionNumber.isNull() || suffixIndex != version.size()) {
+            LOG_ERROR("PluginManager", QString("Invalid version %1 for plugin %2").arg(version, pluginId));
+            return false;
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    QWriteLocker stateLocker(&m_stateLock);
+
+    m_versionResolver.setPinnedVersion(pluginId, versionNumber);
+    applyResolvedVersions();
+
+    return true;
+}
+
+QString PluginManager::getVersionConflict(const QString& pluginId) const
+{
+    QReadLocker locker(&m_stateLock);
+
+    return m_versionResolver.conflict(pluginId);
+}
+
+QMap<QString, PluginMetadata> PluginManager::getAvailablePlugins() const
+{
+    QReadLocker locker(&m_stateLock);
+
+    if (!m_initialized) {
+        LOG_ERROR("PluginManager", "Not initialized");
+        return QMap<QString, PluginMetadata>();
+    }
+
+    QMap<QString, PluginMetadata> availablePlugins;
+
+    const QStringList pluginIds = m_registry.availablePluginIds();
+    for (const QString& pluginId : pluginIds) {
+        availablePlugins.insert(pluginId, m_registry.metadata(PluginHandle::find(pluginId)));
+    }
+
+    return availablePlugins;
+}
+
+bool PluginManager::isPluginLoaded(const QString& pluginId) const
+{
+    return isPluginLoaded(PluginHandle::find(pluginId));
+}
+
+bool PluginManager::isPluginLoaded(PluginHandle handle) const
+{
+    return m_registry.isLoaded(handle);
+}
+
+bool PluginManager::isPluginActive(const QString& pluginId) const
+{
+    return isPluginActive(PluginHandle::find(pluginId));
+}
+
+bool PluginManager::isPluginActive(PluginHandle handle) const
+{
+    return m_registry.state(handle) == PluginState::Active;
+}
+
+QVariant PluginManager::executePluginCommand(const QString& pluginId, const QString& command, const QVariantMap& params)
+{
+    PluginHandle handle = PluginHandle::find(pluginId);
+    if (!handle.isValid()) {
+        LOG_ERROR("PluginManager", QString("Plugin not loaded: %1").arg(pluginId));
+        return QVariant();
+    }
+
+    return executePluginCommand(handle, command, params);
+}
+
+QVariant PluginManager::executePluginCommand(PluginHandle handle, const QString& command, const QVariantMap& params)
+{
+    QSharedPointer<QRecursiveMutex> commandMutex = pinPlugin(handle);
+    if (!commandMutex) {
+        LOG_ERROR("PluginManager", QString("Plugin is being deactivated or unloaded: %1").arg(handle.pluginId()));
+        return QVariant();
+    }
+
+    QVariant result = runPluginCommand(handle, -1, command, params, commandMutex.data());
+
+    unpinPlugin(handle);
+
+    return result;
+}
+
+QVariant PluginManager::executePluginCommand(PluginHandle handle, int commandId, const QVariantMap& params)
+{
+    QSharedPointer<QRecursiveMutex> commandMutex = pinPlugin(handle);
+    if (!commandMutex) {
+        LOG_ERROR("PluginManager", QString("Plugin is being deactivated or unloaded: %1").arg(handle.pluginId()));
+        return QVariant();
+    }
+
+    QVariant result = runPluginCommand(handle, commandId, QString(), params, commandMutex.data());
+
+    unpinPlugin(handle);
+
+    return result;
+}
+
+QFuture<QVariant> PluginManager::executePluginCommandAsync(const QString& pluginId, const QString& command, const QVariantMap& params)
+{
+    return postPluginCommand(pluginId, -1, command, params);
+}
+
+QFuture<QVariant> PluginManager::executePluginCommandAsync(const QString& pluginId, int commandId, const QVariantMap& params)
+{
+    return postPluginCommand(pluginId, commandId, QString(), params);
+}
+
+namespace {
+
+struct CommandRequestGroup {
+    PluginHandle handle;
+    QString pluginId;
+    IPlugin* plugin = nullptr;
+    QVector<int> requestIndices;                    // Into the request list, in submission order
+    QVector<ICommandProvider*> providers;           // Per request, null to dispatch by name
+    QVector<int> commandIds;                        // Per request, resolved command ID
+    QSharedPointer<QRecursiveMutex> commandMutex;
+};
+
+} // namespace
+
+QList<CommandResult> PluginManager::executePluginCommands(const QList<CommandRequest>& requests)
+{
+    QList<CommandResult> results(requests.size());
+    CommandResult* resultData = results.data();
+
+    // Lazy plugins publish their commands once realized, so load them before validating
+    QStringList unrealizedPlugins;
+    {
+        QReadLocker locker(&m_stateLock);
+
+        for (const CommandRequest& request : requests) {
+            LazyPluginProxy* proxy = m_registry.proxy(PluginHandle::find(request.pluginId));
+            if (proxy && !proxy->isRealized() && !unrealizedPlugins.contains(request.pluginId)) {
+                unrealizedPlugins.append(request.pluginId);
+            }
+        }
+    }
+
+    for (const QString& pluginId : unrealizedPlugins) {
+        if (!realizePlugin(pluginId)) {
+            LOG_ERROR("PluginManager", QString("Failed to load lazy plugin: %1").arg(pluginId));
+        }
+    }
+
+    // Validate every request and group them by plugin under one lock
+    QVector<CommandRequestGroup> groups;
+    QHash<PluginHandle, int> groupIndices;
+    {
+        QReadLocker locker(&m_stateLock);
+
+        if (!m_initialized) {
+            for (CommandResult& result : results) {
+                result.errorMessage = "Not initialized";
+            }
+            return results;
+        }
+
+        for (int i = 0; i < requests.size(); ++i) {
+            const CommandRequest& request = requests[i];
+            PluginHandle handle = PluginHandle::find(request.pluginId);
+
+            IPlugin* plugin = m_registry.instance(handle);
+            if (!plugin) {
+                resultData[i].errorMessage = QString("Plugin not loaded: %1").arg(request.pluginId);
+                continue;
+            }
+
+            if (m_registry.state(handle) != PluginState::Active) {
+                resultData[i].errorMessage = QString("Plugin not active: %1").arg(request.pluginId);
+                continue;
+            }
+
+            // Resolve names of published commands to IDs so the plugin skips its name lookup
+            ICommandProvider* provider = m_registry.commandProvider(handle);
+            const PluginCommandDescriptor* descriptor = nullptr;
+            if (request.commandId >= 0) {
+                descriptor = m_registry.command(handle, request.commandId);
+                if (!descriptor || !provider) {
+                    resultData[i].errorMessage = QString("Unknown command %1 for plugin %2").arg(request.commandId).arg(request.pluginId);
+                    continue;
+                }
+            } else if (provider) {
+                for (const PluginCommandDescriptor& candidate : m_registry.commands(handle)) {
+                    if (candidate.name == request.command) {
+                        descriptor = m_registry.command(handle, candidate.id);
+                        break;
+                    }
+                }
+            }
+
+            if (descriptor) {
+                QString errorMessage = checkCommandParameters(request.pluginId, *descriptor, request.params);
+                if (!errorMessage.isEmpty()) {
+                    resultData[i].errorMessage = errorMessage;
+                    continue;
+                }
+            }
+
+            auto it = groupIndices.constFind(handle);
+            if (it == groupIndices.constEnd()) {
+                it = groupIndices.insert(handle, groups.size());
+                groups.append(CommandRequestGroup());
+                groups.last().handle = handle;
+                groups.last().pluginId = request.pluginId;
+                groups.last().plugin = plugin;
+            }
+
+            CommandRequestGroup& group = groups[it.value()];
+            group.requestIndices.append(i);
+            group.providers.append(descriptor ? provider : nullptr);
+            group.commandIds.append(descriptor ? descriptor->id : -1);
+        }
+    }
+
+    // Pin each plugin once for all of its requests
+    QVector<CommandRequestGroup*> pooledGroups;
+    QVector<CommandRequestGroup*> localGroups;
+    for (CommandRequestGroup& group : groups) {
+        group.commandMutex = pinPlugin(group.handle);
+        if (!group.commandMutex) {
+            for (int index : group.requestIndices) {
+                resultData[index].errorMessage = QString("Plugin is being deactivated or unloaded: %1").arg(group.handle.pluginId());
+            }
+            continue;
+        }
+
+        // Plugins living on this thread run here, since this thread cannot serve their calls
+        // while it waits for the pool
+        if (pluginContext(group.plugin)->thread() == QThread::currentThread()) {
+            localGroups.append(&group);
+        } else {
+            pooledGroups.append(&group);
+        }
+    }
+
+    // Every group runs on the thread that owns its plugin, in one hop, so that plugins using
+    // timers or dialogs see their commands where they expect them; pool threads only wait
+    auto runGroup = [&requests, resultData](CommandRequestGroup* group) {
+        runOnPluginThread(group->plugin, [&requests, resultData, group]() {
+            QRecursiveMutexLocker locker(group->commandMutex.data());
+
+            for (int i = 0; i < group->requestIndices.size(); ++i) {
+                int index = group->requestIndices[i];
+                const CommandRequest& request = requests[index];
+                CommandResult& result = resultData[index];
+
+                result.result = dispatchPluginCommand(group->pluginId, group->plugin, group->providers[i], group->commandIds[i],
+                                                      request.command, request.params, result.errorMessage);
+                result.success = result.errorMessage.isEmpty();
+            }
+        });
+    };
+
+    // Plugins on different threads run in parallel, with the local groups running on this thread meanwhile
+    QFuture<void> pooled = QtConcurrent::map(pooledGroups, runGroup);
+    for (CommandRequestGroup* group : localGroups) {
+        runGroup(group);
+    }
+    pooled.waitForFinished();
+
+    for (const CommandRequestGroup& group : groups) {
+        if (group.commandMutex) {
+            unpinPlugin(group.handle);
+        }
+    }
+
+    int failed = 0;
+    for (const CommandResult& result : results) {
+        if (!result.success) {
+            ++failed;
+        }
+    }
+
+    if (failed > 0) {
+        LOG_WARNING("PluginManager", QString("%1 of %2 batched commands failed").arg(failed).arg(requests.size()));
+    }
+
+    return results;
+}
+
+QList<PluginCommandDescriptor> PluginManager::getPluginCommands(const QString& pluginId) const
+{
+    QReadLocker locker(&m_stateLock);
+
+    return m_registry.commands(PluginHandle::find(pluginId));
+}
+
+QFuture<QVariant> PluginManager::postPluginCommand(const QString& pluginId, int commandId, const QString& command,
+                                                   const QVariantMap& params)
+{
+    QFutureInterface<QVariant> promise;
+    promise.reportStarted();
+    QFuture<QVariant> future = promise.future();
+
+    PluginHandle handle = PluginHandle::find(pluginId);
+    QSharedPointer<QRecursiveMutex> commandMutex = handle.isValid() ? pinPlugin(handle) : QSharedPointer<QRecursiveMutex>();
+    if (!commandMutex) {
+        LOG_ERROR("PluginManager", QString("Plugin not loaded or being deactivated or unloaded: %1").arg(pluginId));
+        promise.reportResult(QVariant());
+        promise.reportFinished();
+        return future;
+    }
+
+    // The pin keeps the plugin, and with it the context object, alive until the command has run
+    QObject* context = nullptr;
+    {
+        QReadLocker locker(&m_stateLock);
+        IPlugin* plugin = m_registry.instance(handle);
+        context = plugin ? pluginContext(plugin) : nullptr;
+    }
+
+    if (!context) {
+        unpinPlugin(handle);
+        promise.reportResult(QVariant());
+        promise.reportFinished();
+        return future;
+    }
+
+    QMetaObject::invokeMethod(context, [this, handle, commandId, command, params, commandMutex, promise]() mutable {
+        QVariant result = runPluginCommand(handle, commandId, command, params, commandMutex.data());
+        unpinPlugin(handle);
+        promise.reportResult(result);
+        promise.reportFinished();
+    }, Qt::QueuedConnection);
+
+    return future;
+}
+
+void PluginManager::setCommandDrainTimeout(int timeoutMs)
+{
+    QMutexLocker locker(&m_pinMutex);
+
+    m_commandDrainTimeout = timeoutMs;
+}
+
+int PluginManager::getCommandDrainTimeout() const
+{
+    QMutexLocker locker(&m_pinMutex);
+
+    return m_commandDrainTimeout;
+}
+
+void PluginManager::setShutdownTimeout(int timeoutMs)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_shutdownTimeout = timeoutMs;
+}
+
+int PluginManager::getShutdownTimeout() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_shutdownTimeout;
+}
+
+void PluginManager::setLazyLoadingEnabled(bool enable)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_lazyLoading = enable;
+
+    LOG_INFO("PluginManager", QString("Lazy loading %1").arg(enable ? "enabled" : "disabled"));
+}
+
+bool PluginManager::isLazyLoadingEnabled() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_lazyLoading;
+}
+
+void PluginManager::setEmbeddedMetadataEnabled(bool enable)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_embeddedMetadata = enable;
+
+    LOG_INFO("PluginManager", QString("Embedded metadata %1").arg(enable ? "enabled" : "disabled"));
+}
+
+void PluginManager::setThreadedPlugins(const QStringList& pluginIds)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_threadedPlugins = QSet<QString>(pluginIds.begin(), pluginIds.end());
+}
+
+bool PluginManager::isPluginThreaded(const QString& pluginId) const
+{
+    QReadLocker locker(&m_stateLock);
+
+    return m_pluginThreads.contains(pluginId);
+}
+
+bool PluginManager::isEmbeddedMetadataEnabled() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_embeddedMetadata;
+}
+
+bool PluginManager::realizePlugin(const QString& pluginId)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_initialized) {
+        LOG_ERROR("PluginManager", "Not initialized");
+        return false;
+    }
+
+    if (!isPluginLoaded(pluginId)) {
+        LOG_ERROR("PluginManager", QString("Plugin not loaded: %1").arg(pluginId));
+        return false;
+    }
+
+    LazyPluginProxy* proxy = m_registry.proxy(PluginHandle::find(pluginId));
+    if (!proxy || proxy->isRealized()) {
+        return true;
+    }
+
+    if (pluginState(pluginId) == PluginState::Failed) {
+        LOG_ERROR("PluginManager", QString("Plugin in failed state: %1").arg(pluginId));
+        return false;
+    }
+
+    // The real plugin may use its dependencies while initializing
+    const QStringList dependencies = m_dependencyGraph.dependencies(pluginId);
+    for (const QString& depId : dependencies) {
+        if (!realizePlugin(depId)) {
+            LOG_ERROR("PluginManager", QString("Failed to load dependency %1 for plugin %2").arg(depId, pluginId));
+            markPluginFailed(pluginId, QString("Failed to load dependency: %1").arg(depId));
+            return false;
+        }
+    }
+
+    QString pluginPath;
+    if (!preparePluginLoad(pluginId, pluginPath)) {
+        return false;
+    }
+
+    LOG_INFO("PluginManager", QString("Loading library of lazy plugin: %1").arg(pluginId));
+
+    // Static plugins are already linked in and have no library to load
+    QPluginLoader* loader = nullptr;
+    if (!pluginPath.isEmpty()) {
+        loader = new QPluginLoader(pluginPath);
+
+        bool libraryLoaded;
+        {
+            PROFILE_PLUGIN_SCOPE("QPluginLoader::load", pluginId);
+            libraryLoaded = loader->load();
+        }
+
+        if (!libraryLoaded) {
+            QString errorString = loader->errorString();
+            LOG_ERROR("PluginManager", QString("Failed to load plugin %1: %2").arg(pluginId, errorString));
+            delete loader;
+            markPluginFailed(pluginId, QString("Failed to load: %1").arg(errorString));
+            return false;
+        }
+    }
+
+    QObject* pluginInstance = createPluginInstance(pluginId, loader);
+
+    IPlugin* plugin = qobject_cast<IPlugin*>(pluginInstance);
+    if (!plugin) {
+        LOG_ERROR("PluginManager", QString("Plugin %1 does not implement IPlugin interface").arg(pluginId));
+        if (loader) {
+            loader->unload();
+            delete loader;
+        }
+        markPluginFailed(pluginId, "Does not implement IPlugin interface");
+        return false;
+    }
+
+    placePluginInstance(pluginId, pluginInstance);
+
+    // Replay the lifecycle calls the proxy absorbed
+    PluginState state = pluginState(pluginId);
+    QString errorMessage;
+
+    try {
+        PROFILE_PLUGIN_SCOPE("LazyPluginProxy::replay", pluginId);
+        bool initialized = state == PluginState::Initialized || state == PluginState::Active || state == PluginState::Inactive;
+        if (initialized &&
+            !invokeOnPluginThread(plugin, &IPlugin::initialize)) {
+            errorMessage = "Failed to initialize";
+        } else {
+            // A plugin unloaded while idle gets its state back before it is activated again
+            if (initialized) {
+                restoreReloadState(pluginId, plugin, m_evictedStates.take(pluginId));
+            }
+            if (state == PluginState::Active && !invokeOnPluginThread(plugin, &IPlugin::activate)) {
+                errorMessage = "Failed to activate";
+            }
+        }
+    } catch (const PluginException& ex) {
+        errorMessage = QString("Exception during lazy load: %1").arg(ex.getMessage());
+    } catch (const std::exception& ex) {
+        errorMessage = QString("Exception during lazy load: %1").arg(ex.what());
+    } catch (...) {
+        errorMessage = "Unknown exception during lazy load";
+    }
+
+    if (!errorMessage.isEmpty()) {
+        LOG_ERROR("PluginManager", QString("Failed to load lazy plugin %1: %2").arg(pluginId, errorMessage));
+        retirePluginThread(pluginId, pluginInstance);
+        if (loader) {
+            loader->unload();
+            delete loader;
+        } else {
+            destroyStaticInstance(pluginInstance);
+        }
+        markPluginFailed(pluginId, errorMessage);
+        return false;
+    }
+
+    if (loader) {
+        QWriteLocker stateLocker(&m_stateLock);
+        m_registry.setLoader(PluginHandle::find(pluginId), loader);
+        stateLocker.unlock();
+        m_libraryTimestamps.insert(pluginId, QFileInfo(loader->fileName()).lastModified());
+    }
+    proxy->setTarget(plugin);
+    publishPluginCommands(pluginId, pluginInstance);
+
+    if (state == PluginState::Active) {
+        m_usageHistory.recordActivation(pluginId);
+    }
+    markPluginUsed(pluginId);
+
+    LOG_INFO("PluginManager", QString("Loaded library of lazy plugin: %1").arg(pluginId));
+
+    return true;
+}
+
+bool PluginManager::isPluginRealized(const QString& pluginId) const
+{
+    QReadLocker locker(&m_stateLock);
+
+    LazyPluginProxy* proxy = m_registry.proxy(PluginHandle::find(pluginId));
+
+    return !proxy || proxy->isRealized();
+}
+
+QStringList PluginManager::predictPluginUsage(int maxPlugins) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_usageHistory.predict(maxPlugins);
+}
+
+void PluginManager::preloadPlugins(int maxPlugins)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_initialized) {
+        LOG_ERROR("PluginManager", "Not initialized");
+        return;
+    }
+
+    if (m_preloadThread) {
+        if (m_preloadThread->isRunning()) {
+            LOG_WARNING("PluginManager", "Preloading is already running");
+            return;
+        }
+        delete m_preloadThread;
+        m_preloadThread = nullptr;
+    }
+
+    // Rank every plugin with history, so that already loaded ones do not use up the limit
+    QStringList pluginIds;
+    const QStringList predictedPluginIds = m_usageHistory.predict(std::numeric_limits<int>::max());
+    for (const QString& pluginId : predictedPluginIds) {
+        if (pluginIds.size() >= maxPlugins) {
+            break;
+        }
+        if (needsPreload(pluginId)) {
+            pluginIds.append(pluginId);
+        }
+    }
+
+    if (pluginIds.isEmpty()) {
+        return;
+    }
+
+    LOG_INFO("PluginManager", QString("Preloading plugins: %1").arg(pluginIds.join(", ")));
+
+    m_preloadCancelled.storeRelaxed(0);
+    m_preloadThread = QThread::create([this, pluginIds]() {
+        runPreloader(pluginIds);
+    });
+    m_preloadThread->setObjectName("Plugin preloader");
+    m_preloadThread->start(QThread::LowestPriority);
+}
+
+bool PluginManager::isPluginPreloaded(const QString& pluginId) const
+{
+    QReadLocker locker(&m_stateLock);
+
+    return m_preloadedLibraries.contains(pluginId);
+}
+
+bool PluginManager::isStaticPlugin(const QString& pluginId) const
+{
+    QReadLocker locker(&m_stateLock);
+
+    return m_staticPlugins.contains(pluginId);
+}
+
+QString PluginManager::getFrameworkVersion() const
+{
+    return m_frameworkVersion;
+}
+
+QString PluginManager::getLifecycleStageName(LifecycleStage stage)
+{
+    switch (stage) {
+        case LifecycleStage::ResolvingDependencies:
+            return "Resolving dependencies";
+        case LifecycleStage::LoadingLibrary:
+            return "Loading library";
+        case LifecycleStage::Initializing:
+            return "Initializing";
+        case LifecycleStage::Activating:
+            return "Activating";
+        case LifecycleStage::Deactivating:
+            return "Deactivating";
+        case LifecycleStage::ShuttingDown:
+            return "Shutting down";
+        case LifecycleStage::Unloading:
+            return "Unloading";
+    }
+
+    return "Unknown";
+}
+
+bool PluginManager::loadPluginMetadata(const QString& pluginId)
+{
+    PROFILE_PLUGIN_SCOPE("PluginManager::loadPluginMetadata", pluginId);
+
+    QString metadataPath = QDir(m_metadataDir).filePath(pluginId + ".json");
+    QString libraryPath;
+
+    // Side-by-side versions are found next to the unversioned file, in either format
+    const QFileInfoList metadataFiles = QDir(m_metadataDir).entryInfoList(QStringList() << pluginId + ".json" << pluginId + "-*.json"
+                                                                                       << pluginId + ".cbor" << pluginId + "-*.cbor", QDir::Files);
+
+    if (metadataFiles.isEmpty()) {
+        if (m_staticPlugins.contains(pluginId)) {
+            return registerPluginMetadata(pluginId, PluginMetadata(m_staticPlugins.value(pluginId).metaData.value("MetaData").toObject()));
+        }
+
+        if (m_embeddedMetadata) {
+            libraryPath = findPluginLibrary(pluginId);
+        }
+
+        if (libraryPath.isEmpty()) {
+            LOG_ERROR("PluginManager", QString("Metadata file not found: %1").arg(metadataPath));
+            return false;
+        }
+    }
+
+    if (!m_metadataIndexLoaded) {
+        m_metadataIndex.load(metadataIndexPath());
+        m_metadataIndexLoaded = true;
+    }
+
+    if (!libraryPath.isEmpty()) {
+        PluginMetadata metadata;
+        if (!readEmbeddedMetadata(QFileInfo(libraryPath), metadata)) {
+            LOG_ERROR("PluginManager", QString("Failed to read embedded metadata from library: %1").arg(libraryPath));
+            return false;
+        }
+
+        return registerPluginMetadata(pluginId, metadata);
+    }
+
+    bool registered = false;
+    for (const QFileInfo& metadataFile : metadataFiles) {
+        PluginMetadata metadata;
+        if (!readPluginMetadata(metadataFile, metadata)) {
+            LOG_ERROR("PluginManager", QString("Failed to load metadata from file: %1").arg(metadataFile.filePath()));
+            continue;
+        }
+
+        if (!isMetadataFileOf(metadataFile, metadata)) {
+            // The wildcard also matches files of plugins whose ID merely starts with this one
+            if (metadata.getPluginId() == pluginId || metadataFile.completeBaseName() == pluginId) {
+                LOG_ERROR("PluginManager", QString("Metadata file %1 does not match plugin %2 %3")
+                          .arg(metadataFile.fileName(), metadata.getPluginId(), metadata.getPluginVersion()));
+            }
+            continue;
+        }
+
+        if (registerPluginMetadata(pluginId, metadata)) {
+            registered = true;
+        }
+    }
+
+    // Entries added here are saved by the next scan, or at shutdown
+    return registered;
+}
+
+bool PluginManager::readPluginMetadata(const QFileInfo& fileInfo, PluginMetadata& metadata)
+{
+    if (m_metadataIndex.lookup(fileInfo, metadata)) {
+        return true;
+    }
+
+    {
+        PROFILE_SCOPE("PluginMetadata::loadFromFile");
+        if (!metadata.loadFromFile(fileInfo.filePath())) {
+            return false;
+        }
+    }
+
+    m_metadataIndex.insert(fileInfo, metadata);
+
+    return true;
+}
+
+bool PluginManager::readEmbeddedMetadata(const QFileInfo& fileInfo, PluginMetadata& metadata)
+{
+    if (m_metadataIndex.lookup(fileInfo, metadata)) {
+        return true;
+    }
+
+    // Reads the metadata section of the file; the library itself is not loaded
+    QPluginLoader probe(fileInfo.absoluteFilePath());
+    QJsonObject embedded = probe.metaData();
+
+    if (embedded.value("IID").toString() != PluginInterface_iid) {
+        return false;
+    }
+
+    metadata = PluginMetadata(embedded.value("MetaData").toObject());
+    if (!metadata.isValid()) {
+        return false;
+    }
+
+    m_metadataIndex.insert(fileInfo, metadata);
+
+    return true;
+}
+
+void PluginManager::scanEmbeddedMetadata(QStringList& pluginIds, QSet<QString>& libraryPaths)
+{
+    PROFILE_SCOPE("PluginManager::scanEmbeddedMetadata");
+
+    m_libraryPaths.clear();
+
+    QDir pluginDir(m_pluginDir);
+    const QFileInfoList libraryFiles = pluginDir.entryInfoList(QDir::Files);
+
+    for (const QFileInfo& libraryFile : libraryFiles) {
+        if (!QLibrary::isLibrary(libraryFile.fileName())) {
+            continue;
+        }
+
+        libraryPaths.insert(libraryFile.absoluteFilePath());
+
+        PluginMetadata metadata;
+        if (!readEmbeddedMetadata(libraryFile, metadata)) {
+            LOG_DEBUG("PluginManager", QString("No plugin metadata embedded in library: %1").arg(libraryFile.filePath()));
+            continue;
+        }
+
+        QString pluginId = metadata.getPluginId();
+        m_libraryPaths.insert(pluginId, libraryFile.absoluteFilePath());
+        m_libraryPaths.insert(pluginId + "-" + metadata.getPluginVersion(), libraryFile.absoluteFilePath());
+
+        // A metadata file takes precedence over the metadata embedded in the same version
+        if (!m_versionResolver.hasVersion(pluginId, metadata.getVersionNumber()) && !registerPluginMetadata(pluginId, metadata)) {
+            continue;
+        }
+
+        if (!pluginIds.contains(pluginId)) {
+            pluginIds.append(pluginId);
+        }
+    }
+}
+
+bool PluginManager::registerPluginMetadata(const QString& pluginId, const PluginMetadata& metadata)
+{
+    if (!metadata.isValid()) {
+        LOG_ERROR("PluginManager", QString("Invalid metadata for plugin: %1").arg(pluginId));
+        return false;
+    }
+
+    if (metadata.getPluginId() != pluginId) {
+        LOG_ERROR("PluginManager", QString("Metadata ID (%1) does not match plugin ID (%2)").arg(metadata.getPluginId(), pluginId));
+        return false;
+    }
+
+    // Registered metadata has valid handles for its ID and all of its dependencies
+    PluginMetadata registeredMetadata = metadata;
+    registeredMetadata.internHandles();
+
+    QWriteLocker stateLocker(&m_stateLock);
+
+    QStringList cycle;
+    if (!m_versionResolver.addVersion(registeredMetadata, &cycle)) {
+        stateLocker.unlock();
+        LOG_ERROR("PluginManager", QString("Dependency cycle for plugin %1: %2").arg(pluginId, cycle.join(" -> ")));
+        return false;
+    }
+
+    const QStringList changedPluginIds = applyResolvedVersions();
+    stateLocker.unlock();
+
+    for (const QString& changedId : changedPluginIds) {
+        QString conflict = m_versionResolver.conflict(changedId);
+        if (!conflict.isEmpty()) {
+            LOG_WARNING("PluginManager", QString("Version conflict for plugin %1: %2").arg(changedId, conflict));
+        }
+
+        QString resolvedVersion = m_versionResolver.resolvedMetadata(changedId).getPluginVersion();
+        QString registeredVersion = m_registry.metadata(PluginHandle::find(changedId)).getPluginVersion();
+        if (resolvedVersion != registeredVersion && isPluginLoaded(changedId)) {
+            LOG_INFO("PluginManager", QString("Plugin %1 keeps version %2 until it is loaded again; version %3 was resolved")
+                     .arg(changedId, registeredVersion, resolvedVersion));
+        }
+    }
+
+    return true;
+}
+
+QStringList PluginManager::applyResolvedVersions()
+{
+    const QStringList changedPluginIds = m_versionResolver.resolve();
+
+    for (const QString& pluginId : changedPluginIds) {
+        // A loaded plugin keeps running the version it was loaded from
+        if (!isPluginLoaded(pluginId)) {
+            applyResolvedVersion(pluginId);
+        }
+    }
+
+    return changedPluginIds;
+}
+
+void PluginManager::applyResolvedVersion(const QString& pluginId)
+{
+    PluginMetadata resolved = m_versionResolver.resolvedMetadata(pluginId);
+    if (!resolved.isValid()) {
+        return;
+    }
+
+    PluginHandle handle = PluginHandle::fromId(pluginId);
+    if (m_registry.hasMetadata(handle) && m_registry.metadata(handle).getMetadataJson() == resolved.getMetadataJson()) {
+        return;
+    }
+
+    // These edges are a subset of the resolver's acyclic graph, so they cannot form a cycle
+    m_dependencyGraph.setDependencies(pluginId, resolved.getPluginDependencies());
+    m_registry.setMetadata(handle, resolved);
+}
+
+QString PluginManager::metadataIndexPath() const
+{
+    return QDir(m_metadataDir).filePath(".metadata-index.cbor");
+}
+
+QString PluginManager::usageHistoryPath() const
+{
+    return QDir(m_metadataDir).filePath(".usage-history.json");
+}
+
+void PluginManager::saveUsageHistory()
+{
+    if (m_usageHistory.isDirty() && !m_usageHistory.save(usageHistoryPath())) {
+        LOG_WARNING("PluginManager", QString("Failed to save usage history: %1").arg(usageHistoryPath()));
+    }
+}
+
+bool PluginManager::needsPreload(const QString& pluginId) const
+{
+    PluginHandle handle = PluginHandle::find(pluginId);
+    if (!m_registry.hasMetadata(handle) || m_staticPlugins.contains(pluginId) || m_preloadedLibraries.contains(pluginId)) {
+        return false;
+    }
+
+    if (m_registry.state(handle) == PluginState::Failed) {
+        return false;
+    }
+
+    // A lazy proxy that has not been used yet still has its library to load
+    LazyPluginProxy* proxy = m_registry.proxy(handle);
+    return !m_registry.isLoaded(handle) || (proxy && !proxy->isRealized());
+}
+
+void PluginManager::runPreloader(const QStringList& pluginIds)
+{
+    for (const QString& pluginId : pluginIds) {
+        if (m_preloadCancelled.loadRelaxed()) {
+            break;
+        }
+
+        QString libraryPath;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_initialized && needsPreload(pluginId)) {
+                libraryPath = findPluginLibrary(pluginId);
+            }
+        }
+        if (libraryPath.isEmpty()) {
+            continue;
+        }
+
+        // Reading and mapping happen outside the lifecycle lock, which is only taken again to
+        // publish the loaded library. The instance is constructed when the plugin is loaded.
+        readAheadFile(libraryPath);
+
+        if (m_preloadCancelled.loadRelaxed()) {
+            break;
+        }
+
+        // Only a library that would pass validation is worth loading
+        QPluginLoader* loader = new QPluginLoader(libraryPath);
+        QString errorMessage;
+        {
+            QReadLocker stateLocker(&m_stateLock);
+            errorMessage = checkEmbeddedMetadata(pluginId, loader->metaData());
+        }
+
+        if (!errorMessage.isEmpty() || !loader->load()) {
+            LOG_WARNING("PluginManager", QString("Could not preload plugin %1: %2")
+                                             .arg(pluginId, errorMessage.isEmpty() ? loader->errorString() : errorMessage));
+            delete loader;
+            continue;
+        }
+
+        QMutexLocker locker(&m_mutex);
+
+        // A plugin loaded meanwhile holds its library through its own loader
+        if (!m_initialized || !needsPreload(pluginId)) {
+            loader->unload();
+            delete loader;
+            continue;
+        }
+
+        {
+            QWriteLocker stateLocker(&m_stateLock);
+            m_preloadedLibraries.insert(pluginId, loader);
+        }
+
+        LOG_INFO("PluginManager", QString("Preloaded library of plugin: %1").arg(pluginId));
+    }
+}
+
+void PluginManager::readAheadFile(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QByteArray buffer(1 << 20, Qt::Uninitialized);
+    while (file.read(buffer.data(), buffer.size()) > 0) {
+    }
+}
+
+void PluginManager::releasePreloadedLibrary(const QString& pluginId)
+{
+    QPluginLoader* loader;
+    {
+        QWriteLocker stateLocker(&m_stateLock);
+        loader = m_preloadedLibraries.take(pluginId);
+    }
+
+    if (loader) {
+        loader->unload();
+        delete loader;
+    }
+}
+
+void PluginManager::stopPreloader()
+{
+    QThread* thread;
+    {
+        QMutexLocker locker(&m_mutex);
+        thread = m_preloadThread;
+        m_preloadThread = nullptr;
+        m_preloadCancelled.storeRelaxed(1);
+    }
+
+    if (thread) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+bool PluginManager::checkPluginDependencies(const QString& pluginId)
+{
+    if (!m_registry.hasMetadata(PluginHandle::find(pluginId))) {
+        LOG_ERROR("PluginManager", QString("No metadata found for plugin: %1").arg(pluginId));
+        return false;
+    }
+
+    PluginMetadata metadata = m_registry.metadata(PluginHandle::find(pluginId));
+    QStringList dependencies = m_dependencyGraph.dependencies(pluginId);
+
+    for (const QString& depId : dependencies) {
+        // Check if dependency metadata is available
+        if (!m_registry.hasMetadata(PluginHandle::find(depId))) {
+            if (!loadPluginMetadata(depId)) {
+                LOG_ERROR("PluginManager", QString("Failed to load metadata for dependency: %1").arg(depId));
+                return false;
+            }
+        } else if (!isPluginLoaded(depId)) {
+            QWriteLocker stateLocker(&m_stateLock);
+            applyResolvedVersion(depId);
+        }
+
+        // Check if dependency is compatible with framework
+        PluginMetadata depMetadata = m_registry.metadata(PluginHandle::find(depId));
+        if (!depMetadata.isCompatibleWithFramework(m_frameworkVersionNumber)) {
+            LOG_ERROR("PluginManager", QString("Dependency %1 is not compatible with framework version %2").arg(depId, m_frameworkVersion));
+            return false;
+        }
+
+        // A loaded dependency, or one whose constraints conflict, may lie outside the range
+        PluginVersionRange range = metadata.getDependencyRange(depId);
+        if (!range.contains(depMetadata.getVersionNumber())) {
+            QString reason = isPluginLoaded(depId)
+                ? QString("version %1 is loaded").arg(depMetadata.getPluginVersion())
+                : QString("version %1 was resolved: %2").arg(depMetadata.getPluginVersion(), m_versionResolver.conflict(depId));
+            LOG_ERROR("PluginManager", QString("Plugin %1 requires %2 %3, but %4").arg(pluginId, depId, range.toString(), reason));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QStringList PluginManager::getDependentPlugins(const QString& pluginId) const
+{
+    return m_dependencyGraph.dependents(pluginId);
+}
+
+QStringList PluginManager::sortPluginsByDependency(const QStringList& pluginIds)
+{
+    return m_dependencyGraph.loadOrder(pluginIds);
+}
+
+QList<QStringList> PluginManager::groupPluginsByLevel(const QStringList& sortedPluginIds) const
+{
+    QHash<QString, int> pluginLevels;
+    QList<QStringList> levels;
+
+    for (const QString& pluginId : sortedPluginIds) {
+        int level = 0;
+
+        if (m_registry.hasMetadata(PluginHandle::find(pluginId))) {
+            const QStringList dependencies = m_dependencyGraph.dependencies(pluginId);
+            for (const QString& depId : dependencies) {
+                level = qMax(level, pluginLevels.value(depId, 0) + 1);
+            }
+        }
+
+        pluginLevels.insert(pluginId, level);
+
+        while (levels.size() <= level) {
+            levels.append(QStringList());
+        }
+        levels[level].append(pluginId);
+    }
+
+    return levels;
+}
+
+namespace {
+
+struct PendingLoad {
+    QString pluginId;
+    QPluginLoader* loader;
+    QString errorString;
+};
+
+struct PendingInitialize {
+    QString pluginId;
+    IPlugin* plugin;
+    QString errorMessage;
+};
+
+} // namespace
+
+QStringList PluginManager::loadPluginLevel(const QStringList& pluginIds, QSet<QString>& failedPlugins)
+{
+    QStringList loadedPluginIds;
+    QList<PendingLoad> pendingLoads;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        for (const QString& pluginId : pluginIds) {
+            if (isPluginLoaded(pluginId)) {
+                loadedPluginIds.append(pluginId);
+                continue;
+            }
+
+            if (!m_registry.hasMetadata(PluginHandle::find(pluginId)) && !loadPluginMetadata(pluginId)) {
+                LOG_ERROR("PluginManager", QString("Failed to load metadata for plugin: %1").arg(pluginId));
+                failedPlugins.insert(pluginId);
+                continue;
+            }
+
+            // Skip the sub-tree of a plugin that failed on a lower level
+            QString failedDependency;
+            const QStringList dependencies = m_dependencyGraph.dependencies(pluginId);
+            for (const QString& depId : dependencies) {
+                if (failedPlugins.contains(depId)) {
+                    failedDependency = depId;
+                    break;
+                }
+            }
+
+            if (!failedDependency.isEmpty()) {
+                LOG_ERROR("PluginManager", QString("Skipping plugin %1 because dependency %2 failed").arg(pluginId, failedDependency));
+                markPluginFailed(pluginId, QString("Failed to load dependency: %1").arg(failedDependency));
+                failedPlugins.insert(pluginId);
+                continue;
+            }
+
+            QString pluginPath;
+            if (!preparePluginLoad(pluginId, pluginPath)) {
+                failedPlugins.insert(pluginId);
+                continue;
+            }
+
+            if (m_lazyLoading) {
+                attachLazyProxy(pluginId);
+                loadedPluginIds.append(pluginId);
+                continue;
+            }
+
+            // Static plugins join the pending list without a loader, as there is nothing to map
+            pendingLoads.append(PendingLoad{pluginId, pluginPath.isEmpty() ? nullptr : new QPluginLoader(pluginPath), QString()});
+        }
+    }
+
+    // Map the libraries without holding the lock so independent plugins load concurrently
+    QtConcurrent::blockingMap(pendingLoads, [](PendingLoad& pending) {
+        if (!pending.loader) {
+            return;
+        }
+
+        PROFILE_PLUGIN_SCOPE("QPluginLoader::load", pending.pluginId);
+        if (!pending.loader->load()) {
+            pending.errorString = pending.loader->errorString();
+        }
+    });
+
+    // Instances are created one by one on the application thread, where plugin objects live
+    QMutexLocker locker(&m_mutex);
+
+    for (const PendingLoad& pending : pendingLoads) {
+        if (!pending.errorString.isEmpty()) {
+            LOG_ERROR("PluginManager", QString("Failed to load plugin %1: %2").arg(pending.pluginId, pending.errorString));
+            delete pending.loader;
+            markPluginFailed(pending.pluginId, QString("Failed to load: %1").arg(pending.errorString));
+            failedPlugins.insert(pending.pluginId);
+            continue;
+        }
+
+        if (!attachPluginInstance(pending.pluginId, pending.loader)) {
+            failedPlugins.insert(pending.pluginId);
+            continue;
+        }
+
+        loadedPluginIds.append(pending.pluginId);
+    }
+
+    return loadedPluginIds;
+}
+
+void PluginManager::initializePluginLevel(const QStringList& pluginIds, QSet<QString>& failedPlugins)
+{
+    QList<PendingInitialize> pendingInitializations;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        for (const QString& pluginId : pluginIds) {
+            if (pluginState(pluginId) == PluginState::Loaded) {
+                pendingInitializations.append(PendingInitialize{pluginId, m_registry.instance(PluginHandle::find(pluginId)), QString()});
+            } else if (pluginState(pluginId) == PluginState::Failed) {
+                failedPlugins.insert(pluginId);
+            }
+        }
+    }
+
+    // Each plugin initializes on the thread it lives in, so plugins with threads of their own
+    // initialize side by side while the others take turns on the application thread
+    QList<QSharedPointer<LifecycleCall>> calls;
+    for (PendingInitialize& pending : pendingInitializations) {
+        PendingInitialize* target = &pending;
+        calls.append(m_mutex.post(pluginContext(pending.plugin), [target]() {
+            try {
+                PROFILE_PLUGIN_SCOPE("IPlugin::initialize", target->pluginId);
+                if (!callLifecycleMethod(target->plugin, &IPlugin::initialize)) {
+                    target->errorMessage = "Failed to initialize";
+                }
+            } catch (const PluginException& ex) {
+                target->errorMessage = QString("Exception during initialization: %1").arg(ex.getMessage());
+            } catch (const std::exception& ex) {
+                target->errorMessage = QString("Exception during initialization: %1").arg(ex.what());
+            } catch (...) {
+                target->errorMessage = "Unknown exception during initialization";
+            }
+        }, false));
+    }
+
+    // Initializations posted to this thread run while it waits
+    for (const QSharedPointer<LifecycleCall>& call : calls) {
+        m_mutex.wait(call);
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    for (const PendingInitialize& pending : pendingInitializations) {
+        if (!pending.errorMessage.isEmpty()) {
+            LOG_ERROR("PluginManager", QString("Failed to initialize plugin %1: %2").arg(pending.pluginId, pending.errorMessage));
+            markPluginFailed(pending.pluginId, pending.errorMessage);
+            failedPlugins.insert(pending.pluginId);
+            continue;
+        }
+
+        setPluginState(pending.pluginId, PluginState::Initialized);
+
+        LOG_INFO("PluginManager", QString("Initialized plugin: %1").arg(pending.pluginId));
+
+        emit pluginInitialized(pending.pluginId);
+    }
+}
+
+bool PluginManager::preparePluginLoad(const QString& pluginId, QString& pluginPath)
+{
+    // A version resolved while the plugin was loaded takes effect now
+    if (!isPluginLoaded(pluginId)) {
+        QWriteLocker stateLocker(&m_stateLock);
+        applyResolvedVersion(pluginId);
+    }
+
+    // Check if plugin is compatible with framework
+    PluginMetadata metadata = m_registry.metadata(PluginHandle::find(pluginId));
+    if (!metadata.isCompatibleWithFramework(m_frameworkVersionNumber)) {
+        LOG_ERROR("PluginManager", QString("Plugin %1 is not compatible with framework version %2").arg(pluginId, m_frameworkVersion));
+        markPluginFailed(pluginId, QString("Incompatible with framework version %1").arg(m_frameworkVersion));
+        return false;
+    }
+
+    // Check dependencies
+    if (!checkPluginDependencies(pluginId)) {
+        LOG_ERROR("PluginManager", QString("Plugin %1 has unsatisfied dependencies").arg(pluginId));
+        markPluginFailed(pluginId, "Unsatisfied dependencies");
+        return false;
+    }
+
+    // A plugin linked into the host takes precedence over a library of the same ID
+    if (m_staticPlugins.contains(pluginId)) {
+        QString errorMessage = checkEmbeddedMetadata(pluginId, m_staticPlugins.value(pluginId).metaData);
+        if (!errorMessage.isEmpty()) {
+            LOG_ERROR("PluginManager", QString("Rejected static plugin %1: %2").arg(pluginId, errorMessage));
+            markPluginFailed(pluginId, errorMessage);
+            return false;
+        }
+
+        pluginPath.clear();
+        return true;
+    }
+
+    // Locate plugin library
+    pluginPath = findPluginLibrary(pluginId);
+    if (pluginPath.isEmpty()) {
+        LOG_ERROR("PluginManager", QString("Plugin library not found for plugin: %1").arg(pluginId));
+        markPluginFailed(pluginId, "Plugin library not found");
+        return false;
+    }
+
+    return validatePluginLibrary(pluginId, pluginPath);
+}
+
+QString PluginManager::findPluginLibrary(const QString& pluginId) const
+{
+    // A side-by-side version lives in lib<id>-<version>.so and the like; the
+    // unversioned library is checked against the registered version when it is loaded
+    QString version = m_registry.metadata(PluginHandle::find(pluginId)).getPluginVersion();
+    const QStringList baseNames = version.isEmpty() ? QStringList{pluginId} : QStringList{pluginId + "-" + version, pluginId};
+
+    for (const QString& baseName : baseNames) {
+        QString pluginPath = m_libraryPaths.value(baseName);
+        if (!pluginPath.isEmpty() && QFile::exists(pluginPath)) {
+            return pluginPath;
+        }
+
+        pluginPath = QDir(m_pluginDir).filePath(baseName + ".dll"); // Windows
+        if (!QFile::exists(pluginPath)) {
+            pluginPath = QDir(m_pluginDir).filePath("lib" + baseName + ".so"); // Linux
+        }
+        if (!QFile::exists(pluginPath)) {
+            pluginPath = QDir(m_pluginDir).filePath("lib" + baseName + ".dylib"); // macOS
+        }
+
+        if (QFile::exists(pluginPath)) {
+            return pluginPath;
+        }
+    }
+
+    return QString();
+}
+
+bool PluginManager::validatePluginLibrary(const QString& pluginId, const QString& pluginPath)
+{
+    PROFILE_PLUGIN_SCOPE("PluginManager::validatePluginLibrary", pluginId);
+
+    // Reads the metadata section of the file; the library itself is not loaded
+    QPluginLoader probe(pluginPath);
+    QJsonObject embedded = probe.metaData();
+
+    QString errorMessage = embedded.isEmpty() ? QString("Not a Qt plugin: %1").arg(probe.errorString())
+                                              : checkEmbeddedMetadata(pluginId, embedded);
+
+    if (!errorMessage.isEmpty()) {
+        LOG_ERROR("PluginManager", QString("Rejected library %1 of plugin %2: %3").arg(pluginPath, pluginId, errorMessage));
+        markPluginFailed(pluginId, errorMessage);
+        return false;
+    }
+
+    return true;
+}
+
+QString PluginManager::checkEmbeddedMetadata(const QString& pluginId, const QJsonObject& embedded) const
+{
+    if (embedded.value("IID").toString() != PluginInterface_iid) {
+        return QString("Does not implement IPlugin interface (IID %1)").arg(embedded.value("IID").toString());
+    }
+
+    PluginMetadata libraryMetadata(embedded.value("MetaData").toObject());
+    PluginMetadata registeredMetadata = m_registry.metadata(PluginHandle::find(pluginId));
+
+    if (!libraryMetadata.isValid()) {
+        return "Library carries no valid plugin metadata";
+    }
+
+    if (libraryMetadata.getPluginId() != pluginId) {
+        return QString("Library belongs to plugin %1").arg(libraryMetadata.getPluginId());
+    }
+
+    // Compared as version numbers, so "1.2" and "1.2.0" name the same version
+    if (QVersionNumber::compare(libraryMetadata.getVersionNumber().normalized(),
+                                registeredMetadata.getVersionNumber().normalized()) != 0) {
+        return QString("Library version %1 does not match metadata version %2")
+            .arg(libraryMetadata.getPluginVersion(), registeredMetadata.getPluginVersion());
+    }
+
+    if (!libraryMetadata.isCompatibleWithFramework(m_frameworkVersionNumber)) {
+        return QString("Library is incompatible with framework version %1").arg(m_frameworkVersion);
+    }
+
+    return QString();
+}
+
+void PluginManager::discoverStaticPlugins()
+{
+    QHash<QString, StaticPlugin> staticPlugins;
+
+    const auto plugins = QPluginLoader::staticPlugins();
+    for (const QStaticPlugin& staticPlugin : plugins) {
+        QJsonObject embedded = staticPlugin.metaData();
+        if (embedded.value("IID").toString() != PluginInterface_iid) {
+            continue;
+        }
+
+        QString pluginId = embedded.value("MetaData").toObject().value("id").toString();
+        if (pluginId.isEmpty()) {
+            LOG_WARNING("PluginManager", QString("Ignoring static plugin %1 without a plugin ID").arg(embedded.value("className").toString()));
+            continue;
+        }
+
+        staticPlugins.insert(pluginId, StaticPlugin{staticPlugin.instance, embedded});
+    }
+
+    {
+        QWriteLocker stateLocker(&m_stateLock);
+        m_staticPlugins = staticPlugins;
+    }
+
+    if (!staticPlugins.isEmpty()) {
+        LOG_INFO("PluginManager", QString("Found %1 static plugins").arg(staticPlugins.size()));
+    }
+}
+
+QObject* PluginManager::createStaticPluginInstance(const QString& pluginId) const
+{
+    auto it = m_staticPlugins.constFind(pluginId);
+    if (it == m_staticPlugins.constEnd()) {
+        return nullptr;
+    }
+
+    return it.value().instance ? it.value().instance() : nullptr;
+}
+
+QObject* PluginManager::createPluginInstance(const QString& pluginId, QPluginLoader* loader)
+{
+    QObject* instance = nullptr;
+    auto create = [this, &pluginId, loader, &instance]() {
+        PROFILE_PLUGIN_SCOPE("QPluginLoader::instance", pluginId);
+        instance = loader ? loader->instance() : createStaticPluginInstance(pluginId);
+    };
+
+    // Constructors may create timers and child objects, so they run where plugin objects live
+    QCoreApplication* app = QCoreApplication::instance();
+    if (app && app->thread() != QThread::currentThread()) {
+        m_mutex.wait(m_mutex.post(app, create));
+    } else {
+        create();
+    }
+
+    return instance;
+}
+
+bool PluginManager::attachPluginInstance(const QString& pluginId, QPluginLoader* loader)
+{
+    QObject* pluginInstance = createPluginInstance(pluginId, loader);
+
+    if (!pluginInstance) {
+        QString errorString = loader ? loader->errorString() : QString("Not a static plugin");
+        LOG_ERROR("PluginManager", QString("Failed to get plugin instance for %1: %2").arg(pluginId, errorString));
+        if (loader) {
+            loader->unload();
+            delete loader;
+        }
+        markPluginFailed(pluginId, QString("Failed to get instance: %1").arg(errorString));
+        return false;
+    }
+
+    IPlugin* plugin = qobject_cast<IPlugin*>(pluginInstance);
+    if (!plugin) {
+        LOG_ERROR("PluginManager", QString("Plugin %1 does not implement IPlugin interface").arg(pluginId));
+        if (loader) {
+            loader->unload();
+            delete loader;
+        }
+        markPluginFailed(pluginId, "Does not implement IPlugin interface");
+        return false;
+    }
+
+    placePluginInstance(pluginId, pluginInstance);
+    if (loader) {
+        m_libraryTimestamps.insert(pluginId, QFileInfo(loader->fileName()).lastModified());
+    }
+
+    {
+        QWriteLocker stateLocker(&m_stateLock);
+        PluginHandle handle = PluginHandle::fromId(pluginId);
+        m_registry.attach(handle, plugin, loader, nullptr);
+        m_registry.setState(handle, PluginState::Loaded);
+    }
+
+    publishPluginCommands(pluginId, pluginInstance);
+    markPluginUsed(pluginId);
+
+    LOG_INFO("PluginManager", QString("Loaded plugin: %1").arg(pluginId));
+
+    emit pluginLoaded(pluginId);
+
+    return true;
+}
+
+namespace {
+
+// Upper bound for command IDs, which index a per-plugin table
+const int MaxCommandId = 1024;
+
+} // namespace
+
+void PluginManager::publishPluginCommands(const QString& pluginId, QObject* pluginInstance)
+{
+    ICommandProvider* provider = qobject_cast<ICommandProvider*>(pluginInstance);
+    if (!provider) {
+        return;
+    }
+
+    QList<PluginCommandDescriptor> descriptors;
     try {
-        return plugin->executeCommand(command, params);
+        descriptors = provider->commandDescriptors();
     } catch (const PluginException& ex) {
-        LOG_ERROR("PluginManager", QString("Exception during command execution: %1").arg(ex.getMessage()));
-        return QVariant();
+        LOG_WARNING("PluginManager", QString("Exception while reading commands of %1: %2").arg(pluginId, ex.getMessage()));
+        return;
     } catch (const std::exception& ex) {
-        LOG_ERROR("PluginManager", QString("Exception during command execution: %1").arg(ex.what()));
-        return QVariant();
+        LOG_WARNING("PluginManager", QString("Exception while reading commands of %1: %2").arg(pluginId, ex.what()));
+        return;
     } catch (...) {
-        LOG_ERROR("PluginManager", "Unknown exception during command execution");
+        LOG_WARNING("PluginManager", QString("Unknown exception while reading commands of %1").arg(pluginId));
+        return;
+    }
+
+    QList<PluginCommandDescriptor> accepted;
+    QSet<int> commandIds;
+    for (const PluginCommandDescriptor& descriptor : descriptors) {
+        if (descriptor.id < 0 || descriptor.id >= MaxCommandId || commandIds.contains(descriptor.id)) {
+            LOG_WARNING("PluginManager", QString("Ignoring command %1 of plugin %2 with invalid or duplicate ID %3")
+                                             .arg(descriptor.name, pluginId).arg(descriptor.id));
+            continue;
+        }
+        commandIds.insert(descriptor.id);
+        accepted.append(descriptor);
+    }
+
+    {
+        QWriteLocker stateLocker(&m_stateLock);
+        m_registry.setCommands(PluginHandle::fromId(pluginId), provider, accepted);
+    }
+
+    emit pluginCommandsChanged(pluginId);
+}
+
+void PluginManager::markPluginFailed(const QString& pluginId, const QString& errorMessage)
+{
+    setPluginState(pluginId, PluginState::Failed);
+    emit pluginFailed(pluginId, errorMessage);
+}
+
+void PluginManager::attachLazyProxy(const QString& pluginId, PluginState state)
+{
+    LazyPluginProxy* proxy = new LazyPluginProxy(m_registry.metadata(PluginHandle::find(pluginId)));
+    adoptPluginObject(proxy);
+
+    {
+        QWriteLocker stateLocker(&m_stateLock);
+        PluginHandle handle = PluginHandle::fromId(pluginId);
+        m_registry.attach(handle, proxy, nullptr, proxy);
+        m_registry.setState(handle, state);
+    }
+
+    LOG_INFO("PluginManager", QString("Registered lazy plugin: %1").arg(pluginId));
+
+    emit pluginLoaded(pluginId);
+}
+
+void PluginManager::setPluginState(const QString& pluginId, PluginState state)
+{
+    QWriteLocker locker(&m_stateLock);
+
+    m_registry.setState(PluginHandle::fromId(pluginId), state);
+}
+
+PluginState PluginManager::pluginState(const QString& pluginId) const
+{
+    return m_registry.state(PluginHandle::find(pluginId));
+}
+
+QVariant PluginManager::runPluginCommand(PluginHandle handle, int commandId, const QString& command, const QVariantMap& params,
+                                         QRecursiveMutex* commandMutex)
+{
+    IPlugin* plugin = nullptr;
+    bool realized = true;
+
+    {
+        QReadLocker locker(&m_stateLock);
+
+        if (!m_initialized) {
+            LOG_ERROR("PluginManager", "Not initialized");
+            return QVariant();
+        }
+
+        plugin = m_registry.instance(handle);
+        if (!plugin) {
+            LOG_ERROR("PluginManager", QString("Plugin not loaded: %1").arg(handle.pluginId()));
+            return QVariant();
+        }
+
+        if (m_registry.state(handle) != PluginState::Active) {
+            LOG_ERROR("PluginManager", QString("Plugin not active: %1").arg(handle.pluginId()));
+            return QVariant();
+        }
+
+        LazyPluginProxy* proxy = m_registry.proxy(handle);
+        realized = !proxy || proxy->isRealized();
+    }
+
+    // Loading the library is a lifecycle change and takes the lifecycle lock
+    if (!realized && !realizePlugin(handle.pluginId())) {
+        LOG_ERROR("PluginManager", QString("Failed to load lazy plugin: %1").arg(handle.pluginId()));
         return QVariant();
     }
+
+    // Commands addressed by ID go through the command table instead of the name dispatch;
+    // the table is only filled once the real instance is loaded, so look it up after realizing
+    ICommandProvider* provider = nullptr;
+    if (commandId >= 0) {
+        QReadLocker locker(&m_stateLock);
+
+        const PluginCommandDescriptor* descriptor = m_registry.command(handle, commandId);
+        provider = m_registry.commandProvider(handle);
+        if (!descriptor || !provider) {
+            LOG_ERROR("PluginManager", QString("Unknown command %1 for plugin %2").arg(commandId).arg(handle.pluginId()));
+            return QVariant();
+        }
+
+        QString errorMessage = checkCommandParameters(handle.pluginId(), *descriptor, params);
+        if (!errorMessage.isEmpty()) {
+            LOG_ERROR("PluginManager", errorMessage);
+            return QVariant();
+        }
+    }
+
+    QRecursiveMutexLocker locker(commandMutex);
+
+    QVariant result;
+    QString errorMessage;
+    const QString pluginId = handle.pluginId();
+
+    // Threaded plugins run their commands on their own thread
+    if (hasDedicatedThread(plugin)) {
+        runOnPluginThread(plugin, [&pluginId, plugin, provider, commandId, &command, &params, &result, &errorMessage]() {
+            result = dispatchPluginCommand(pluginId, plugin, provider, commandId, command, params, errorMessage);
+        });
+    } else {
+        result = dispatchPluginCommand(pluginId, plugin, provider, commandId, command, params, errorMessage);
+    }
+
+    if (!errorMessage.isEmpty()) {
+        LOG_ERROR("PluginManager", errorMessage);
+    }
+
+    return result;
 }
 
-QString PluginManager::getFrameworkVersion() const
+QString PluginManager::checkCommandParameters(const QString& pluginId, const PluginCommandDescriptor& descriptor,
+                                              const QVariantMap& params)
 {
-    return m_frameworkVersion;
+    for (const PluginCommandParameter& parameter : descriptor.parameters) {
+        auto it = params.constFind(parameter.name);
+        if (it == params.constEnd()) {
+            if (parameter.required) {
+                return QString("Missing parameter %1 for command %2 of plugin %3").arg(parameter.name, descriptor.name, pluginId);
+            }
+            continue;
+        }
+
+        // Values of another type pass if they convert, such as a number entered as text
+        QMetaType expectedType(parameter.type);
+        QVariant value = it.value();
+        if (value.metaType() != expectedType && !value.convert(expectedType)) {
+            return QString("Parameter %1 for command %2 of plugin %3 must be of type %4")
+                .arg(parameter.name, descriptor.name, pluginId, QString::fromLatin1(expectedType.name()));
+        }
+    }
+
+    return QString();
 }
 
-bool PluginManager::loadPluginMetadata(const QString& pluginId)
+QVariant PluginManager::dispatchPluginCommand(const QString& pluginId, IPlugin* plugin, ICommandProvider* provider, int commandId,
+                                              const QString& command, const QVariantMap& params, QString& errorMessage)
 {
-    QString metadataPath = QDir(m_metadataDir).filePath(pluginId + ".json");
+    // Timed here, on the thread that runs the command, so its CPU clock is the right one
+    CallTimer timer;
+    QVariant result;
 
-    if (!QFile::exists(metadataPath)) {
-        LOG_ERROR("PluginManager", QString("Metadata file not found: %1").arg(metadataPath));
-        return false;
+    try {
+        result = provider ? provider->invokeCommand(commandId, params) : plugin->executeCommand(command, params);
+    } catch (const PluginException& ex) {
+        errorMessage = QString("Exception during command execution: %1").arg(ex.getMessage());
+    } catch (const std::exception& ex) {
+        errorMessage = QString("Exception during command execution: %1").arg(ex.what());
+    } catch (...) {
+        errorMessage = "Unknown exception during command execution";
     }
 
-    PluginMetadata metadata;
-    if (!metadata.loadFromFile(metadataPath)) {
-        LOG_ERROR("PluginManager", QString("Failed to load metadata from file: %1").arg(metadataPath));
-        return false;
+    if (timer.isActive()) {
+        PluginMetrics::instance().recordCommand(pluginId, timer.wallNs(), timer.cpuNs(), !errorMessage.isEmpty());
     }
 
-    if (!metadata.isValid()) {
-        LOG_ERROR("PluginManager", QString("Invalid metadata for plugin: %1").arg(pluginId));
-        return false;
+    return result;
+}
+
+QSharedPointer<QRecursiveMutex> PluginManager::pinPlugin(PluginHandle handle)
+{
+    QMutexLocker locker(&m_pinMutex);
+
+    CommandPin& pin = m_commandPins[handle];
+    if (pin.drains > 0) {
+        return QSharedPointer<QRecursiveMutex>();
     }
 
-    if (metadata.getPluginId() != pluginId) {
-        LOG_ERROR("PluginManager", QString("Metadata ID (%1) does not match plugin ID (%2)").arg(metadata.getPluginId(), pluginId));
-        return false;
+    if (!pin.commandMutex) {
+        pin.commandMutex.reset(new QRecursiveMutex);
+    }
+
+    ++pin.count;
+    m_lastUsed.insert(handle, m_idleClock.elapsed());
+
+    return pin.commandMutex;
+}
+
+void PluginManager::unpinPlugin(PluginHandle handle)
+{
+    QMutexLocker locker(&m_pinMutex);
+
+    auto it = m_commandPins.find(handle);
+    if (it != m_commandPins.end() && --it->count == 0) {
+        m_pinsReleased.wakeAll();
+    }
+
+    // Idle time counts from the end of the last command
+    m_lastUsed.insert(handle, m_idleClock.elapsed());
+}
+
+bool PluginManager::drainPluginCommands(const QString& pluginId)
+{
+    int timeoutMs = getCommandDrainTimeout();
+    return drainPluginCommands(pluginId, QDeadlineTimer(timeoutMs < 0 ? -1 : timeoutMs));
+}
+
+bool PluginManager::drainPluginCommands(const QString& pluginId, QDeadlineTimer deadline)
+{
+    PluginHandle handle = PluginHandle::fromId(pluginId);
+    {
+        QMutexLocker locker(&m_pinMutex);
+
+        CommandPin& pin = m_commandPins[handle];
+        ++pin.drains;
+
+        if (pin.count == 0) {
+            return true;
+        }
     }
 
-    m_pluginMetadata[pluginId] = metadata;
+    // A running command may be waiting for a call on this thread, so the wait is sliced to run those
+    QMutexLocker locker(&m_pinMutex);
+
+    while (m_commandPins.value(handle).count > 0) {
+        if (deadline.hasExpired()) {
+            return false;
+        }
+
+        m_pinsReleased.wait(&m_pinMutex, qMin(deadline, QDeadlineTimer(ServeIntervalMs)));
+
+        locker.unlock();
+        m_mutex.serveCalls();
+        locker.relock();
+    }
 
     return true;
 }
 
-bool PluginManager::checkPluginDependencies(const QString& pluginId)
+void PluginManager::endCommandDrain(const QString& pluginId)
 {
-    if (!m_pluginMetadata.contains(pluginId)) {
-        LOG_ERROR("PluginManager", QString("No metadata found for plugin: %1").arg(pluginId));
-        return false;
+    PluginHandle handle = PluginHandle::fromId(pluginId);
+    QMutexLocker locker(&m_pinMutex);
+
+    auto it = m_commandPins.find(handle);
+    if (it == m_commandPins.end()) {
+        return;
+    }
+
+    if (--it->drains == 0 && it->count == 0) {
+        m_commandPins.erase(it);
     }
+}
 
-    const PluginMetadata& metadata = m_pluginMetadata[pluginId];
-    QStringList dependencies = metadata.getPluginDependencies();
+bool PluginManager::invokeOnPluginThread(IPlugin* plugin, bool (IPlugin::*method)())
+{
+    bool result = false;
 
-    for (const QString& depId : dependencies) {
-        // Check if dependency metadata is available
-        if (!m_pluginMetadata.contains(depId)) {
-            if (!loadPluginMetadata(depId)) {
-                LOG_ERROR("PluginManager", QString("Failed to load metadata for dependency: %1").arg(depId));
-                return false;
+    runOnPluginThread(plugin, [plugin, method, &result]() {
+        result = callLifecycleMethod(plugin, method);
+    });
+
+    return result;
+}
+
+bool PluginManager::callLifecycleMethod(IPlugin* plugin, bool (IPlugin::*method)())
+{
+    CallTimer timer;
+
+    bool result = (plugin->*method)();
+
+    if (timer.isActive()) {
+        LifecyclePhase phase = LifecyclePhase::Initialize;
+        if (method == &IPlugin::activate) {
+            phase = LifecyclePhase::Activate;
+        } else if (method == &IPlugin::deactivate) {
+            phase = LifecyclePhase::Deactivate;
+        } else if (method == &IPlugin::shutdown) {
+            phase = LifecyclePhase::Shutdown;
+        }
+        PluginMetrics::instance().recordLifecycle(plugin->getPluginId(), phase, timer.wallNs(), timer.cpuNs());
+    }
+
+    return result;
+}
+
+void PluginManager::runOnPluginThread(IPlugin* plugin, const std::function<void()>& call)
+{
+    // A realized proxy forwards to its target, which may live on a thread of its own
+    QObject* context = pluginContext(plugin);
+    if (context->thread() == QThread::currentThread()) {
+        call();
+        return;
+    }
+
+    // Exceptions are rethrown here, so callers handle them as for a direct call
+    m_mutex.wait(m_mutex.post(context, call));
+}
+
+void PluginManager::adoptPluginObject(QObject* object)
+{
+    // Instances created by the lifecycle worker would otherwise live in a thread without an event loop
+    QCoreApplication* app = QCoreApplication::instance();
+    if (app && object->thread() != app->thread()) {
+        object->moveToThread(app->thread());
+    }
+}
+
+namespace {
+
+bool hasInteractiveCommands(QObject* instance)
+{
+    ICommandProvider* provider = qobject_cast<ICommandProvider*>(instance);
+    if (!provider) {
+        return false;
+    }
+
+    try {
+        const QList<PluginCommandDescriptor> descriptors = provider->commandDescriptors();
+        for (const PluginCommandDescriptor& descriptor : descriptors) {
+            if (descriptor.interactive) {
+                return true;
             }
         }
+    } catch (...) {
+        // Reported when the commands are published, which then publishes none
+    }
 
-        // Check if dependency is compatible with framework
-        const PluginMetadata& depMetadata = m_pluginMetadata[depId];
-        if (!depMetadata.isCompatibleWithFramework(m_frameworkVersion)) {
-            LOG_ERROR("PluginManager", QString("Dependency %1 is not compatible with framework version %2").arg(depId, m_frameworkVersion));
+    return false;
+}
+
+} // namespace
+
+void PluginManager::placePluginInstance(const QString& pluginId, QObject* instance, bool forceThread)
+{
+    // The manager's loader now holds a preloaded library as well
+    releasePreloadedLibrary(pluginId);
+
+    bool threaded = forceThread || m_threadedPlugins.contains(pluginId) || m_registry.metadata(PluginHandle::find(pluginId)).isThreaded();
+
+    // Dialogs can only be shown on the application thread
+    if (threaded && !forceThread && hasInteractiveCommands(instance)) {
+        LOG_WARNING("PluginManager", QString("Plugin %1 shows dialogs from its commands and stays on the application thread").arg(pluginId));
+        threaded = false;
+    }
+
+    if (!threaded) {
+        adoptPluginObject(instance);
+        return;
+    }
+
+    QThread* thread = new QThread();
+    thread->setObjectName(QString("Plugin %1").arg(pluginId));
+    thread->start();
+    instance->moveToThread(thread);
+
+    {
+        QWriteLocker stateLocker(&m_stateLock);
+        m_pluginThreads.insert(pluginId, thread);
+    }
+
+    LOG_INFO("PluginManager", QString("Plugin %1 runs on its own thread").arg(pluginId));
+}
+
+void PluginManager::retirePluginThread(const QString& pluginId, QObject* instance)
+{
+    QThread* thread = nullptr;
+    {
+        QWriteLocker stateLocker(&m_stateLock);
+        thread = m_pluginThreads.take(pluginId);
+    }
+
+    if (!thread) {
+        return;
+    }
+
+    // moveToThread() has to be called from the thread the object lives in
+    if (instance && instance->thread() == thread) {
+        QThread* callerThread = QThread::currentThread();
+        m_mutex.wait(m_mutex.post(instance, [instance, callerThread]() {
+            instance->moveToThread(callerThread);
+        }));
+    }
+
+    // Code still running there may be waiting for a call on this thread
+    thread->quit();
+    while (!thread->wait(QDeadlineTimer(ServeIntervalMs))) {
+        m_mutex.serveCalls();
+    }
+
+    delete thread;
+}
+
+bool PluginManager::suspendPluginMailbox(const QString& pluginId, QDeadlineTimer deadline)
+{
+    // A running handler may be waiting for a call on this thread, so the wait is sliced to run those
+    while (!PluginCommunication::instance().suspendMailbox(pluginId, qMin(deadline, QDeadlineTimer(ServeIntervalMs)))) {
+        if (deadline.hasExpired()) {
             return false;
         }
+        m_mutex.serveCalls();
     }
 
     return true;
 }
 
-QStringList PluginManager::getDependentPlugins(const QString& pluginId) const
+void PluginManager::destroyStaticInstance(QObject* instance)
 {
-    QStringList dependentPlugins;
+    // An object is deleted on the thread it lives in; the next load then creates a fresh instance
+    if (instance->thread() != QThread::currentThread()) {
+        QThread* callerThread = QThread::currentThread();
+        m_mutex.wait(m_mutex.post(instance, [instance, callerThread]() {
+            instance->moveToThread(callerThread);
+        }));
+    }
+
+    delete instance;
+}
+
+QObject* PluginManager::pluginContext(IPlugin* plugin)
+{
+    LazyPluginProxy* proxy = qobject_cast<LazyPluginProxy*>(plugin);
+    if (proxy && proxy->target()) {
+        return proxy->target();
+    }
+
+    return plugin;
+}
+
+bool PluginManager::hasDedicatedThread(IPlugin* plugin)
+{
+    QCoreApplication* app = QCoreApplication::instance();
+    return app && pluginContext(plugin)->thread() != app->thread();
+}
 
-    for (auto it = m_pluginMetadata.begin(); it != m_pluginMetadata.end(); ++it) {
-        if (it.key() != pluginId && it.value().dependsOn(pluginId)) {
-            dependentPlugins.append(it.key());
+void PluginManager::deferReactivation(const QString& pluginId, const QStringList& dependentPluginIds)
+{
+    if (dependentPluginIds.isEmpty()) {
+        return;
+    }
+
+    QStringList& deferredPluginIds = m_deferredReactivations[pluginId];
+    for (const QString& depId : dependentPluginIds) {
+        if (!deferredPluginIds.contains(depId)) {
+            deferredPluginIds.append(depId);
         }
     }
 
-    return dependentPlugins;
+    LOG_WARNING("PluginManager", QString("Dependents of plugin %1 stay inactive until it is active again: %2")
+                                     .arg(pluginId, dependentPluginIds.join(", ")));
 }
 
-QStringList PluginManager::sortPluginsByDependency(const QStringList& pluginIds)
+bool PluginManager::activatePlugins(const QStringList& pluginIds)
 {
-    QSet<QString> visited;
-    QStringList sortedPlugins;
+    bool success = true;
 
     for (const QString& pluginId : pluginIds) {
-        if (!visited.contains(pluginId)) {
-            buildDependencyGraph(pluginId, visited, sortedPlugins);
+        if (!activatePlugin(pluginId)) {
+            success = false;
         }
     }
 
-    return sortedPlugins;
+    return success;
 }
 
-void PluginManager::buildDependencyGraph(const QString& pluginId, QSet<QString>& visited, QStringList& sortedPlugins)
+void PluginManager::watchPluginLibraries()
 {
-    visited.insert(pluginId);
+    if (!m_libraryWatcher) {
+        return;
+    }
 
-    if (m_pluginMetadata.contains(pluginId)) {
-        const PluginMetadata& metadata = m_pluginMetadata[pluginId];
-        QStringList dependencies = metadata.getPluginDependencies();
+    QStringList paths;
 
-        for (const QString& depId : dependencies) {
-            if (!visited.contains(depId)) {
-                buildDependencyGraph(depId, visited, sortedPlugins);
+    {
+        QReadLocker locker(&m_stateLock);
+
+        if (!m_pluginDir.isEmpty()) {
+            paths.append(m_pluginDir);
+        }
+
+        const QList<PluginHandle> handles = m_registry.loadedPlugins();
+        for (PluginHandle handle : handles) {
+            QPluginLoader* loader = m_registry.loader(handle);
+            if (loader) {
+                paths.append(loader->fileName());
             }
         }
     }
 
-    sortedPlugins.append(pluginId);
+    const QStringList watchedFiles = m_libraryWatcher->files();
+    const QStringList watchedDirectories = m_libraryWatcher->directories();
+
+    QStringList newPaths;
+    for (const QString& path : paths) {
+        if (!watchedFiles.contains(path) && !watchedDirectories.contains(path) && QFileInfo::exists(path)) {
+            newPaths.append(path);
+        }
+    }
+
+    if (!newPaths.isEmpty()) {
+        m_libraryWatcher->addPaths(newPaths);
+    }
 }
+
+void PluginManager::reloadChangedPlugins()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_initialized) {
+        return;
+    }
+
+    QStringList changedPlugins;
+
+    for (auto it = m_libraryTimestamps.constBegin(); it != m_libraryTimestamps.constEnd(); ++it) {
+        QPluginLoader* loader = m_registry.loader(PluginHandle::find(it.key()));
+        if (!loader) {
+            continue;
+        }
+
+        // A library that is being replaced may be missing for a moment; the next change picks it up
+        QFileInfo libraryFile(loader->fileName());
+        if (libraryFile.exists() && libraryFile.lastModified() != it.value()) {
+            changedPlugins.append(it.key());
+        }
+    }
+
+    // Reload dependencies first so that dependents come back against the new builds
+    const QStringList sortedPluginIds = m_dependencyGraph.loadOrder(changedPlugins);
+    for (const QString& pluginId : sortedPluginIds) {
+        if (changedPlugins.contains(pluginId)) {
+            LOG_INFO("PluginManager", QString("Library of plugin %1 changed").arg(pluginId));
+            reloadPlugin(pluginId);
+        }
+    }
+}
\ No newline at end of file
@@ -10,24 +10,69 @@
 #include <QPluginLoader>
 #include <QMutex>
 #include <QRecursiveMutex>
+#include <QReadWriteLock>
+#include <QWaitCondition>
+#include <QSharedPointer>
+#include <QHash>
 #include <QSet>
 #include <QJsonObject>
 #include <QVariant>
 #include <QVariantMap>
+#include <QFuture>
+#include <QThreadPool>
+#include <functional>
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QAtomicInt>
 
+#include "ICommandProvider.h"
 #include "IPlugin.h"
+#include "LifecycleMutex.h"
+#include "PluginDependencyGraph.h"
 #include "PluginMetadata.h"
+#include "PluginMetadataIndex.h"
+#include "PluginRegistry.h"
+#include "PluginUsageHistory.h"
+#include "PluginVersionResolver.h"
+
+class LazyPluginProxy;
+class QFileSystemWatcher;
+class QThread;
+class QTimer;
+
+/**
+ * @brief Timing and outcome of one dependency level of a bulk load or activation
+ */
+struct PluginLevelReport {
+    int level = 0;                  ///< Dependency level, 0 for plugins without dependencies
+    QStringList pluginIds;          ///< Plugins in this level
+    QStringList failedPluginIds;    ///< Plugins of this level that failed or were skipped
+    qint64 loadMs = 0;              ///< Time spent loading the libraries of this level
+    qint64 initializeMs = 0;        ///< Time spent initializing this level
+    qint64 activateMs = 0;          ///< Time spent activating this level
+    qint64 deactivateMs = 0;        ///< Time spent deactivating and shutting down this level
+    qint64 unloadMs = 0;            ///< Time spent unloading the libraries of this level
+    QStringList timedOutPluginIds;  ///< Plugins of this level that missed the shutdown deadline
+};
+
+/**
+ * @brief One command of a batch passed to PluginManager::executePluginCommands()
+ */
+struct CommandRequest {
+    QString pluginId;               ///< Plugin to run the command on
+    QString command;                ///< Name of the command, used if commandId is -1
+    int commandId = -1;             ///< ID of a published command, or -1 to address it by name
+    QVariantMap params;             ///< Parameters for the command
+};
 
 /**
- * @brief Enumeration of plugin states
+ * @brief Outcome of one request of a command batch
  */
-enum class PluginState {
-    NotLoaded,
-    Loaded,
-    Initialized,
-    Active,
-    Inactive,
-    Failed
+struct CommandResult {
+    bool success = false;           ///< True if the command ran without throwing
+    QVariant result;                ///< Value returned by the command
+    QString errorMessage;           ///< Why the command did not run or failed, empty on success
 };
 
 /**
@@ -41,6 +86,20 @@ class PluginManager : public QObject
     Q_OBJECT
 
 public:
+    /**
+     * @brief Steps of a lifecycle operation, reported through pluginProgress()
+     */
+    enum class LifecycleStage {
+        ResolvingDependencies,
+        LoadingLibrary,
+        Initializing,
+        Activating,
+        Deactivating,
+        ShuttingDown,
+        Unloading
+    };
+    Q_ENUM(LifecycleStage)
+
     /**
      * @brief Get the singleton instance of PluginManager
      * 
@@ -59,15 +118,29 @@ public:
 
     /**
      * @brief Shutdown the plugin manager
+     * 
+     * Plugins are deactivated and shut down level by level in reverse dependency order.
+     * The plugins of a level run in parallel on their own threads; plugins without one
+     * get a temporary thread. All levels share one deadline, the shutdown timeout from
+     * the start of the teardown. A plugin that has not returned by then is marked Failed
+     * and left loaded, and the remaining plugins are unloaded without it.
+     * 
+     * @return Timing report for each dependency level, the last level first
      */
-    void shutdown();
+    QList<PluginLevelReport> shutdown();
 
     /**
      * @brief Scan for available plugins
      * 
+     * Metadata files that did not change since the last scan are read from the
+     * metadata index instead of being parsed again. With embedded metadata enabled,
+     * libraries in the plugin directory without a metadata file are registered from
+     * the metadata compiled into them.
+     * 
+     * @param rebuildIndex Discard the metadata index and parse every metadata file
      * @return List of plugin IDs found
      */
-    QStringList scanForPlugins();
+    QStringList scanForPlugins(bool rebuildIndex = false);
 
     /**
      * @brief Load a plugin
@@ -109,6 +182,180 @@ public:
      */
     bool deactivatePlugin(const QString& pluginId);
 
+    /**
+     * @brief Load and initialize all available plugins
+     * 
+     * Plugins are grouped into dependency levels. The libraries of a level are loaded
+     * in parallel on the global thread pool, after which each plugin of the level is
+     * initialized on the thread it lives in; plugins with threads of their own initialize
+     * in parallel. A level only starts once the previous one has finished. A failing plugin
+     * only fails the plugins that depend on it.
+     * 
+     * @return Timing report for each dependency level
+     */
+    QList<PluginLevelReport> loadAll();
+
+    /**
+     * @brief Load, initialize and activate all available plugins
+     * 
+     * Runs loadAll() and then activates the plugins level by level. Activation happens
+     * on the calling thread because plugins usually start timers in activate().
+     * 
+     * @return Timing report for each dependency level
+     */
+    QList<PluginLevelReport> activateAll();
+
+    /**
+     * @brief Load a plugin on the lifecycle worker
+     * 
+     * Asynchronous operations run one at a time in submission order on a dedicated
+     * worker thread and report their steps through pluginProgress(). Calls into the
+     * plugin object that may touch timers (activate, deactivate, shutdown) are made on
+     * the thread the plugin lives in, usually the GUI thread, so that thread must not
+     * block on the returned future. Use a QFutureWatcher instead.
+     * 
+     * @param pluginId ID of the plugin to load
+     * @return Future that becomes true if loading was successful
+     */
+    QFuture<bool> loadPluginAsync(const QString& pluginId);
+
+    /**
+     * @brief Activate a plugin on the lifecycle worker
+     * 
+     * Loads and initializes the plugin and its dependencies as needed.
+     * See loadPluginAsync() for the threading rules.
+     * 
+     * @param pluginId ID of the plugin to activate
+     * @return Future that becomes true if activation was successful
+     */
+    QFuture<bool> activatePluginAsync(const QString& pluginId);
+
+    /**
+     * @brief Deactivate a plugin on the lifecycle worker
+     * 
+     * See loadPluginAsync() for the threading rules.
+     * 
+     * @param pluginId ID of the plugin to deactivate
+     * @return Future that becomes true if deactivation was successful
+     */
+    QFuture<bool> deactivatePluginAsync(const QString& pluginId);
+
+    /**
+     * @brief Unload a plugin on the lifecycle worker
+     * 
+     * See loadPluginAsync() for the threading rules.
+     * 
+     * @param pluginId ID of the plugin to unload
+     * @return Future that becomes true if unloading was successful
+     */
+    QFuture<bool> unloadPluginAsync(const QString& pluginId);
+
+    /**
+     * @brief Replace a loaded plugin with a fresh instance from its library
+     * 
+     * Active dependents are deactivated first and reactivated afterwards. The plugin is
+     * brought back to the state it was in. Plugins implementing IHotReloadable carry their
+     * state over to the new instance. If the new instance cannot be loaded, initialized or
+     * activated, the old one is already gone; the dependents then stay inactive until the
+     * plugin is active again, for example after reloading a fixed library.
+     * 
+     * @param pluginId ID of the plugin to reload
+     * @return True if reloading was successful, false otherwise
+     */
+    bool reloadPlugin(const QString& pluginId);
+
+    /**
+     * @brief Reload a plugin on the lifecycle worker
+     * 
+     * See loadPluginAsync() for the threading rules.
+     * 
+     * @param pluginId ID of the plugin to reload
+     * @return Future that becomes true if reloading was successful
+     */
+    QFuture<bool> reloadPluginAsync(const QString& pluginId);
+
+    /**
+     * @brief Enable or disable reloading plugins when their library changes on disk
+     * 
+     * Must be called from the application thread. Changes are picked up once the
+     * library has not been written to for half a second.
+     * 
+     * @param enable True to watch plugin libraries, false to stop watching
+     */
+    void setHotReloadEnabled(bool enable);
+
+    /**
+     * @brief Check if plugin libraries are watched for changes
+     * 
+     * @return True if hot reload is enabled, false otherwise
+     */
+    bool isHotReloadEnabled() const;
+
+    /**
+     * @brief Set how long a plugin may go without commands or messages before it is unloaded
+     * 
+     * Must be called from the application thread. An idle plugin is deactivated, shut
+     * down and unloaded, and a lazy proxy in its previous state takes its place, so the
+     * next command or message loads it again. Plugins implementing IHotReloadable get
+     * their saved state back. Plugins with loaded dependents, running commands or an
+     * active QTimer child are kept.
+     * 
+     * @param timeoutMs Timeout in milliseconds, or 0 to keep idle plugins loaded
+     */
+    void setIdleTimeout(int timeoutMs);
+
+    /**
+     * @brief Get how long a plugin may go without commands or messages before it is unloaded
+     * 
+     * @return Timeout in milliseconds, 0 if idle plugins stay loaded
+     */
+    int getIdleTimeout() const;
+
+    /**
+     * @brief Override the idle timeout of one plugin
+     * 
+     * Must be called from the application thread.
+     * 
+     * @param pluginId ID of the plugin
+     * @param timeoutMs Timeout in milliseconds, 0 to keep the plugin loaded while idle, or a negative value to use the default
+     */
+    void setPluginIdleTimeout(const QString& pluginId, int timeoutMs);
+
+    /**
+     * @brief Limit the number of plugins whose library is loaded
+     * 
+     * Must be called from the application thread. Above the limit, the least recently
+     * used plugins are unloaded as if they had been idle for too long.
+     * 
+     * @param maxPlugins Maximum number of loaded plugins, or 0 for no limit
+     */
+    void setMaxLoadedPlugins(int maxPlugins);
+
+    /**
+     * @brief Get the maximum number of plugins whose library is loaded
+     * 
+     * @return Maximum number of loaded plugins, 0 if there is no limit
+     */
+    int getMaxLoadedPlugins() const;
+
+    /**
+     * @brief Apply the idle policy once
+     * 
+     * Runs periodically on the lifecycle worker while an idle timeout or a limit is set.
+     * 
+     * @return IDs of the plugins that were unloaded
+     */
+    QStringList unloadIdlePlugins();
+
+    /**
+     * @brief Record that a plugin is in use, postponing its idle unloading
+     * 
+     * Commands are recorded by the manager itself; PluginCommunication calls this for messages.
+     * 
+     * @param pluginId ID of the plugin
+     */
+    void markPluginUsed(const QString& pluginId);
+
     /**
      * @brief Get a plugin instance
      * 
@@ -117,6 +364,25 @@ public:
      */
     IPlugin* getPlugin(const QString& pluginId) const;
 
+    /**
+     * @brief Get a plugin instance
+     * 
+     * @param handle Handle of the plugin
+     * @return Pointer to the plugin instance, or nullptr if not found
+     */
+    IPlugin* getPlugin(PluginHandle handle) const;
+
+    /**
+     * @brief Get the handle of a plugin
+     * 
+     * Callers that address the same plugin repeatedly can keep the handle and use
+     * the handle-based overloads, which avoid looking the plugin up by string.
+     * 
+     * @param pluginId ID of the plugin
+     * @return Handle of the plugin, or an invalid handle if the plugin is unknown
+     */
+    PluginHandle getPluginHandle(const QString& pluginId) const;
+
     /**
      * @brief Get all loaded plugins
      * 
@@ -139,6 +405,16 @@ public:
      */
     PluginState getPluginState(const QString& pluginId) const;
 
+    /**
+     * @brief Get the state of a plugin
+     * 
+     * Reads the plugin's atomic state slot, so it never waits for a lifecycle operation.
+     * 
+     * @param handle Handle of the plugin
+     * @return State of the plugin
+     */
+    PluginState getPluginState(PluginHandle handle) const;
+
     /**
      * @brief Get the metadata of a plugin
      * 
@@ -147,6 +423,37 @@ public:
      */
     PluginMetadata getPluginMetadata(const QString& pluginId) const;
 
+    /**
+     * @brief Get the installed versions of a plugin
+     * 
+     * Versions are installed side by side as <id>-<version>.json metadata files and
+     * libraries such as lib<id>-<version>.so, next to the unversioned files.
+     * 
+     * @param pluginId ID of the plugin
+     * @return Installed versions, newest first
+     */
+    QStringList getInstalledVersions(const QString& pluginId) const;
+
+    /**
+     * @brief Pin a plugin to one of its installed versions
+     * 
+     * Without a pin, the newest version that satisfies the version ranges of its
+     * dependents is used. A loaded plugin switches versions when it is next loaded.
+     * 
+     * @param pluginId ID of the plugin
+     * @param version Version to use, or an empty string to remove the pin
+     * @return True if the version is valid, false otherwise
+     */
+    bool setPluginVersion(const QString& pluginId, const QString& version);
+
+    /**
+     * @brief Get the version conflict of a plugin
+     * 
+     * @param pluginId ID of the plugin
+     * @return Why no installed version satisfies the plugin's dependents, or an empty string
+     */
+    QString getVersionConflict(const QString& pluginId) const;
+
     /**
      * @brief Get all available plugins
      * 
@@ -162,6 +469,16 @@ public:
      */
     bool isPluginLoaded(const QString& pluginId) const;
 
+    /**
+     * @brief Check if a plugin is loaded
+     * 
+     * Lock-free, like getPluginState().
+     * 
+     * @param handle Handle of the plugin
+     * @return True if the plugin is loaded, false otherwise
+     */
+    bool isPluginLoaded(PluginHandle handle) const;
+
     /**
      * @brief Check if a plugin is active
      * 
@@ -170,9 +487,23 @@ public:
      */
     bool isPluginActive(const QString& pluginId) const;
 
+    /**
+     * @brief Check if a plugin is active
+     * 
+     * Lock-free, like getPluginState().
+     * 
+     * @param handle Handle of the plugin
+     * @return True if the plugin is active, false otherwise
+     */
+    bool isPluginActive(PluginHandle handle) const;
+
     /**
      * @brief Execute a command on a plugin
      * 
+     * The command runs without holding the lifecycle lock, so commands on different
+     * plugins run concurrently. Commands on the same plugin are serialized. While a
+     * command runs, the plugin is pinned and cannot be deactivated or unloaded.
+     * 
      * @param pluginId ID of the plugin
      * @param command Command to execute
      * @param params Parameters for the command
@@ -181,119 +512,976 @@ public:
     QVariant executePluginCommand(const QString& pluginId, const QString& command, const QVariantMap& params = QVariantMap());
 
     /**
-     * @brief Get the framework version
+     * @brief Execute a command on a plugin
      * 
-     * @return Framework version in format "major.minor.patch"
+     * @param handle Handle of the plugin
+     * @param command Command to execute
+     * @param params Parameters for the command
+     * @return Result of the command execution
      */
-    QString getFrameworkVersion() const;
+    QVariant executePluginCommand(PluginHandle handle, const QString& command, const QVariantMap& params = QVariantMap());
 
-signals:
     /**
-     * @brief Signal emitted when a plugin is loaded
+     * @brief Execute a published command by ID
      * 
-     * @param pluginId ID of the plugin
+     * The ID is looked up in the plugin's command table and the required parameters are
+     * checked before the command is dispatched through ICommandProvider::invokeCommand().
+     * Pinning and serialization are the same as for commands addressed by name.
+     * 
+     * @param handle Handle of the plugin
+     * @param commandId ID of the command
+     * @param params Parameters for the command
+     * @return Result of the command execution, or an invalid QVariant if the command is unknown
      */
-    void pluginLoaded(const QString& pluginId);
+    QVariant executePluginCommand(PluginHandle handle, int commandId, const QVariantMap& params = QVariantMap());
 
     /**
-     * @brief Signal emitted when a plugin is unloaded
+     * @brief Queue a command on the thread of a plugin
+     * 
+     * The command is posted to the plugin's event loop, on its own thread for threaded
+     * plugins and on the application thread otherwise, and the call returns at once.
+     * The plugin stays pinned until the command has run.
      * 
      * @param pluginId ID of the plugin
+     * @param command Command to execute
+     * @param params Parameters for the command
+     * @return Future that receives the result of the command execution, an invalid QVariant if it could not run
      */
-    void pluginUnloaded(const QString& pluginId);
+    QFuture<QVariant> executePluginCommandAsync(const QString& pluginId, const QString& command, const QVariantMap& params = QVariantMap());
 
     /**
-     * @brief Signal emitted when a plugin is initialized
+     * @brief Queue a published command by ID on the thread of a plugin
      * 
      * @param pluginId ID of the plugin
+     * @param commandId ID of the command
+     * @param params Parameters for the command
+     * @return Future that receives the result of the command execution, an invalid QVariant if it could not run
      */
-    void pluginInitialized(const QString& pluginId);
+    QFuture<QVariant> executePluginCommandAsync(const QString& pluginId, int commandId, const QVariantMap& params = QVariantMap());
 
     /**
-     * @brief Signal emitted when a plugin is activated
+     * @brief Execute a batch of commands
      * 
-     * @param pluginId ID of the plugin
+     * All requests are validated under a single lock, and commands addressed by name are
+     * resolved to published IDs where possible. Requests are then grouped by plugin: each
+     * plugin is pinned once and runs its requests in the order given, on the thread that
+     * owns the plugin. Plugins on different threads run in parallel; plugins living on the
+     * calling thread run on it one after another. Every request runs, repeats included.
+     * 
+     * @param requests Commands to execute
+     * @return One result per request, in the order of the requests
      */
-    void pluginActivated(const QString& pluginId);
+    QList<CommandResult> executePluginCommands(const QList<CommandRequest>& requests);
 
     /**
-     * @brief Signal emitted when a plugin is deactivated
+     * @brief Get the commands published by a plugin
+     * 
+     * Commands are published when the plugin's library is loaded, so a lazy plugin has
+     * none until its first command or message loads it.
      * 
      * @param pluginId ID of the plugin
+     * @return Descriptors ordered by command ID, or an empty list if the plugin publishes none
      */
-    void pluginDeactivated(const QString& pluginId);
+    QList<PluginCommandDescriptor> getPluginCommands(const QString& pluginId) const;
 
     /**
-     * @brief Signal emitted when a plugin fails to load, initialize, or activate
+     * @brief Set how long deactivation and unloading wait for running commands
      * 
-     * @param pluginId ID of the plugin
-     * @param errorMessage Error message
+     * @param timeoutMs Timeout in milliseconds, or a negative value to wait forever
      */
-    void pluginFailed(const QString& pluginId, const QString& errorMessage);
+    void setCommandDrainTimeout(int timeoutMs);
 
-private:
-    // Private constructor for singleton pattern
-    PluginManager();
-    
-    // Deleted copy constructor and assignment operator
-    PluginManager(const PluginManager&) = delete;
-    PluginManager& operator=(const PluginManager&) = delete;
-    
-    // Destructor
-    ~PluginManager();
+    /**
+     * @brief Get how long deactivation and unloading wait for running commands
+     * 
+     * @return Timeout in milliseconds
+     */
+    int getCommandDrainTimeout() const;
 
     /**
-     * @brief Load plugin metadata
+     * @brief Set how long shutdown() waits for the plugins of all dependency levels
+     * 
+     * @param timeoutMs Timeout in milliseconds, or a negative value to wait forever
+     */
+    void setShutdownTimeout(int timeoutMs);
+
+    /**
+     * @brief Get how long shutdown() waits for the plugins of all dependency levels
+     * 
+     * @return Timeout in milliseconds
+     */
+    int getShutdownTimeout() const;
+
+    /**
+     * @brief Enable or disable lazy loading
+     * 
+     * In lazy mode, loading a plugin registers a LazyPluginProxy built from its metadata
+     * instead of loading the library. The library is loaded, initialized and activated
+     * the first time a command or message targets the plugin.
+     * 
+     * @param enable True to enable lazy loading, false to disable
+     */
+    void setLazyLoadingEnabled(bool enable);
+
+    /**
+     * @brief Check if lazy loading is enabled
+     * 
+     * @return True if lazy loading is enabled, false otherwise
+     */
+    bool isLazyLoadingEnabled() const;
+
+    /**
+     * @brief Enable or disable reading plugin metadata from the libraries themselves
+     * 
+     * The Q_PLUGIN_METADATA JSON embedded in a library can be read without loading it.
+     * When enabled, a plugin no longer needs a file in the metadata directory; a file
+     * that exists still takes precedence.
+     * 
+     * @param enable True to fall back to embedded metadata, false to require metadata files
+     */
+    void setEmbeddedMetadataEnabled(bool enable);
+
+    /**
+     * @brief Check if embedded metadata is used
+     * 
+     * @return True if embedded metadata is used, false otherwise
+     */
+    bool isEmbeddedMetadataEnabled() const;
+
+    /**
+     * @brief Choose plugins to run on their own thread in addition to those whose metadata asks for it
+     * 
+     * A threaded plugin is moved to a dedicated QThread when it is loaded. Lifecycle calls
+     * and commands are marshalled onto that thread, and its signals reach the application
+     * through queued connections. Threaded plugins must not create widgets. Takes effect
+     * the next time a plugin is loaded.
+     * 
+     * @param pluginIds IDs of the plugins to run threaded
+     */
+    void setThreadedPlugins(const QStringList& pluginIds);
+
+    /**
+     * @brief Check if a plugin runs on its own thread
      * 
      * @param pluginId ID of the plugin
-     * @return True if loading was successful, false otherwise
+     * @return True if the plugin is loaded and lives on a dedicated thread, false otherwise
      */
-    bool loadPluginMetadata(const QString& pluginId);
+    bool isPluginThreaded(const QString& pluginId) const;
 
     /**
-     * @brief Check if a plugin's dependencies are satisfied
+     * @brief Load the real library behind a lazily loaded plugin
+     * 
+     * Lifecycle calls recorded by the proxy are replayed on the real instance.
+     * Dependencies are realized first.
      * 
      * @param pluginId ID of the plugin
-     * @return True if all dependencies are satisfied, false otherwise
+     * @return True if the plugin is backed by its real library afterwards, false otherwise
      */
-    bool checkPluginDependencies(const QString& pluginId);
+    bool realizePlugin(const QString& pluginId);
 
     /**
-     * @brief Get the plugins that depend on a specific plugin
+     * @brief Check if a plugin is backed by its real library
      * 
      * @param pluginId ID of the plugin
-     * @return List of plugin IDs that depend on the specified plugin
+     * @return False if the plugin is a lazy proxy whose library has not been loaded yet, true otherwise
      */
-    QStringList getDependentPlugins(const QString& pluginId) const;
+    bool isPluginRealized(const QString& pluginId) const;
 
     /**
-     * @brief Sort plugins by dependency order
+     * @brief Predict the plugins the operator is most likely to use
      * 
-     * @param pluginIds List of plugin IDs to sort
-     * @return Sorted list of plugin IDs
+     * The prediction is based on the usage history, which records every activation of
+     * a plugin's real instance.
+     * 
+     * @param maxPlugins Maximum number of plugins to return
+     * @return IDs of previously activated plugins, most likely first
      */
-    QStringList sortPluginsByDependency(const QStringList& pluginIds);
+    QStringList predictPluginUsage(int maxPlugins) const;
+
+    /**
+     * @brief Warm the libraries of the plugins most likely to be used
+     * 
+     * A lowest-priority background thread reads the libraries of the predicted plugins
+     * into the page cache and loads them, so that loading, activating or first using one
+     * of them only has to construct the instance. Plugins
+     * that were never activated, plugins whose library is already loaded and static
+     * plugins are skipped. Returns immediately.
+     * 
+     * @param maxPlugins Maximum number of plugins to preload
+     */
+    void preloadPlugins(int maxPlugins);
+
+    /**
+     * @brief Check if a plugin's library has been preloaded and is waiting to be used
+     * 
+     * @param pluginId ID of the plugin
+     * @return True if the library is preloaded, false otherwise
+     */
+    bool isPluginPreloaded(const QString& pluginId) const;
 
     /**
-     * @brief Recursively build dependency graph
+     * @brief Check if a plugin is linked into the host application
+     * 
+     * Static plugins are imported with Q_IMPORT_PLUGIN and found through
+     * QPluginLoader::staticPlugins(). They go through the same lifecycle as plugins
+     * loaded from a library, without a library file.
      * 
      * @param pluginId ID of the plugin
-     * @param visited Set of visited plugin IDs
-     * @param sortedPlugins List of sorted plugin IDs
+     * @return True if the plugin is a static plugin, false otherwise
+     */
+    bool isStaticPlugin(const QString& pluginId) const;
+
+    /**
+     * @brief Get the framework version
+     * 
+     * @return Framework version in format "major.minor.patch"
+     */
+    QString getFrameworkVersion() const;
+
+    /**
+     * @brief Get a readable name for a lifecycle step
+     * 
+     * @param stage Lifecycle step
+     * @return Name of the step, e.g. "Loading library"
+     */
+    static QString getLifecycleStageName(LifecycleStage stage);
+
+signals:
+    /**
+     * @brief Signal emitted when a plugin is loaded
+     * 
+     * @param pluginId ID of the plugin
+     */
+    void pluginLoaded(const QString& pluginId);
+
+    /**
+     * @brief Signal emitted when a plugin is unloaded
+     * 
+     * @param pluginId ID of the plugin
+     */
+    void pluginUnloaded(const QString& pluginId);
+
+    /**
+     * @brief Signal emitted when a plugin has been replaced by a fresh instance
+     * 
+     * @param pluginId ID of the plugin
+     */
+    void pluginReloaded(const QString& pluginId);
+
+    /**
+     * @brief Signal emitted when a plugin is initialized
+     * 
+     * @param pluginId ID of the plugin
+     */
+    void pluginInitialized(const QString& pluginId);
+
+    /**
+     * @brief Signal emitted when a plugin is activated
+     * 
+     * @param pluginId ID of the plugin
+     */
+    void pluginActivated(const QString& pluginId);
+
+    /**
+     * @brief Signal emitted when a plugin is deactivated
+     * 
+     * @param pluginId ID of the plugin
+     */
+    void pluginDeactivated(const QString& pluginId);
+
+    /**
+     * @brief Signal emitted when a plugin fails to load, initialize, or activate
+     * 
+     * @param pluginId ID of the plugin
+     * @param errorMessage Error message
+     */
+    void pluginFailed(const QString& pluginId, const QString& errorMessage);
+
+    /**
+     * @brief Signal emitted when a lifecycle operation on a plugin enters a new step
+     * 
+     * @param pluginId ID of the plugin
+     * @param stage Step the operation is entering
+     */
+    void pluginProgress(const QString& pluginId, PluginManager::LifecycleStage stage);
+
+    /**
+     * @brief Signal emitted when a plugin has published its commands
+     * 
+     * @param pluginId ID of the plugin
+     */
+    void pluginCommandsChanged(const QString& pluginId);
+
+private:
+    // Private constructor for singleton pattern
+    PluginManager();
+    
+    // Deleted copy constructor and assignment operator
+    PluginManager(const PluginManager&) = delete;
+    PluginManager& operator=(const PluginManager&) = delete;
+    
+    // Destructor
+    ~PluginManager();
+
+    /**
+     * @brief Load plugin metadata
+     * 
+     * @param pluginId ID of the plugin
+     * @return True if loading was successful, false otherwise
+     */
+    bool loadPluginMetadata(const QString& pluginId);
+
+    /**
+     * @brief Read the metadata of a metadata file, using the metadata index when possible
+     * 
+     * @param fileInfo Metadata file
+     * @param metadata Receives the metadata
+     * @return True if reading was successful, false otherwise
+     */
+    bool readPluginMetadata(const QFileInfo& fileInfo, PluginMetadata& metadata);
+
+    /**
+     * @brief Read the metadata embedded in a plugin library without loading it
+     * 
+     * Uses the metadata index when possible. Libraries that do not implement the
+     * IPlugin interface are rejected.
+     * 
+     * @param fileInfo Plugin library
+     * @param metadata Receives the metadata
+     * @return True if the library carries valid IPlugin metadata, false otherwise
+     */
+    bool readEmbeddedMetadata(const QFileInfo& fileInfo, PluginMetadata& metadata);
+
+    /**
+     * @brief Register plugins from the embedded metadata of libraries in the plugin directory
+     * 
+     * Plugins that already have metadata are skipped.
+     * 
+     * @param pluginIds Receives the IDs of the plugins registered
+     * @param libraryPaths Receives the absolute paths of the libraries examined
+     */
+    void scanEmbeddedMetadata(QStringList& pluginIds, QSet<QString>& libraryPaths);
+
+    /**
+     * @brief Find the library file of a plugin
+     * 
+     * @param pluginId ID of the plugin
+     * @return Path to the library, or an empty string if it does not exist
+     */
+    QString findPluginLibrary(const QString& pluginId) const;
+
+    /**
+     * @brief Check the metadata embedded in a plugin library before loading it
+     * 
+     * Verifies the interface ID, the plugin ID, the version against the registered
+     * metadata, and the minimum framework version, so a mismatched library is rejected
+     * without running its static initializers.
+     * 
+     * @param pluginId ID of the plugin
+     * @param pluginPath Path to the plugin library
+     * @return True if the library may be loaded, false otherwise
+     */
+    bool validatePluginLibrary(const QString& pluginId, const QString& pluginPath);
+
+    /**
+     * @brief Compare Qt plugin metadata against the registered metadata of a plugin
+     * 
+     * @param pluginId ID of the plugin
+     * @param embedded Metadata as returned by QPluginLoader::metaData()
+     * @return Reason the plugin does not match, or an empty string if it does
+     */
+    QString checkEmbeddedMetadata(const QString& pluginId, const QJsonObject& embedded) const;
+
+    /**
+     * @brief Validate metadata and register it for a plugin
+     * 
+     * Metadata whose dependencies would form a cycle is rejected.
+     * 
+     * @param pluginId ID of the plugin
+     * @param metadata Metadata to register
+     * @return True if the metadata is valid and was registered, false otherwise
+     */
+    bool registerPluginMetadata(const QString& pluginId, const PluginMetadata& metadata);
+
+    /**
+     * @brief Resolve plugin versions again and register the versions that changed
+     * 
+     * A loaded plugin keeps its registered version until it is loaded again. The caller
+     * must hold the write lock on the registry.
+     * 
+     * @return IDs of the plugins whose resolution changed
+     */
+    QStringList applyResolvedVersions();
+
+    /**
+     * @brief Register the resolved version of a plugin that is not loaded
+     * 
+     * The caller must hold the write lock on the registry.
+     * 
+     * @param pluginId ID of the plugin
+     */
+    void applyResolvedVersion(const QString& pluginId);
+
+    /**
+     * @brief Get the path of the metadata index file
+     * 
+     * @return Path to the metadata index file
+     */
+    QString metadataIndexPath() const;
+
+    /**
+     * @brief Get the path of the usage history file
+     * 
+     * @return Path to the usage history file
+     */
+    QString usageHistoryPath() const;
+
+    /**
+     * @brief Save the usage history if it changed, logging a failure
+     */
+    void saveUsageHistory();
+
+    /**
+     * @brief Check if a plugin's library is worth preloading
+     * 
+     * Must be called with the lifecycle lock held.
+     * 
+     * @param pluginId ID of the plugin
+     * @return True if the plugin has a library that is neither loaded nor preloaded, false otherwise
+     */
+    bool needsPreload(const QString& pluginId) const;
+
+    /**
+     * @brief Preload the libraries of plugins, called on the preloader thread
+     * 
+     * Libraries are read and loaded without the lifecycle lock, which is only taken to
+     * check that a plugin still needs preloading and to publish its loader. Instances are
+     * not constructed here but on the application thread once the plugin is loaded.
+     * 
+     * @param pluginIds IDs of the plugins, most likely first
+     */
+    void runPreloader(const QStringList& pluginIds);
+
+    /**
+     * @brief Read a file once so that its pages are in the page cache
+     * 
+     * @param filePath Path of the file
+     */
+    static void readAheadFile(const QString& filePath);
+
+    /**
+     * @brief Drop the preloader's reference to a plugin library
+     * 
+     * The library stays loaded if a plugin loader of the manager also holds it.
+     * 
+     * @param pluginId ID of the plugin
+     */
+    void releasePreloadedLibrary(const QString& pluginId);
+
+    /**
+     * @brief Cancel preloading and wait for the preloader thread
+     * 
+     * Must be called without the lifecycle lock, which the preloader takes.
+     */
+    void stopPreloader();
+
+    /**
+     * @brief Check if a plugin's dependencies are satisfied
+     * 
+     * @param pluginId ID of the plugin
+     * @return True if all dependencies are satisfied, false otherwise
+     */
+    bool checkPluginDependencies(const QString& pluginId);
+
+    /**
+     * @brief Get the plugins that depend on a specific plugin
+     * 
+     * @param pluginId ID of the plugin
+     * @return List of plugin IDs that depend on the specified plugin
+     */
+    QStringList getDependentPlugins(const QString& pluginId) const;
+
+    /**
+     * @brief Sort plugins by dependency order
+     * 
+     * @param pluginIds List of plugin IDs to sort
+     * @return Sorted list of plugin IDs
+     */
+    QStringList sortPluginsByDependency(const QStringList& pluginIds);
+
+    /**
+     * @brief Group dependency-sorted plugins into levels
+     * 
+     * A plugin's level is one more than the highest level of its dependencies.
+     * 
+     * @param sortedPluginIds Plugin IDs in dependency order
+     * @return Plugin IDs grouped by level, lowest level first
+     */
+    QList<QStringList> groupPluginsByLevel(const QStringList& sortedPluginIds) const;
+
+    /**
+     * @brief Load the libraries of one dependency level in parallel
+     * 
+     * @param pluginIds Plugin IDs of the level
+     * @param failedPlugins Plugins that failed so far, updated with new failures
+     * @return Plugin IDs of the level that are loaded afterwards
+     */
+    QStringList loadPluginLevel(const QStringList& pluginIds, QSet<QString>& failedPlugins);
+
+    /**
+     * @brief Initialize the plugins of one dependency level, each on the thread it lives in
+     * 
+     * @param pluginIds Loaded plugin IDs of the level
+     * @param failedPlugins Plugins that failed so far, updated with new failures
+     */
+    void initializePluginLevel(const QStringList& pluginIds, QSet<QString>& failedPlugins);
+
+    /**
+     * @brief Deactivate, shut down and unload the plugins of one dependency level
+     * 
+     * @param report Report of the level, with its plugin IDs set; timings and failures are filled in
+     * @param deadline Deadline of the whole shutdown, shared by all levels
+     * @param retainedPlugins Plugins whose libraries must stay loaded, extended with the dependencies of plugins that time out
+     */
+    void shutdownPluginLevel(PluginLevelReport& report, const QDeadlineTimer& deadline, QSet<QString>& retainedPlugins);
+
+    /**
+     * @brief Give up on a plugin that did not shut down in time
+     * 
+     * The plugin is marked Failed. Its thread and library stay alive, since its code may still be running.
+     * 
+     * @param pluginId ID of the plugin
+     */
+    void abandonPlugin(const QString& pluginId);
+
+    /**
+     * @brief Check the metadata and dependencies of a plugin and locate its library
+     * 
+     * Marks the plugin as failed if any check does not pass.
+     * 
+     * @param pluginId ID of the plugin
+     * @param pluginPath Receives the path to the plugin library, or an empty string for a static plugin
+     * @return True if the plugin may be loaded, false otherwise
+     */
+    bool preparePluginLoad(const QString& pluginId, QString& pluginPath);
+
+    /**
+     * @brief Collect the IPlugin implementations linked into the host application
+     */
+    void discoverStaticPlugins();
+
+    /**
+     * @brief Create the instance of a static plugin
+     * 
+     * @param pluginId ID of the plugin
+     * @return The plugin instance, or nullptr if the plugin is not a static plugin
+     */
+    QObject* createStaticPluginInstance(const QString& pluginId) const;
+
+    /**
+     * @brief Construct a plugin instance on the application thread
+     * 
+     * The instance of a library loaded earlier, for example by the preloader, is only
+     * constructed now. Placing it on a thread of its own is up to the caller.
+     * 
+     * @param pluginId ID of the plugin
+     * @param loader Loader of the plugin's library, or nullptr for a static plugin
+     * @return The plugin instance, or nullptr if it could not be created
+     */
+    QObject* createPluginInstance(const QString& pluginId, QPluginLoader* loader);
+
+    /**
+     * @brief Load a plugin, optionally through a lazy proxy
+     * 
+     * @param pluginId ID of the plugin to load
+     * @param allowLazy True to register a lazy proxy instead of loading the library
+     * @return True if loading was successful, false otherwise
+     */
+    bool loadPluginInstance(const QString& pluginId, bool allowLazy);
+
+    /**
+     * @brief Tear down a loaded plugin without checking its dependents
+     * 
+     * The caller must hold a command drain on the plugin, see drainPluginCommands(), and
+     * have suspended its mailbox with suspendPluginMailbox().
+     * 
+     * @param pluginId ID of the plugin to unload
+     * @param reloadState Receives the state saved by an IHotReloadable plugin, or nullptr
+     * @return True if unloading was successful, false otherwise
+     */
+    bool releasePlugin(const QString& pluginId, QVariant* reloadState);
+
+    /**
+     * @brief Activate plugins in the given order
+     * 
+     * @param pluginIds IDs of the plugins to activate
+     * @return True if all plugins were activated, false otherwise
+     */
+    bool activatePlugins(const QStringList& pluginIds);
+
+    /**
+     * @brief Remember dependents to reactivate once a plugin whose reload failed is active again
+     * 
+     * Must be called with the lifecycle lock held.
+     * 
+     * @param pluginId ID of the reloaded plugin
+     * @param dependentPluginIds Dependents deactivated for the reload, each after the plugins it needs
+     */
+    void deferReactivation(const QString& pluginId, const QStringList& dependentPluginIds);
+
+    /**
+     * @brief Add the plugin directory and the loaded libraries to the library watcher
+     */
+    void watchPluginLibraries();
+
+    /**
+     * @brief Reload every plugin whose library changed since it was loaded
+     */
+    void reloadChangedPlugins();
+
+    /**
+     * @brief Instantiate a loaded plugin library or a static plugin and register the plugin
+     * 
+     * Takes ownership of the loader. Marks the plugin as failed if the library does not
+     * provide an IPlugin instance.
+     * 
+     * @param pluginId ID of the plugin
+     * @param loader Loader whose library has been loaded, or nullptr for a static plugin
+     * @return True if the plugin was registered, false otherwise
+     */
+    bool attachPluginInstance(const QString& pluginId, QPluginLoader* loader);
+
+    /**
+     * @brief Mark a plugin as failed and notify listeners
+     * 
+     * @param pluginId ID of the plugin
+     * @param errorMessage Error message
+     */
+    void markPluginFailed(const QString& pluginId, const QString& errorMessage);
+
+    /**
+     * @brief Register a lazy proxy for a plugin instead of loading its library
+     * 
+     * @param pluginId ID of the plugin
+     * @param state State the proxy starts in; the lifecycle calls it implies are replayed when the library is loaded
+     */
+    void attachLazyProxy(const QString& pluginId, PluginState state = PluginState::Loaded);
+
+    /**
+     * @brief Start, restart or stop the timer that applies the idle policy
+     */
+    void updateIdleTimer();
+
+    /**
+     * @brief Replace an idle plugin with a lazy proxy
+     * 
+     * Takes the lifecycle lock itself. A plugin that was active is reported as activated
+     * again once its proxy is in place.
+     * 
+     * @param pluginId ID of the plugin
+     * @return True if the plugin was unloaded, false if it is in use or could not be unloaded
+     */
+    bool evictPlugin(const QString& pluginId);
+
+    /**
+     * @brief Check if a plugin has a running QTimer
+     * 
+     * @param plugin Plugin instance or realized proxy
+     * @return True if a QTimer child of the real instance is active, false otherwise
+     */
+    static bool hasActiveTimers(IPlugin* plugin);
+
+    /**
+     * @brief Hand state saved by IHotReloadable::saveReloadState() to a new instance
+     * 
+     * Failures are logged and otherwise ignored.
+     * 
+     * @param pluginId ID of the plugin
+     * @param plugin New plugin instance or realized proxy
+     * @param reloadState State saved from the previous instance
+     */
+    void restoreReloadState(const QString& pluginId, IPlugin* plugin, const QVariant& reloadState);
+
+    /**
+     * @brief Call a lifecycle method on the thread the plugin lives in
+     * 
+     * Blocks until the call returns, as described for runOnPluginThread(). Exceptions
+     * thrown by the plugin are rethrown on the calling thread.
+     * 
+     * @param plugin Plugin instance
+     * @param method Lifecycle method to call
+     * @return Return value of the method
+     */
+    bool invokeOnPluginThread(IPlugin* plugin, bool (IPlugin::*method)());
+
+    /**
+     * @brief Call a lifecycle method on the current thread and record its duration in PluginMetrics
+     * 
+     * @param plugin Plugin instance
+     * @param method Lifecycle method to call
+     * @return Return value of the method
+     */
+    static bool callLifecycleMethod(IPlugin* plugin, bool (IPlugin::*method)());
+
+    /**
+     * @brief Run a function on the thread the plugin lives in
+     * 
+     * Blocks until the function returns, running calls posted to the calling thread
+     * meanwhile. A caller holding the lifecycle lock keeps it, and the function runs as
+     * its owner, so it may lock it again. Exceptions are rethrown on the calling thread.
+     * 
+     * @param plugin Plugin instance or lazy proxy
+     * @param call Function to run
+     */
+    void runOnPluginThread(IPlugin* plugin, const std::function<void()>& call);
+
+    /**
+     * @brief Hold messages posted to a plugin and wait for its running handler to finish
+     * 
+     * Calls posted to the calling thread run while it waits. Every call must be matched
+     * by PluginCommunication::resumeMailbox(), unless the mailbox stays suspended.
+     * 
+     * @param pluginId ID of the plugin
+     * @param deadline Time at which to give up waiting
+     * @return True if no handler is running anymore, false on timeout
+     */
+    bool suspendPluginMailbox(const QString& pluginId, QDeadlineTimer deadline = QDeadlineTimer(QDeadlineTimer::Forever));
+
+    /**
+     * @brief Move a plugin object created off the application thread to the application thread
+     * 
+     * @param object Plugin instance or lazy proxy
+     */
+    void adoptPluginObject(QObject* object);
+
+    /**
+     * @brief Move a new plugin instance to the thread it will live on
+     * 
+     * Threaded plugins get a dedicated thread; all others go to the application thread.
+     * 
+     * @param pluginId ID of the plugin
+     * @param instance Real plugin instance
+     * @param forceThread True to give the instance a dedicated thread even if the plugin is not threaded
+     */
+    void placePluginInstance(const QString& pluginId, QObject* instance, bool forceThread = false);
+
+    /**
+     * @brief Stop the dedicated thread of a plugin
+     * 
+     * The instance is first moved to the calling thread so that it can be deleted there.
+     * 
+     * @param pluginId ID of the plugin
+     * @param instance Real plugin instance, or nullptr if there is none
+     */
+    void retirePluginThread(const QString& pluginId, QObject* instance);
+
+    /**
+     * @brief Delete the instance of a static plugin, which cannot be unloaded
+     * 
+     * An instance living on another thread is first moved to the calling thread.
+     * 
+     * @param instance Instance of a plugin linked into the host
+     */
+    void destroyStaticInstance(QObject* instance);
+
+    /**
+     * @brief Get the object whose thread a plugin's calls must run on
+     * 
+     * @param plugin Plugin instance or lazy proxy
+     * @return The real instance behind a realized proxy, otherwise the plugin itself
+     */
+    static QObject* pluginContext(IPlugin* plugin);
+
+    /**
+     * @brief Check if a plugin lives on a dedicated thread
+     * 
+     * @param plugin Plugin instance or lazy proxy
+     * @return True if calls to the plugin must be marshalled to another thread
+     */
+    static bool hasDedicatedThread(IPlugin* plugin);
+
+    /**
+     * @brief Update the state of a plugin
+     * 
+     * @param pluginId ID of the plugin
+     * @param state New state
+     */
+    void setPluginState(const QString& pluginId, PluginState state);
+
+    /**
+     * @brief Get the state of a plugin without taking the state lock
+     * 
+     * Only valid while the lifecycle lock is held, since state is only written under it.
+     * 
+     * @param pluginId ID of the plugin
+     * @return State of the plugin
+     */
+    PluginState pluginState(const QString& pluginId) const;
+
+    /**
+     * @brief Read the commands of a plugin instance into its command table
+     * 
+     * @param pluginId ID of the plugin
+     * @param pluginInstance Real plugin instance
+     */
+    void publishPluginCommands(const QString& pluginId, QObject* pluginInstance);
+
+    /**
+     * @brief Queue a command on the thread of a plugin
+     * 
+     * @param pluginId ID of the plugin
+     * @param commandId ID of the command, or -1 to address it by name
+     * @param command Name of the command if commandId is -1
+     * @param params Parameters for the command
+     * @return Future that receives the result of the command execution, an invalid QVariant if it could not run
+     */
+    QFuture<QVariant> postPluginCommand(const QString& pluginId, int commandId, const QString& command,
+                                        const QVariantMap& params);
+
+    /**
+     * @brief Check the parameters of a command against its published schema
+     * 
+     * @param pluginId ID of the plugin
+     * @param descriptor Descriptor of the command
+     * @param params Parameters for the command
+     * @return Reason the parameters do not match, or an empty string if they do
+     */
+    static QString checkCommandParameters(const QString& pluginId, const PluginCommandDescriptor& descriptor,
+                                          const QVariantMap& params);
+
+    /**
+     * @brief Call a command on the current thread, catching exceptions
+     * 
+     * The call is recorded in PluginMetrics.
+     * 
+     * @param pluginId ID of the plugin
+     * @param plugin Plugin instance or lazy proxy
+     * @param provider Command provider to dispatch by ID, or nullptr to dispatch by name
+     * @param commandId ID of the command if provider is set
+     * @param command Name of the command if provider is null
+     * @param params Parameters for the command
+     * @param errorMessage Receives a description of an exception thrown by the command
+     * @return Result of the command execution
+     */
+    static QVariant dispatchPluginCommand(const QString& pluginId, IPlugin* plugin, ICommandProvider* provider, int commandId,
+                                          const QString& command, const QVariantMap& params, QString& errorMessage);
+
+    /**
+     * @brief Run a command on a pinned plugin
+     * 
+     * @param handle Handle of the plugin
+     * @param commandId ID of the command, or -1 to address it by name
+     * @param command Name of the command if commandId is -1
+     * @param params Parameters for the command
+     * @param commandMutex Mutex serializing the plugin's commands
+     * @return Result of the command execution
+     */
+    QVariant runPluginCommand(PluginHandle handle, int commandId, const QString& command, const QVariantMap& params,
+                              QRecursiveMutex* commandMutex);
+
+    /**
+     * @brief Pin a plugin for the duration of a command
+     * 
+     * @param handle Handle of the plugin
+     * @return Mutex serializing the plugin's commands, or null if the plugin is being torn down
+     */
+    QSharedPointer<QRecursiveMutex> pinPlugin(PluginHandle handle);
+
+    /**
+     * @brief Release a pin taken by pinPlugin()
+     * 
+     * @param handle Handle of the plugin
+     */
+    void unpinPlugin(PluginHandle handle);
+
+    /**
+     * @brief Refuse new commands on a plugin and wait for running ones to finish
+     * 
+     * Calls posted to the calling thread run while it waits. Every call must be matched
+     * by endCommandDrain().
+     * 
+     * @param pluginId ID of the plugin
+     * @return True if no command is running anymore, false on timeout
+     */
+    bool drainPluginCommands(const QString& pluginId);
+
+    /**
+     * @brief Refuse new commands on a plugin and wait for running ones until a deadline
+     * 
+     * Calls posted to the calling thread run while it waits. Every call must be matched
+     * by endCommandDrain().
+     * 
+     * @param pluginId ID of the plugin
+     * @param deadline Time at which to give up waiting
+     * @return True if no command is running anymore, false on timeout
+     */
+    bool drainPluginCommands(const QString& pluginId, QDeadlineTimer deadline);
+
+    /**
+     * @brief Accept commands on a plugin again after drainPluginCommands()
+     * 
+     * @param pluginId ID of the plugin
+     */
+    void endCommandDrain(const QString& pluginId);
+
+    /**
+     * @brief A plugin linked into the host application
+     */
+    struct StaticPlugin {
+        QtPluginInstanceFunction instance = nullptr;    ///< Returns the plugin instance, creating it if needed
+        QJsonObject metaData;                           ///< Metadata as returned by QStaticPlugin::metaData()
+    };
+
+    /**
+     * @brief Per-plugin bookkeeping of running commands
      */
-    void buildDependencyGraph(const QString& pluginId, QSet<QString>& visited, QStringList& sortedPlugins);
+    struct CommandPin {
+        int count = 0;                                  ///< Commands currently running
+        int drains = 0;                                 ///< Pending drains refusing new commands
+        QSharedPointer<QRecursiveMutex> commandMutex;   ///< Serializes the plugin's commands
+    };
 
     QString m_pluginDir;
     QString m_metadataDir;
-    QMap<QString, QPluginLoader*> m_pluginLoaders;
-    QMap<QString, IPlugin*> m_plugins;
-    QMap<QString, PluginMetadata> m_pluginMetadata;
-    QMap<QString, PluginState> m_pluginStates;
-    mutable QRecursiveMutex m_mutex;
+    PluginRegistry m_registry;
+    PluginDependencyGraph m_dependencyGraph;       // Dependencies of the registered versions
+    PluginVersionResolver m_versionResolver;        // All installed versions and the resolved plan
+    PluginMetadataIndex m_metadataIndex;
+    bool m_metadataIndexLoaded;
+    bool m_lazyLoading;
+    bool m_embeddedMetadata;
+    QHash<QString, QString> m_libraryPaths;    // Libraries found by scanEmbeddedMetadata(), by ID and by <id>-<version>
+    QHash<QString, StaticPlugin> m_staticPlugins;    // Plugins linked into the host, by plugin ID
+    QSet<QString> m_threadedPlugins;                // Plugins threaded by configuration
+    QHash<QString, QThread*> m_pluginThreads;       // Dedicated threads of loaded plugins
+    PluginUsageHistory m_usageHistory;
+    QHash<QString, QPluginLoader*> m_preloadedLibraries;    // Loaded by the preloader, not yet used
+    QThread* m_preloadThread;
+    QAtomicInt m_preloadCancelled;
+    QFileSystemWatcher* m_libraryWatcher;       // Non-null while hot reload is enabled
+    QTimer* m_reloadTimer;                      // Debounces library change notifications
+    QTimer* m_idleTimer;                        // Non-null while an idle policy is set
+    int m_idleTimeout;
+    int m_maxLoadedPlugins;
+    QHash<QString, int> m_pluginIdleTimeouts;
+    QHash<PluginHandle, qint64> m_lastUsed;     // Last use in m_idleClock milliseconds, guarded by m_pinMutex
+    QElapsedTimer m_idleClock;
+    QHash<QString, QVariant> m_evictedStates;   // Reload state of plugins unloaded while idle
+    QHash<QString, QStringList> m_deferredReactivations;    // Dependents left inactive by a failed reload, by plugin
+    QHash<QString, QDateTime> m_libraryTimestamps;
+    mutable LifecycleMutex m_mutex;             // Lifecycle lock, serializes loading, activation and unloading
+    mutable QReadWriteLock m_stateLock;         // Guards the registry for readers outside the lifecycle lock
+    QHash<PluginHandle, CommandPin> m_commandPins;
+    mutable QMutex m_pinMutex;
+    QWaitCondition m_pinsReleased;
+    int m_commandDrainTimeout;
+    int m_shutdownTimeout;
+    QThreadPool m_lifecyclePool;                // Runs asynchronous lifecycle operations
     bool m_initialized;
     
     // Framework version
     const QString m_frameworkVersion = "1.0.0";
+    const QVersionNumber m_frameworkVersionNumber = QVersionNumber::fromString(m_frameworkVersion);
 };
 
 #endif // PLUGINMANAGER_H
\ No newline at end of file
@@ -1,17 +1,14 @@
 #include "PluginMetadata.h"
 
-PluginMetadata::PluginMetadata() : m_isValid(false)
+#include <QSaveFile>
+
+PluginMetadata::PluginMetadata() : m_data(emptyData())
 {
 }
 
-PluginMetadata::PluginMetadata(const QJsonObject& metadataJson) : m_metadata(metadataJson)
+PluginMetadata::PluginMetadata(const QJsonObject& metadataJson) : m_data(new Data)
 {
-    // Check if the metadata contains all required fields
-    m_isValid = !m_metadata.isEmpty() &&
-                m_metadata.contains("id") &&
-                m_metadata.contains("name") &&
-                m_metadata.contains("version") &&
-                m_metadata.contains("vendor");
+    parse(metadataJson);
 }
 
 bool PluginMetadata::loadFromFile(const QString& filePath)
@@ -24,126 +21,274 @@ bool PluginMetadata::loadFromFile(const QString& filePath)
     QByteArray jsonData = file.readAll();
     file.close();
 
-    return loadFromString(QString::fromUtf8(jsonData));
+    return loadFromData(jsonData);
 }
 
 bool PluginMetadata::loadFromString(const QString& jsonString)
 {
-    QJsonDocument doc = QJsonDocument::fromJson(jsonString.toUtf8());
-    if (doc.isNull() || !doc.isObject()) {
-        m_isValid = false;
+    return loadFromData(jsonString.toUtf8());
+}
+
+bool PluginMetadata::loadFromData(const QByteArray& jsonData)
+{
+    QJsonObject metadataJson;
+    if (!DocumentCodec::decode(jsonData, metadataJson)) {
+        m_data->valid = false;
+        return false;
+    }
+
+    parse(metadataJson);
+
+    return m_data->valid;
+}
+
+bool PluginMetadata::saveToFile(const QString& filePath, DocumentCodec::Format format) const
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
         return false;
     }
 
-    m_metadata = doc.object();
-    
+    file.write(DocumentCodec::encode(m_data->json, format));
+
+    return file.commit();
+}
+
+void PluginMetadata::parse(const QJsonObject& metadataJson)
+{
+    Data* data = new Data;
+    data->json = metadataJson;
+
     // Check if the metadata contains all required fields
-    m_isValid = !m_metadata.isEmpty() &&
-                m_metadata.contains("id") &&
-                m_metadata.contains("name") &&
-                m_metadata.contains("version") &&
-                m_metadata.contains("vendor");
-    
-    return m_isValid;
+    data->valid = !metadataJson.isEmpty() &&
+                  metadataJson.contains("id") &&
+                  metadataJson.contains("name") &&
+                  metadataJson.contains("version") &&
+                  metadataJson.contains("vendor");
+
+    data->id = metadataJson.value("id").toString();
+    data->handle = PluginHandle::find(data->id);
+    data->name = metadataJson.value("name").toString();
+    data->version = metadataJson.value("version").toString();
+    data->versionNumber = QVersionNumber::fromString(data->version);
+    data->vendor = metadataJson.value("vendor").toString();
+    data->description = metadataJson.value("description").toString();
+    data->minFrameworkVersion = metadataJson.value("minFrameworkVersion").toString("1.0.0");
+    data->minFrameworkVersionNumber = QVersionNumber::fromString(data->minFrameworkVersion);
+    data->category = metadataJson.value("category").toString();
+    data->iconPath = metadataJson.value("iconPath").toString();
+    data->requiredPermissions = toStringList(metadataJson.value("requiredPermissions"));
+    data->threaded = metadataJson.value("threaded").toBool();
+
+    if (!parseDependencies(metadataJson.value("dependencies"), data)) {
+        data->valid = false;
+    }
+
+    // Parsing only looks up IDs, so that scanning files does not grow the intern table;
+    // IDs seen for the first time are interned when the metadata is registered
+    data->interned = data->handle.isValid() && !data->dependencyHandles.contains(PluginHandle());
+
+    m_data = data;
+}
+
+void PluginMetadata::internHandles()
+{
+    if (m_data.constData()->interned || m_data.constData()->id.isEmpty()) {
+        return;
+    }
+
+    Data* data = m_data.data();
+    data->handle = PluginHandle::fromId(data->id);
+    for (int i = 0; i < data->dependencies.size(); ++i) {
+        data->dependencyHandles[i] = PluginHandle::fromId(data->dependencies[i]);
+    }
+    data->interned = true;
+}
+
+bool PluginMetadata::parseDependencies(const QJsonValue& value, Data* data)
+{
+    QStringList dependencies;
+    QStringList ranges;
+
+    if (value.isObject()) {
+        const QJsonObject object = value.toObject();
+        for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+            dependencies.append(it.key());
+            ranges.append(it.value().toString());
+        }
+    } else {
+        const QStringList entries = toStringList(value);
+        for (const QString& entry : entries) {
+            // "Compression >=1.2 <2" names the dependency first
+            QString trimmed = entry.trimmed();
+            int separator = trimmed.indexOf(' ');
+            dependencies.append(separator < 0 ? trimmed : trimmed.left(separator));
+            ranges.append(separator < 0 ? QString() : trimmed.mid(separator + 1));
+        }
+    }
+
+    bool valid = true;
+    data->dependencyHandles.reserve(dependencies.size());
+    data->dependencyRanges.reserve(dependencies.size());
+
+    for (int i = 0; i < dependencies.size(); ++i) {
+        bool ok = false;
+        data->dependencyHandles.append(PluginHandle::find(dependencies[i]));
+        data->dependencyRanges.append(PluginVersionRange::fromString(ranges[i], &ok));
+        valid = valid && ok;
+    }
+    data->dependencies = dependencies;
+
+    return valid;
+}
+
+QSharedDataPointer<PluginMetadata::Data> PluginMetadata::emptyData()
+{
+    // Registry arrays hold many empty entries, so they all share one instance
+    static const QSharedDataPointer<Data> empty(new Data);
+    return empty;
+}
+
+QStringList PluginMetadata::toStringList(const QJsonValue& value)
+{
+    QStringList strings;
+    const QJsonArray array = value.toArray();
+    strings.reserve(array.size());
+
+    for (const QJsonValue& element : array) {
+        strings.append(element.toString());
+    }
+
+    return strings;
 }
 
 bool PluginMetadata::isValid() const
 {
-    return m_isValid;
+    return m_data->valid;
 }
 
 QString PluginMetadata::getPluginId() const
 {
-    return m_metadata.value("id").toString();
+    return m_data->id;
 }
 
 QString PluginMetadata::getPluginName() const
 {
-    return m_metadata.value("name").toString();
+    return m_data->name;
 }
 
 QString PluginMetadata::getPluginVersion() const
 {
-    return m_metadata.value("version").toString();
+    return m_data->version;
 }
 
 QVersionNumber PluginMetadata::getVersionNumber() const
 {
-    return QVersionNumber::fromString(getPluginVersion());
+    return m_data->versionNumber;
+}
+
+PluginHandle PluginMetadata::getPluginHandle() const
+{
+    return m_data->interned ? m_data->handle : PluginHandle::find(m_data->id);
 }
 
 QString PluginMetadata::getPluginVendor() const
 {
-    return m_metadata.value("vendor").toString();
+    return m_data->vendor;
 }
 
 QString PluginMetadata::getPluginDescription() const
 {
-    return m_metadata.value("description").toString();
+    return m_data->description;
 }
 
 QStringList PluginMetadata::getPluginDependencies() const
 {
-    QStringList dependencies;
-    QJsonArray depsArray = m_metadata.value("dependencies").toArray();
-    
-    for (const QJsonValue& dep : depsArray) {
-        dependencies.append(dep.toString());
+    return m_data->dependencies;
+}
+
+QVector<PluginHandle> PluginMetadata::getDependencyHandles() const
+{
+    if (m_data->interned) {
+        return m_data->dependencyHandles;
     }
-    
-    return dependencies;
+
+    QVector<PluginHandle> handles;
+    handles.reserve(m_data->dependencies.size());
+    for (const QString& dependency : m_data->dependencies) {
+        handles.append(PluginHandle::find(dependency));
+    }
+    return handles;
+}
+
+PluginVersionRange PluginMetadata::getDependencyRange(const QString& pluginId) const
+{
+    int index = dependencyIndex(pluginId);
+    return index >= 0 ? m_data->dependencyRanges[index] : PluginVersionRange();
 }
 
 QString PluginMetadata::getMinFrameworkVersion() const
 {
-    return m_metadata.value("minFrameworkVersion").toString("1.0.0");
+    return m_data->minFrameworkVersion;
 }
 
 QVersionNumber PluginMetadata::getMinFrameworkVersionNumber() const
 {
-    return QVersionNumber::fromString(getMinFrameworkVersion());
+    return m_data->minFrameworkVersionNumber;
 }
 
 QString PluginMetadata::getCategory() const
 {
-    return m_metadata.value("category").toString();
+    return m_data->category;
 }
 
 QString PluginMetadata::getIconPath() const
 {
-    return m_metadata.value("iconPath").toString();
+    return m_data->iconPath;
 }
 
 QStringList PluginMetadata::getRequiredPermissions() const
 {
-    QStringList permissions;
-    QJsonArray permsArray = m_metadata.value("requiredPermissions").toArray();
-    
-    for (const QJsonValue& perm : permsArray) {
-        permissions.append(perm.toString());
-    }
-    
-    return permissions;
+    return m_data->requiredPermissions;
+}
+
+bool PluginMetadata::isThreaded() const
+{
+    return m_data->threaded;
 }
 
 QJsonObject PluginMetadata::getMetadataJson() const
 {
-    return m_metadata;
+    return m_data->json;
 }
 
 bool PluginMetadata::isCompatibleWithFramework(const QString& frameworkVersion) const
 {
-    if (!m_isValid) {
+    return isCompatibleWithFramework(QVersionNumber::fromString(frameworkVersion));
+}
+
+bool PluginMetadata::isCompatibleWithFramework(const QVersionNumber& frameworkVersion) const
+{
+    if (!m_data->valid) {
         return false;
     }
-    
-    QVersionNumber pluginMinVersion = getMinFrameworkVersionNumber();
-    QVersionNumber currentFrameworkVersion = QVersionNumber::fromString(frameworkVersion);
-    
-    return currentFrameworkVersion >= pluginMinVersion;
+
+    return frameworkVersion >= m_data->minFrameworkVersionNumber;
 }
 
 bool PluginMetadata::dependsOn(const QString& pluginId) const
 {
-    return getPluginDependencies().contains(pluginId);
+    return dependencyIndex(pluginId) >= 0;
+}
+
+int PluginMetadata::dependencyIndex(const QString& pluginId) const
+{
+    // Metadata that was never registered may depend on IDs that are not interned yet
+    if (!m_data->interned) {
+        return m_data->dependencies.indexOf(pluginId);
+    }
+
+    // An ID that was never interned cannot appear among the dependencies
+    PluginHandle handle = PluginHandle::find(pluginId);
+    return handle.isValid() ? m_data->dependencyHandles.indexOf(handle) : -1;
 }
\ No newline at end of file
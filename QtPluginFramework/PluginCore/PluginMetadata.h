@@ -10,11 +10,22 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QVersionNumber>
+#include <QVector>
+#include <QSharedData>
+#include <QSharedDataPointer>
+
+#include "DocumentCodec.h"
+#include "PluginHandle.h"
+#include "PluginVersionRange.h"
 
 /**
  * @brief The PluginMetadata class manages metadata for a plugin.
  * 
  * This class handles loading, parsing, and accessing plugin metadata from JSON files.
+ * The JSON is parsed once into typed fields, with the plugin ID and dependencies resolved
+ * to PluginHandles and the versions pre-parsed, so the getters do no JSON lookups. Parsing
+ * does not intern IDs; internHandles() does, when the metadata is registered. The fields
+ * are implicitly shared, which makes copies as cheap as copying a pointer.
  */
 class PluginMetadata
 {
@@ -32,9 +43,9 @@ public:
     explicit PluginMetadata(const QJsonObject& metadataJson);
 
     /**
-     * @brief Load metadata from a JSON file
+     * @brief Load metadata from a JSON or CBOR file
      * 
-     * @param filePath Path to the metadata JSON file
+     * @param filePath Path to the metadata file
      * @return True if loading was successful, false otherwise
      */
     bool loadFromFile(const QString& filePath);
@@ -47,6 +58,25 @@ public:
      */
     bool loadFromString(const QString& jsonString);
 
+    /**
+     * @brief Load metadata from raw JSON or CBOR data
+     * 
+     * The format is detected from the first bytes of the data.
+     * 
+     * @param jsonData UTF-8 encoded JSON data or CBOR data containing plugin metadata
+     * @return True if loading was successful, false otherwise
+     */
+    bool loadFromData(const QByteArray& jsonData);
+
+    /**
+     * @brief Save the metadata to a file
+     * 
+     * @param filePath Path to the metadata file
+     * @param format Format to write the file in
+     * @return True if saving was successful, false otherwise
+     */
+    bool saveToFile(const QString& filePath, DocumentCodec::Format format) const;
+
     /**
      * @brief Check if the metadata is valid
      * 
@@ -54,6 +84,14 @@ public:
      */
     bool isValid() const;
 
+    /**
+     * @brief Intern the plugin ID and the dependency IDs
+     * 
+     * Called when the metadata is registered, so that the handles of registered metadata
+     * are all valid without parsing alone interning every ID it comes across.
+     */
+    void internHandles();
+
     /**
      * @brief Get the plugin ID
      * 
@@ -82,6 +120,13 @@ public:
      */
     QVersionNumber getVersionNumber() const;
 
+    /**
+     * @brief Get the handle of the plugin ID
+     * 
+     * @return The interned plugin ID, or an invalid handle if the ID is empty or not interned yet
+     */
+    PluginHandle getPluginHandle() const;
+
     /**
      * @brief Get the plugin vendor
      * 
@@ -103,6 +148,24 @@ public:
      */
     QStringList getPluginDependencies() const;
 
+    /**
+     * @brief Get the handles of the plugin dependencies
+     * 
+     * @return The interned IDs of the plugins that this plugin depends on, invalid for IDs not interned yet
+     */
+    QVector<PluginHandle> getDependencyHandles() const;
+
+    /**
+     * @brief Get the versions of a dependency this plugin accepts
+     * 
+     * Dependencies are listed either as an array of IDs, optionally followed by a range
+     * ("Compression >=1.2 <2"), or as an object mapping IDs to ranges.
+     * 
+     * @param pluginId The ID of the dependency
+     * @return The accepted version range, matching every version if none was given
+     */
+    PluginVersionRange getDependencyRange(const QString& pluginId) const;
+
     /**
      * @brief Get the minimum framework version required by this plugin
      * 
@@ -138,6 +201,13 @@ public:
      */
     QStringList getRequiredPermissions() const;
 
+    /**
+     * @brief Check if the plugin asks to run on its own thread
+     * 
+     * @return True if the plugin should be moved to a dedicated thread, false otherwise
+     */
+    bool isThreaded() const;
+
     /**
      * @brief Get the complete metadata as a JSON object
      * 
@@ -153,6 +223,14 @@ public:
      */
     bool isCompatibleWithFramework(const QString& frameworkVersion) const;
 
+    /**
+     * @brief Check if this plugin is compatible with the given framework version
+     * 
+     * @param frameworkVersion The parsed framework version to check against
+     * @return True if compatible, false otherwise
+     */
+    bool isCompatibleWithFramework(const QVersionNumber& frameworkVersion) const;
+
     /**
      * @brief Check if this plugin depends on another plugin
      * 
@@ -162,8 +240,60 @@ public:
     bool dependsOn(const QString& pluginId) const;
 
 private:
-    QJsonObject m_metadata;
-    bool m_isValid;
+    struct Data : QSharedData {
+        QJsonObject json;                           // Kept for getMetadataJson()
+        PluginHandle handle;
+        QString id;
+        QString name;
+        QString version;
+        QString vendor;
+        QString description;
+        QString minFrameworkVersion;
+        QString category;
+        QString iconPath;
+        QVersionNumber versionNumber;
+        QVersionNumber minFrameworkVersionNumber;
+        QStringList dependencies;
+        QVector<PluginHandle> dependencyHandles;    // Invalid for IDs not interned when parsing
+        QVector<PluginVersionRange> dependencyRanges;   // Parallel to dependencies
+        QStringList requiredPermissions;
+        bool threaded = false;
+        bool valid = false;
+        bool interned = false;                      // The handle and all dependency handles are valid
+    };
+
+    /**
+     * @brief Parse a JSON object into the typed fields
+     * 
+     * @param metadataJson The JSON object containing plugin metadata
+     */
+    void parse(const QJsonObject& metadataJson);
+
+    /**
+     * @brief Parse the dependency list, which is an array of IDs or an object of ranges
+     * 
+     * @return False if a version range is malformed, true otherwise
+     */
+    static bool parseDependencies(const QJsonValue& value, Data* data);
+
+    /**
+     * @brief Find a dependency by ID
+     * 
+     * @return Index into the dependency lists, or -1 if this plugin does not depend on it
+     */
+    int dependencyIndex(const QString& pluginId) const;
+
+    /**
+     * @brief Get the shared fields of empty metadata
+     */
+    static QSharedDataPointer<Data> emptyData();
+
+    /**
+     * @brief Convert a JSON array of strings into a string list
+     */
+    static QStringList toStringList(const QJsonValue& value);
+
+    QSharedDataPointer<Data> m_data;
 };
 
 #endif // PLUGINMETADATA_H
\ No newline at end of file
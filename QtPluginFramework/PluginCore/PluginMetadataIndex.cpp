@@ -0,0 +1,131 @@
+#include "PluginMetadataIndex.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QCborValue>
+#include <QCborMap>
+#include <QCborArray>
+
+PluginMetadataIndex::PluginMetadataIndex() : m_dirty(false)
+{
+}
+
+bool PluginMetadataIndex::load(const QString& indexPath)
+{
+    m_entries.clear();
+    m_dirty = false;
+
+    QFile file(indexPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QByteArray indexData = file.readAll();
+    file.close();
+
+    QCborParserError parseError;
+    QCborValue root = QCborValue::fromCbor(indexData, &parseError);
+    if (parseError.error != QCborError::NoError || !root.isMap()) {
+        return false;
+    }
+
+    QCborMap rootMap = root.toMap();
+    if (rootMap.value(QStringLiteral("version")).toInteger() != IndexVersion) {
+        return false;
+    }
+
+    const QCborArray entries = rootMap.value(QStringLiteral("entries")).toArray();
+    for (const QCborValue& value : entries) {
+        QCborArray entry = value.toArray();
+        if (entry.size() != 4 || !entry.at(3).isMap()) {
+            continue;
+        }
+
+        m_entries.insert(entry.at(0).toString(),
+                         Entry{entry.at(1).toInteger(), entry.at(2).toInteger(), entry.at(3).toMap().toJsonObject()});
+    }
+
+    return true;
+}
+
+bool PluginMetadataIndex::save(const QString& indexPath)
+{
+    QCborArray entries;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        QCborArray entry;
+        entry.append(it.key());
+        entry.append(it.value().modifiedMs);
+        entry.append(it.value().size);
+        entry.append(QCborMap::fromJsonObject(it.value().metadata));
+        entries.append(entry);
+    }
+
+    QCborMap rootMap;
+    rootMap.insert(QStringLiteral("version"), IndexVersion);
+    rootMap.insert(QStringLiteral("entries"), entries);
+
+    // Write through a temporary file so a crash never leaves a truncated index behind
+    QSaveFile file(indexPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    file.write(QCborValue(rootMap).toCbor());
+    if (!file.commit()) {
+        return false;
+    }
+
+    m_dirty = false;
+
+    return true;
+}
+
+bool PluginMetadataIndex::lookup(const QFileInfo& fileInfo, PluginMetadata& metadata) const
+{
+    auto it = m_entries.constFind(fileInfo.absoluteFilePath());
+    if (it == m_entries.constEnd()) {
+        return false;
+    }
+
+    if (it.value().modifiedMs != fileInfo.lastModified().toMSecsSinceEpoch() ||
+        it.value().size != fileInfo.size()) {
+        return false;
+    }
+
+    metadata = PluginMetadata(it.value().metadata);
+
+    return true;
+}
+
+void PluginMetadataIndex::insert(const QFileInfo& fileInfo, const PluginMetadata& metadata)
+{
+    m_entries.insert(fileInfo.absoluteFilePath(),
+                     Entry{fileInfo.lastModified().toMSecsSinceEpoch(), fileInfo.size(), metadata.getMetadataJson()});
+    m_dirty = true;
+}
+
+void PluginMetadataIndex::retain(const QSet<QString>& filePaths)
+{
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (!filePaths.contains(it.key())) {
+            it = m_entries.erase(it);
+            m_dirty = true;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void PluginMetadataIndex::clear()
+{
+    if (!m_entries.isEmpty()) {
+        m_entries.clear();
+        m_dirty = true;
+    }
+}
+
+bool PluginMetadataIndex::isDirty() const
+{
+    return m_dirty;
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#ifndef PLUGINMETADATAINDEX_H
+#define PLUGINMETADATAINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QFileInfo>
+#include <QJsonObject>
+
+#include "PluginMetadata.h"
+
+/**
+ * @brief The PluginMetadataIndex class caches parsed plugin metadata on disk.
+ *
+ * Entries are keyed by the absolute path of the metadata file and remember the
+ * file's modification time and size. A lookup only succeeds while both still match,
+ * so only new or changed metadata files need to be parsed again. The index is
+ * stored as a single CBOR document.
+ */
+class PluginMetadataIndex
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    PluginMetadataIndex();
+
+    /**
+     * @brief Load the index from a file
+     *
+     * @param indexPath Path to the index file
+     * @return True if the index was loaded, false if it is missing or unreadable
+     */
+    bool load(const QString& indexPath);
+
+    /**
+     * @brief Save the index to a file
+     *
+     * @param indexPath Path to the index file
+     * @return True if saving was successful, false otherwise
+     */
+    bool save(const QString& indexPath);
+
+    /**
+     * @brief Look up the cached metadata of a metadata file
+     *
+     * @param fileInfo Metadata file
+     * @param metadata Receives the cached metadata
+     * @return True if an up-to-date entry exists, false otherwise
+     */
+    bool lookup(const QFileInfo& fileInfo, PluginMetadata& metadata) const;
+
+    /**
+     * @brief Add or replace the entry of a metadata file
+     *
+     * @param fileInfo Metadata file
+     * @param metadata Parsed metadata of the file
+     */
+    void insert(const QFileInfo& fileInfo, const PluginMetadata& metadata);
+
+    /**
+     * @brief Remove the entries of all files that are not in the given set
+     *
+     * @param filePaths Absolute paths of the metadata files to keep
+     */
+    void retain(const QSet<QString>& filePaths);
+
+    /**
+     * @brief Remove all entries
+     */
+    void clear();
+
+    /**
+     * @brief Check if the index changed since it was loaded or saved
+     *
+     * @return True if the index has unsaved changes, false otherwise
+     */
+    bool isDirty() const;
+
+private:
+    struct Entry {
+        qint64 modifiedMs;
+        qint64 size;
+        QJsonObject metadata;
+    };
+
+    QHash<QString, Entry> m_entries;
+    bool m_dirty;
+
+    // Bumped whenever the on-disk layout changes
+    static const int IndexVersion = 1;
+};
+
+#endif // PLUGINMETADATAINDEX_H
\ No newline at end of file
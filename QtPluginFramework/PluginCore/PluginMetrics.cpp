@@ -0,0 +1,182 @@
+#include "PluginMetrics.h"
+
+#include <QMap>
+#include <QMutexLocker>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+void CallStatistics::record(qint64 wallNs, qint64 cpuNs, bool failed)
+{
+    ++count;
+    if (failed) {
+        ++failures;
+    }
+    totalNs += wallNs;
+    maxNs = qMax(maxNs, wallNs);
+    this->cpuNs += cpuNs;
+
+    // Bucket by the position of the highest bit of the duration in microseconds
+    quint64 micros = quint64(qMax<qint64>(wallNs, 0)) / 1000;
+    int bucket = 0;
+    while (micros > 1 && bucket < BucketCount - 1) {
+        micros >>= 1;
+        ++bucket;
+    }
+    ++buckets[bucket];
+}
+
+qint64 CallStatistics::meanNs() const
+{
+    return count > 0 ? totalNs / qint64(count) : 0;
+}
+
+qint64 CallStatistics::percentileNs(double percentile) const
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    quint64 rank = quint64(count * qBound(0.0, percentile, 100.0) / 100.0 + 0.5);
+    rank = qBound<quint64>(1, rank, count);
+
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            // The last bucket is open-ended, so report the longest call instead
+            return i == BucketCount - 1 ? maxNs : qMin(maxNs, (qint64(2) << i) * 1000);
+        }
+    }
+
+    return maxNs;
+}
+
+PluginMetrics::PluginMetrics() : m_enabled(1)
+{
+}
+
+PluginMetrics& PluginMetrics::instance()
+{
+    static PluginMetrics instance;
+    return instance;
+}
+
+void PluginMetrics::setEnabled(bool enable)
+{
+    m_enabled.storeRelaxed(enable ? 1 : 0);
+}
+
+bool PluginMetrics::isEnabled() const
+{
+    return m_enabled.loadRelaxed() != 0;
+}
+
+qint64 PluginMetrics::threadCpuTimeNs()
+{
+#ifdef Q_OS_WIN
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0;
+    }
+
+    // FILETIME counts 100 ns intervals
+    quint64 kernel = (quint64(kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+    quint64 user = (quint64(userTime.dwHighDateTime) << 32) | userTime.dwLowDateTime;
+    return qint64(kernel + user) * 100;
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+void PluginMetrics::recordCommand(const QString& pluginId, qint64 wallNs, qint64 cpuNs, bool failed)
+{
+    QMutexLocker locker(&m_mutex);
+
+    PluginMetricsSnapshot& metrics = m_metrics[pluginId];
+    metrics.pluginId = pluginId;
+    metrics.commands.record(wallNs, cpuNs, failed);
+}
+
+void PluginMetrics::recordMessage(const QString& pluginId, qint64 wallNs, qint64 cpuNs, bool failed)
+{
+    QMutexLocker locker(&m_mutex);
+
+    PluginMetricsSnapshot& metrics = m_metrics[pluginId];
+    metrics.pluginId = pluginId;
+    metrics.messages.record(wallNs, cpuNs, failed);
+}
+
+void PluginMetrics::recordMailboxWait(const QString& pluginId, qint64 waitNs)
+{
+    QMutexLocker locker(&m_mutex);
+
+    PluginMetricsSnapshot& metrics = m_metrics[pluginId];
+    metrics.pluginId = pluginId;
+    metrics.mailboxWait.record(waitNs, 0, false);
+}
+
+void PluginMetrics::recordLifecycle(const QString& pluginId, LifecyclePhase phase, qint64 wallNs, qint64 cpuNs)
+{
+    QMutexLocker locker(&m_mutex);
+
+    PluginMetricsSnapshot& metrics = m_metrics[pluginId];
+    metrics.pluginId = pluginId;
+    metrics.lifecycleNs[static_cast<int>(phase)] = wallNs;
+    metrics.lifecycleCpuNs[static_cast<int>(phase)] = cpuNs;
+}
+
+PluginMetricsSnapshot PluginMetrics::metrics(const QString& pluginId) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    PluginMetricsSnapshot metrics = m_metrics.value(pluginId);
+    metrics.pluginId = pluginId;
+
+    return metrics;
+}
+
+QList<PluginMetricsSnapshot> PluginMetrics::allMetrics() const
+{
+    QMap<QString, PluginMetricsSnapshot> sorted;
+    {
+        QMutexLocker locker(&m_mutex);
+
+        for (auto it = m_metrics.constBegin(); it != m_metrics.constEnd(); ++it) {
+            sorted.insert(it.key(), it.value());
+        }
+    }
+
+    return sorted.values();
+}
+
+void PluginMetrics::clear()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_metrics.clear();
+}
+
+QString PluginMetrics::getLifecyclePhaseName(LifecyclePhase phase)
+{
+    switch (phase) {
+        case LifecyclePhase::Initialize:
+            return "Initialize";
+        case LifecyclePhase::Activate:
+            return "Activate";
+        case LifecyclePhase::Deactivate:
+            return "Deactivate";
+        case LifecyclePhase::Shutdown:
+            return "Shutdown";
+    }
+
+    return "Unknown";
+}
\ No newline at end of file
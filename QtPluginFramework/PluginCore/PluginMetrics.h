@@ -0,0 +1,252 @@
+#ifndef PLUGINMETRICS_H
+#define PLUGINMETRICS_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+
+/**
+ * @brief Count, latency histogram and CPU time of one kind of call into a plugin
+ *
+ * Latencies are counted in power-of-two buckets: bucket 0 holds calls shorter than
+ * 2 microseconds and bucket i holds calls from 2^i up to 2^(i+1) microseconds. The last
+ * bucket also holds everything longer.
+ */
+struct CallStatistics {
+    static const int BucketCount = 24;
+
+    quint64 count = 0;                  ///< Number of calls
+    quint64 failures = 0;               ///< Calls that threw an exception
+    qint64 totalNs = 0;                 ///< Sum of wall-clock durations
+    qint64 maxNs = 0;                   ///< Longest wall-clock duration
+    qint64 cpuNs = 0;                   ///< Sum of thread CPU time spent in the calls
+    quint64 buckets[BucketCount] = {};  ///< Latency histogram
+
+    /**
+     * @brief Add one call
+     *
+     * @param wallNs Wall-clock duration in nanoseconds
+     * @param cpuNs Thread CPU time in nanoseconds
+     * @param failed True if the call threw an exception
+     */
+    void record(qint64 wallNs, qint64 cpuNs, bool failed);
+
+    /**
+     * @brief Get the mean wall-clock duration
+     *
+     * @return Mean duration in nanoseconds, or 0 without calls
+     */
+    qint64 meanNs() const;
+
+    /**
+     * @brief Estimate a latency percentile from the histogram
+     *
+     * @param percentile Percentile between 0 and 100
+     * @return Upper bound of the bucket holding the percentile, in nanoseconds
+     */
+    qint64 percentileNs(double percentile) const;
+};
+
+/**
+ * @brief Lifecycle methods whose duration is recorded
+ */
+enum class LifecyclePhase {
+    Initialize,
+    Activate,
+    Deactivate,
+    Shutdown
+};
+
+/**
+ * @brief Everything recorded for one plugin
+ */
+struct PluginMetricsSnapshot {
+    static const int LifecyclePhaseCount = 4;
+
+    QString pluginId;
+    CallStatistics commands;                        ///< IPlugin::executeCommand() and ICommandProvider::invokeCommand()
+    CallStatistics messages;                        ///< Message handlers registered with PluginCommunication
+    CallStatistics mailboxWait;                     ///< Time posted messages waited in the plugin's mailbox
+    qint64 lifecycleNs[LifecyclePhaseCount] = {};   ///< Last wall-clock duration per LifecyclePhase, -1 if never run
+    qint64 lifecycleCpuNs[LifecyclePhaseCount] = {};///< Last thread CPU time per LifecyclePhase
+
+    PluginMetricsSnapshot()
+    {
+        for (int i = 0; i < LifecyclePhaseCount; ++i) {
+            lifecycleNs[i] = -1;
+        }
+    }
+};
+
+/**
+ * @brief The PluginMetrics class accounts for the time plugins spend in commands, message handlers and lifecycle calls.
+ *
+ * Each call is timed with a monotonic clock and with the CPU clock of the thread it runs
+ * on, so time spent waiting for locks, I/O or dialogs shows up as latency but not as CPU.
+ * Recording takes two reads of each clock and a short critical section, so metrics are
+ * enabled by default.
+ *
+ * This class implements the Singleton pattern.
+ */
+class PluginMetrics
+{
+public:
+    /**
+     * @brief Get the singleton instance of PluginMetrics
+     *
+     * @return Reference to the singleton PluginMetrics instance
+     */
+    static PluginMetrics& instance();
+
+    /**
+     * @brief Enable or disable recording
+     *
+     * @param enable True to record calls, false to ignore them
+     */
+    void setEnabled(bool enable);
+
+    /**
+     * @brief Check if calls are recorded
+     *
+     * @return True if recording is enabled, false otherwise
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief Get the CPU time consumed by the calling thread
+     *
+     * @return CPU time in nanoseconds, or 0 if the platform does not provide it
+     */
+    static qint64 threadCpuTimeNs();
+
+    /**
+     * @brief Record a command call
+     *
+     * @param pluginId ID of the plugin
+     * @param wallNs Wall-clock duration in nanoseconds
+     * @param cpuNs Thread CPU time in nanoseconds
+     * @param failed True if the command threw an exception
+     */
+    void recordCommand(const QString& pluginId, qint64 wallNs, qint64 cpuNs, bool failed);
+
+    /**
+     * @brief Record a message handler call
+     *
+     * @param pluginId ID of the plugin owning the handler
+     * @param wallNs Wall-clock duration in nanoseconds
+     * @param cpuNs Thread CPU time in nanoseconds
+     * @param failed True if the handler threw an exception
+     */
+    void recordMessage(const QString& pluginId, qint64 wallNs, qint64 cpuNs, bool failed);
+
+    /**
+     * @brief Record how long a posted message waited before its handler was called
+     *
+     * @param pluginId ID of the receiving plugin
+     * @param waitNs Time from queueing to delivery in nanoseconds
+     */
+    void recordMailboxWait(const QString& pluginId, qint64 waitNs);
+
+    /**
+     * @brief Record a lifecycle call
+     *
+     * @param pluginId ID of the plugin
+     * @param phase Lifecycle method that ran
+     * @param wallNs Wall-clock duration in nanoseconds
+     * @param cpuNs Thread CPU time in nanoseconds
+     */
+    void recordLifecycle(const QString& pluginId, LifecyclePhase phase, qint64 wallNs, qint64 cpuNs);
+
+    /**
+     * @brief Get the metrics of a plugin
+     *
+     * @param pluginId ID of the plugin
+     * @return Copy of the plugin's metrics, empty if nothing was recorded
+     */
+    PluginMetricsSnapshot metrics(const QString& pluginId) const;
+
+    /**
+     * @brief Get the metrics of all plugins
+     *
+     * @return Copies of the metrics of every plugin with recorded calls, sorted by plugin ID
+     */
+    QList<PluginMetricsSnapshot> allMetrics() const;
+
+    /**
+     * @brief Discard the metrics of all plugins
+     */
+    void clear();
+
+    /**
+     * @brief Get the display name of a lifecycle phase
+     *
+     * @param phase Lifecycle phase
+     * @return Name of the phase
+     */
+    static QString getLifecyclePhaseName(LifecyclePhase phase);
+
+private:
+    // Private constructor for singleton pattern
+    PluginMetrics();
+
+    // Deleted copy constructor and assignment operator
+    PluginMetrics(const PluginMetrics&) = delete;
+    PluginMetrics& operator=(const PluginMetrics&) = delete;
+
+    QAtomicInt m_enabled;
+    mutable QMutex m_mutex;
+    QHash<QString, PluginMetricsSnapshot> m_metrics;
+};
+
+/**
+ * @brief The CallTimer class measures wall-clock and thread CPU time from its construction.
+ *
+ * Both readings must be taken on the thread that constructed the timer.
+ */
+class CallTimer
+{
+public:
+    /**
+     * @brief Start timing, unless metrics are disabled
+     */
+    CallTimer()
+        : m_active(PluginMetrics::instance().isEnabled()),
+          m_cpuStartNs(m_active ? PluginMetrics::threadCpuTimeNs() : 0)
+    {
+        if (m_active) {
+            m_clock.start();
+        }
+    }
+
+    /**
+     * @brief Check if the timer is running
+     *
+     * @return False if metrics were disabled when the timer was created
+     */
+    bool isActive() const { return m_active; }
+
+    /**
+     * @brief Get the wall-clock time since construction
+     *
+     * @return Nanoseconds
+     */
+    qint64 wallNs() const { return m_active ? m_clock.nsecsElapsed() : 0; }
+
+    /**
+     * @brief Get the CPU time of this thread since construction
+     *
+     * @return Nanoseconds
+     */
+    qint64 cpuNs() const { return m_active ? PluginMetrics::threadCpuTimeNs() - m_cpuStartNs : 0; }
+
+private:
+    bool m_active;
+    qint64 m_cpuStartNs;
+    QElapsedTimer m_clock;
+};
+
+#endif // PLUGINMETRICS_H
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include "PluginProfiler.h"
+
+#include <QThread>
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QMap>
+#include <QMutexLocker>
+#include <algorithm>
+
+PluginProfiler::PluginProfiler() : m_enabled(1), m_capacity(16384), m_droppedSpans(0)
+{
+    m_clock.start();
+    m_spans.reserve(m_capacity);
+}
+
+PluginProfiler& PluginProfiler::instance()
+{
+    static PluginProfiler instance;
+    return instance;
+}
+
+void PluginProfiler::setEnabled(bool enable)
+{
+    m_enabled.storeRelaxed(enable ? 1 : 0);
+}
+
+bool PluginProfiler::isEnabled() const
+{
+    return m_enabled.loadRelaxed() != 0;
+}
+
+void PluginProfiler::setCapacity(int capacity)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_capacity = qMax(0, capacity);
+    if (m_spans.size() > m_capacity) {
+        m_droppedSpans += m_spans.size() - m_capacity;
+        m_spans.resize(m_capacity);
+    }
+    m_spans.reserve(m_capacity);
+}
+
+qint64 PluginProfiler::now() const
+{
+    return m_clock.nsecsElapsed();
+}
+
+void PluginProfiler::record(const char* name, const QString& pluginId, qint64 startNs, qint64 durationNs)
+{
+    quintptr threadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
+
+    QMutexLocker locker(&m_mutex);
+
+    if (m_spans.size() >= m_capacity) {
+        ++m_droppedSpans;
+        return;
+    }
+
+    // Thread names only matter for the export, so look each thread up once
+    if (!m_threadNames.contains(threadId)) {
+        QThread* thread = QThread::currentThread();
+        QString threadName = thread->objectName();
+        if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) {
+            threadName = "Main";
+        } else if (threadName.isEmpty()) {
+            threadName = QString("Thread %1").arg(m_threadNames.size());
+        }
+        m_threadNames.insert(threadId, threadName);
+    }
+
+    ProfileSpan span;
+    span.name = name;
+    span.pluginId = pluginId;
+    span.threadId = threadId;
+    span.startNs = startNs;
+    span.durationNs = durationNs;
+    m_spans.append(span);
+}
+
+QVector<ProfileSpan> PluginProfiler::spans() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_spans;
+}
+
+int PluginProfiler::droppedSpans() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_droppedSpans;
+}
+
+void PluginProfiler::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_spans.clear();
+    m_spans.reserve(m_capacity);
+    m_droppedSpans = 0;
+}
+
+QByteArray PluginProfiler::toChromeTrace() const
+{
+    QVector<ProfileSpan> spans;
+    QHash<quintptr, QString> threadNames;
+    {
+        QMutexLocker locker(&m_mutex);
+        spans = m_spans;
+        threadNames = m_threadNames;
+    }
+
+    // Chrome expects small integer thread IDs, so number threads in order of appearance
+    QHash<quintptr, int> threadIndices;
+    QJsonArray events;
+
+    for (const ProfileSpan& span : spans) {
+        auto it = threadIndices.constFind(span.threadId);
+        if (it == threadIndices.constEnd()) {
+            it = threadIndices.insert(span.threadId, threadIndices.size() + 1);
+
+            QJsonObject threadEvent;
+            threadEvent["name"] = "thread_name";
+            threadEvent["ph"] = "M";
+            threadEvent["pid"] = 1;
+            threadEvent["tid"] = it.value();
+            threadEvent["args"] = QJsonObject{{"name", threadNames.value(span.threadId)}};
+            events.append(threadEvent);
+        }
+
+        QJsonObject event;
+        event["name"] = span.pluginId.isEmpty() ? QString::fromLatin1(span.name)
+                                                : QString("%1 %2").arg(QString::fromLatin1(span.name), span.pluginId);
+        event["cat"] = span.pluginId.isEmpty() ? "framework" : "plugin";
+        event["ph"] = "X";
+        event["pid"] = 1;
+        event["tid"] = it.value();
+        event["ts"] = span.startNs / 1000.0;
+        event["dur"] = span.durationNs / 1000.0;
+        if (!span.pluginId.isEmpty()) {
+            event["args"] = QJsonObject{{"pluginId", span.pluginId}};
+        }
+        events.append(event);
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool PluginProfiler::writeChromeTrace(const QString& filePath) const
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    file.write(toChromeTrace());
+
+    return file.commit();
+}
+
+QString PluginProfiler::summary() const
+{
+    const QVector<ProfileSpan> spans = this->spans();
+
+    struct Total {
+        QString label;
+        int count = 0;
+        qint64 totalNs = 0;
+        qint64 maxNs = 0;
+    };
+
+    QMap<QString, Total> totals;
+    for (const ProfileSpan& span : spans) {
+        QString label = span.pluginId.isEmpty() ? QString::fromLatin1(span.name)
+                                                : QString("%1 [%2]").arg(QString::fromLatin1(span.name), span.pluginId);
+        Total& total = totals[label];
+        total.label = label;
+        ++total.count;
+        total.totalNs += span.durationNs;
+        total.maxNs = qMax(total.maxNs, span.durationNs);
+    }
+
+    QList<Total> sorted = totals.values();
+    std::sort(sorted.begin(), sorted.end(), [](const Total& a, const Total& b) {
+        return a.totalNs > b.totalNs;
+    });
+
+    QString text = QString("%1 %2 %3 %4\n")
+                       .arg("Total ms", 10)
+                       .arg("Max ms", 10)
+                       .arg("Count", 6)
+                       .arg("Phase");
+    for (const Total& total : sorted) {
+        text += QString("%1 %2 %3 %4\n")
+                    .arg(total.totalNs / 1e6, 10, 'f', 3)
+                    .arg(total.maxNs / 1e6, 10, 'f', 3)
+                    .arg(total.count, 6)
+                    .arg(total.label);
+    }
+
+    int dropped = droppedSpans();
+    if (dropped > 0) {
+        text += QString("%1 spans dropped because the buffer was full\n").arg(dropped);
+    }
+
+    return text;
+}
\ No newline at end of file
@@ -0,0 +1,188 @@
+#ifndef PLUGINPROFILER_H
+#define PLUGINPROFILER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+
+/**
+ * @brief One timed span recorded by the profiler
+ */
+struct ProfileSpan {
+    const char* name = nullptr;     ///< Static name of the phase, e.g. "IPlugin::initialize"
+    QString pluginId;               ///< Plugin the span belongs to, empty for framework phases
+    quintptr threadId = 0;          ///< Native ID of the thread the span ran on
+    qint64 startNs = 0;             ///< Start, in nanoseconds since the profiler was created
+    qint64 durationNs = 0;          ///< Duration in nanoseconds
+};
+
+/**
+ * @brief The PluginProfiler class records where startup and lifecycle time is spent.
+ *
+ * Spans are recorded with a monotonic nanosecond clock together with the thread they
+ * ran on and the plugin they belong to. Recording a span costs two clock reads and an
+ * append to a preallocated buffer, so the profiler is enabled by default. Once the
+ * buffer is full further spans are counted but dropped.
+ *
+ * The recorded spans can be exported as Chrome trace_event JSON, which chrome://tracing
+ * and Perfetto open directly, or as a plain-text summary sorted by total cost.
+ *
+ * This class implements the Singleton pattern.
+ */
+class PluginProfiler
+{
+public:
+    /**
+     * @brief Get the singleton instance of PluginProfiler
+     *
+     * @return Reference to the singleton PluginProfiler instance
+     */
+    static PluginProfiler& instance();
+
+    /**
+     * @brief Enable or disable recording
+     *
+     * @param enable True to record spans, false to ignore them
+     */
+    void setEnabled(bool enable);
+
+    /**
+     * @brief Check if spans are recorded
+     *
+     * @return True if recording is enabled, false otherwise
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief Set the maximum number of spans kept in memory
+     *
+     * @param capacity Maximum number of spans
+     */
+    void setCapacity(int capacity);
+
+    /**
+     * @brief Get the current time of the profiler clock
+     *
+     * @return Nanoseconds since the profiler was created
+     */
+    qint64 now() const;
+
+    /**
+     * @brief Record a finished span
+     *
+     * @param name Static name of the phase; must outlive the profiler
+     * @param pluginId Plugin the span belongs to, or an empty string
+     * @param startNs Start time from now()
+     * @param durationNs Duration in nanoseconds
+     */
+    void record(const char* name, const QString& pluginId, qint64 startNs, qint64 durationNs);
+
+    /**
+     * @brief Get a copy of the recorded spans
+     *
+     * @return Spans in the order they finished
+     */
+    QVector<ProfileSpan> spans() const;
+
+    /**
+     * @brief Get the number of spans dropped because the buffer was full
+     *
+     * @return Number of dropped spans
+     */
+    int droppedSpans() const;
+
+    /**
+     * @brief Discard all recorded spans
+     */
+    void clear();
+
+    /**
+     * @brief Export the recorded spans as Chrome trace_event JSON
+     *
+     * @return JSON document in the Trace Event Format
+     */
+    QByteArray toChromeTrace() const;
+
+    /**
+     * @brief Write the recorded spans to a Chrome trace file
+     *
+     * @param filePath Path of the file to write
+     * @return True if writing was successful, false otherwise
+     */
+    bool writeChromeTrace(const QString& filePath) const;
+
+    /**
+     * @brief Summarize the recorded spans as plain text
+     *
+     * Spans are grouped by phase and plugin and sorted by total time, most expensive first.
+     *
+     * @return Multi-line summary
+     */
+    QString summary() const;
+
+private:
+    // Private constructor for singleton pattern
+    PluginProfiler();
+
+    // Deleted copy constructor and assignment operator
+    PluginProfiler(const PluginProfiler&) = delete;
+    PluginProfiler& operator=(const PluginProfiler&) = delete;
+
+    QElapsedTimer m_clock;
+    QAtomicInt m_enabled;
+    mutable QMutex m_mutex;
+    QVector<ProfileSpan> m_spans;
+    QHash<quintptr, QString> m_threadNames;
+    int m_capacity;
+    int m_droppedSpans;
+};
+
+/**
+ * @brief The ProfileScope class records a span covering its own lifetime.
+ */
+class ProfileScope
+{
+public:
+    /**
+     * @brief Start a span
+     *
+     * @param name Static name of the phase
+     * @param pluginId Plugin the span belongs to, or an empty string
+     */
+    explicit ProfileScope(const char* name, const QString& pluginId = QString())
+        : m_name(name), m_pluginId(pluginId),
+          m_startNs(PluginProfiler::instance().isEnabled() ? PluginProfiler::instance().now() : -1)
+    {
+    }
+
+    /**
+     * @brief Finish the span and record it
+     */
+    ~ProfileScope()
+    {
+        if (m_startNs >= 0) {
+            PluginProfiler& profiler = PluginProfiler::instance();
+            profiler.record(m_name, m_pluginId, m_startNs, profiler.now() - m_startNs);
+        }
+    }
+
+private:
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    const char* m_name;
+    QString m_pluginId;
+    qint64 m_startNs;
+};
+
+// Convenience macros for profiling the enclosing scope
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#define PROFILE_PLUGIN_SCOPE(name, pluginId) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name, pluginId)
+
+#endif // PLUGINPROFILER_H
\ No newline at end of file
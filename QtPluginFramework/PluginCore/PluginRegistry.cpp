@@ -0,0 +1,217 @@
+#include "PluginRegistry.h"
+
+PluginRegistry::PluginRegistry()
+{
+}
+
+bool PluginRegistry::hasMetadata(PluginHandle handle) const
+{
+    return contains(handle) && m_hasMetadata[handle.value()];
+}
+
+PluginMetadata PluginRegistry::metadata(PluginHandle handle) const
+{
+    return hasMetadata(handle) ? m_metadata[handle.value()] : PluginMetadata();
+}
+
+void PluginRegistry::setMetadata(PluginHandle handle, const PluginMetadata& metadata)
+{
+    if (reserve(handle)) {
+        m_metadata[handle.value()] = metadata;
+        m_hasMetadata[handle.value()] = true;
+    }
+}
+
+PluginState PluginRegistry::state(PluginHandle handle) const
+{
+    return m_states.state(handle);
+}
+
+void PluginRegistry::setState(PluginHandle handle, PluginState state)
+{
+    if (reserve(handle)) {
+        m_states.setState(handle, state);
+    }
+}
+
+bool PluginRegistry::isLoaded(PluginHandle handle) const
+{
+    return m_states.isAttached(handle);
+}
+
+IPlugin* PluginRegistry::instance(PluginHandle handle) const
+{
+    return contains(handle) ? m_instances[handle.value()] : nullptr;
+}
+
+QPluginLoader* PluginRegistry::loader(PluginHandle handle) const
+{
+    return contains(handle) ? m_loaders[handle.value()] : nullptr;
+}
+
+LazyPluginProxy* PluginRegistry::proxy(PluginHandle handle) const
+{
+    return contains(handle) ? m_proxies[handle.value()] : nullptr;
+}
+
+void PluginRegistry::attach(PluginHandle handle, IPlugin* instance, QPluginLoader* loader, LazyPluginProxy* proxy)
+{
+    if (reserve(handle)) {
+        m_instances[handle.value()] = instance;
+        m_loaders[handle.value()] = loader;
+        m_proxies[handle.value()] = proxy;
+        m_states.setAttached(handle, instance != nullptr);
+    }
+}
+
+void PluginRegistry::setLoader(PluginHandle handle, QPluginLoader* loader)
+{
+    if (reserve(handle)) {
+        m_loaders[handle.value()] = loader;
+    }
+}
+
+ICommandProvider* PluginRegistry::commandProvider(PluginHandle handle) const
+{
+    return contains(handle) ? m_commandProviders[handle.value()] : nullptr;
+}
+
+const PluginCommandDescriptor* PluginRegistry::command(PluginHandle handle, int commandId) const
+{
+    if (!contains(handle)) {
+        return nullptr;
+    }
+
+    const QVector<PluginCommandDescriptor>& table = m_commandTables[handle.value()];
+    if (commandId < 0 || commandId >= table.size() || table[commandId].id != commandId) {
+        return nullptr;
+    }
+
+    return &table[commandId];
+}
+
+QList<PluginCommandDescriptor> PluginRegistry::commands(PluginHandle handle) const
+{
+    QList<PluginCommandDescriptor> descriptors;
+
+    if (contains(handle)) {
+        for (const PluginCommandDescriptor& descriptor : m_commandTables[handle.value()]) {
+            if (descriptor.id >= 0) {
+                descriptors.append(descriptor);
+            }
+        }
+    }
+
+    return descriptors;
+}
+
+void PluginRegistry::setCommands(PluginHandle handle, ICommandProvider* provider, const QList<PluginCommandDescriptor>& descriptors)
+{
+    if (!reserve(handle)) {
+        return;
+    }
+
+    QVector<PluginCommandDescriptor> table;
+    if (provider) {
+        for (const PluginCommandDescriptor& descriptor : descriptors) {
+            if (descriptor.id < 0) {
+                continue;
+            }
+            if (descriptor.id >= table.size()) {
+                table.resize(descriptor.id + 1);
+            }
+            table[descriptor.id] = descriptor;
+        }
+    }
+
+    m_commandProviders[handle.value()] = provider;
+    m_commandTables[handle.value()] = table;
+}
+
+void PluginRegistry::detach(PluginHandle handle)
+{
+    if (contains(handle)) {
+        m_instances[handle.value()] = nullptr;
+        m_loaders[handle.value()] = nullptr;
+        m_proxies[handle.value()] = nullptr;
+        m_commandProviders[handle.value()] = nullptr;
+        m_commandTables[handle.value()].clear();
+        m_states.setAttached(handle, false);
+    }
+}
+
+QList<PluginHandle> PluginRegistry::loadedPlugins() const
+{
+    QList<PluginHandle> handles;
+
+    for (int i = 0; i < m_instances.size(); ++i) {
+        if (m_instances[i]) {
+            handles.append(PluginHandle(i));
+        }
+    }
+
+    return handles;
+}
+
+QStringList PluginRegistry::loadedPluginIds() const
+{
+    QStringList pluginIds;
+
+    // The handle names the plugin even when no metadata was stored for it
+    const QList<PluginHandle> handles = loadedPlugins();
+    for (const PluginHandle& handle : handles) {
+        pluginIds.append(handle.pluginId());
+    }
+
+    return pluginIds;
+}
+
+QStringList PluginRegistry::availablePluginIds() const
+{
+    QStringList pluginIds;
+
+    for (int i = 0; i < m_hasMetadata.size(); ++i) {
+        if (m_hasMetadata[i]) {
+            pluginIds.append(m_metadata[i].getPluginId());
+        }
+    }
+
+    return pluginIds;
+}
+
+void PluginRegistry::clear()
+{
+    m_states.clear();
+    m_instances.clear();
+    m_loaders.clear();
+    m_proxies.clear();
+    m_commandProviders.clear();
+    m_commandTables.clear();
+    m_metadata.clear();
+    m_hasMetadata.clear();
+}
+
+bool PluginRegistry::reserve(PluginHandle handle)
+{
+    if (!handle.isValid()) {
+        return false;
+    }
+
+    int size = handle.value() + 1;
+    if (m_instances.size() < size) {
+        m_instances.resize(size);
+        m_loaders.resize(size);
+        m_proxies.resize(size);
+        m_commandProviders.resize(size);
+        m_commandTables.resize(size);
+        m_metadata.resize(size);
+        m_hasMetadata.resize(size);
+    }
+
+    return true;
+}
+
+bool PluginRegistry::contains(PluginHandle handle) const
+{
+    return handle.isValid() && handle.value() < m_instances.size();
+}
\ No newline at end of file
@@ -0,0 +1,223 @@
+#ifndef PLUGINREGISTRY_H
+#define PLUGINREGISTRY_H
+
+#include <QList>
+#include <QStringList>
+#include <QVector>
+#include <QPluginLoader>
+
+#include "ICommandProvider.h"
+#include "IPlugin.h"
+#include "PluginHandle.h"
+#include "PluginMetadata.h"
+#include "PluginStateTable.h"
+
+class LazyPluginProxy;
+
+/**
+ * @brief The PluginRegistry class stores everything PluginManager knows about plugins.
+ *
+ * Each attribute lives in its own array indexed by PluginHandle, so a lookup is a bounds
+ * check and an array access instead of a string-keyed map search. Unknown or invalid
+ * handles yield default values. The registry does no locking of its own.
+ *
+ * States and the loaded flag are kept in a PluginStateTable, so state() and isLoaded()
+ * may be called without holding the lock that serializes writers.
+ */
+class PluginRegistry
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    PluginRegistry();
+
+    /**
+     * @brief Check if metadata has been registered for a plugin
+     *
+     * @param handle Handle of the plugin
+     * @return True if the plugin has metadata, false otherwise
+     */
+    bool hasMetadata(PluginHandle handle) const;
+
+    /**
+     * @brief Get the metadata of a plugin
+     *
+     * @param handle Handle of the plugin
+     * @return Metadata of the plugin, or empty metadata if there is none
+     */
+    PluginMetadata metadata(PluginHandle handle) const;
+
+    /**
+     * @brief Register the metadata of a plugin
+     *
+     * @param handle Handle of the plugin
+     * @param metadata Metadata of the plugin
+     */
+    void setMetadata(PluginHandle handle, const PluginMetadata& metadata);
+
+    /**
+     * @brief Get the state of a plugin
+     *
+     * Safe to call concurrently with writers.
+     *
+     * @param handle Handle of the plugin
+     * @return State of the plugin
+     */
+    PluginState state(PluginHandle handle) const;
+
+    /**
+     * @brief Set the state of a plugin
+     *
+     * @param handle Handle of the plugin
+     * @param state New state
+     */
+    void setState(PluginHandle handle, PluginState state);
+
+    /**
+     * @brief Check if a plugin instance is registered
+     *
+     * Safe to call concurrently with writers.
+     *
+     * @param handle Handle of the plugin
+     * @return True if the plugin is loaded, false otherwise
+     */
+    bool isLoaded(PluginHandle handle) const;
+
+    /**
+     * @brief Get the instance of a plugin
+     *
+     * @param handle Handle of the plugin
+     * @return Plugin instance or lazy proxy, or nullptr if the plugin is not loaded
+     */
+    IPlugin* instance(PluginHandle handle) const;
+
+    /**
+     * @brief Get the loader of a plugin
+     *
+     * @param handle Handle of the plugin
+     * @return Loader of the plugin library, or nullptr if the library is not loaded
+     */
+    QPluginLoader* loader(PluginHandle handle) const;
+
+    /**
+     * @brief Get the lazy proxy of a plugin
+     *
+     * @param handle Handle of the plugin
+     * @return Lazy proxy, or nullptr if the plugin was loaded eagerly
+     */
+    LazyPluginProxy* proxy(PluginHandle handle) const;
+
+    /**
+     * @brief Register a loaded plugin
+     *
+     * @param handle Handle of the plugin
+     * @param instance Plugin instance or lazy proxy
+     * @param loader Loader of the plugin library, or nullptr for an unrealized proxy
+     * @param proxy Lazy proxy, or nullptr for an eagerly loaded plugin
+     */
+    void attach(PluginHandle handle, IPlugin* instance, QPluginLoader* loader, LazyPluginProxy* proxy);
+
+    /**
+     * @brief Set the loader of a plugin
+     *
+     * @param handle Handle of the plugin
+     * @param loader Loader of the plugin library
+     */
+    void setLoader(PluginHandle handle, QPluginLoader* loader);
+
+    /**
+     * @brief Get the command provider of a plugin
+     *
+     * @param handle Handle of the plugin
+     * @return Command provider of the real instance, or nullptr if the plugin publishes no commands
+     */
+    ICommandProvider* commandProvider(PluginHandle handle) const;
+
+    /**
+     * @brief Get the descriptor of a command
+     *
+     * @param handle Handle of the plugin
+     * @param commandId ID of the command
+     * @return Descriptor of the command, or nullptr if the plugin has no such command
+     */
+    const PluginCommandDescriptor* command(PluginHandle handle, int commandId) const;
+
+    /**
+     * @brief Get the commands of a plugin
+     *
+     * @param handle Handle of the plugin
+     * @return Descriptors of the published commands, ordered by command ID
+     */
+    QList<PluginCommandDescriptor> commands(PluginHandle handle) const;
+
+    /**
+     * @brief Store the commands published by a plugin
+     *
+     * The descriptors are placed in a table indexed by command ID. IDs must be unique
+     * and non-negative.
+     *
+     * @param handle Handle of the plugin
+     * @param provider Command provider of the real instance, or nullptr to forget the commands
+     * @param descriptors Descriptors of the commands
+     */
+    void setCommands(PluginHandle handle, ICommandProvider* provider, const QList<PluginCommandDescriptor>& descriptors);
+
+    /**
+     * @brief Forget the instance, loader, proxy and commands of a plugin
+     *
+     * @param handle Handle of the plugin
+     */
+    void detach(PluginHandle handle);
+
+    /**
+     * @brief Get all loaded plugins
+     *
+     * @return Handles of the loaded plugins
+     */
+    QList<PluginHandle> loadedPlugins() const;
+
+    /**
+     * @brief Get the IDs of all loaded plugins
+     *
+     * @return IDs of the loaded plugins
+     */
+    QStringList loadedPluginIds() const;
+
+    /**
+     * @brief Get the IDs of all plugins with metadata
+     *
+     * @return IDs of the available plugins
+     */
+    QStringList availablePluginIds() const;
+
+    /**
+     * @brief Remove all plugins
+     */
+    void clear();
+
+private:
+    /**
+     * @brief Grow the arrays so that a handle can be stored
+     *
+     * @param handle Handle of the plugin
+     * @return True if the handle is valid, false otherwise
+     */
+    bool reserve(PluginHandle handle);
+
+    /**
+     * @brief Check if a handle indexes into the arrays
+     */
+    bool contains(PluginHandle handle) const;
+
+    PluginStateTable m_states;
+    QVector<IPlugin*> m_instances;
+    QVector<QPluginLoader*> m_loaders;
+    QVector<LazyPluginProxy*> m_proxies;
+    QVector<ICommandProvider*> m_commandProviders;
+    QVector<QVector<PluginCommandDescriptor>> m_commandTables;   // Indexed by command ID, unused slots have ID -1
+    QVector<PluginMetadata> m_metadata;
+    QVector<bool> m_hasMetadata;
+};
+
+#endif // PLUGINREGISTRY_H
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "PluginStateTable.h"
+
+PluginStateTable::PluginStateTable()
+{
+}
+
+PluginStateTable::~PluginStateTable()
+{
+    for (int i = 0; i < MaxChunks; ++i) {
+        delete m_chunks[i].loadRelaxed();
+    }
+}
+
+PluginState PluginStateTable::state(PluginHandle handle) const
+{
+    const QAtomicInt* s = slot(handle);
+    return s ? static_cast<PluginState>(s->loadAcquire() & StateMask) : PluginState::NotLoaded;
+}
+
+void PluginStateTable::setState(PluginHandle handle, PluginState state)
+{
+    publish(handle, StateMask, static_cast<int>(state));
+}
+
+bool PluginStateTable::isAttached(PluginHandle handle) const
+{
+    const QAtomicInt* s = slot(handle);
+    return s && (s->loadAcquire() & AttachedFlag) != 0;
+}
+
+void PluginStateTable::setAttached(PluginHandle handle, bool attached)
+{
+    publish(handle, AttachedFlag, attached ? AttachedFlag : 0);
+}
+
+void PluginStateTable::clear()
+{
+    for (int i = 0; i < MaxChunks; ++i) {
+        Chunk* chunk = m_chunks[i].loadAcquire();
+        if (!chunk) {
+            continue;
+        }
+        for (int j = 0; j < ChunkSize; ++j) {
+            chunk->slots[j].storeRelease(0);
+        }
+    }
+}
+
+const QAtomicInt* PluginStateTable::slot(PluginHandle handle) const
+{
+    if (!handle.isValid() || (handle.value() >> ChunkShift) >= MaxChunks) {
+        return nullptr;
+    }
+
+    const Chunk* chunk = m_chunks[handle.value() >> ChunkShift].loadAcquire();
+    return chunk ? &chunk->slots[handle.value() & (ChunkSize - 1)] : nullptr;
+}
+
+QAtomicInt* PluginStateTable::writableSlot(PluginHandle handle)
+{
+    if (!handle.isValid() || (handle.value() >> ChunkShift) >= MaxChunks) {
+        return nullptr;
+    }
+
+    QAtomicPointer<Chunk>& entry = m_chunks[handle.value() >> ChunkShift];
+    Chunk* chunk = entry.loadAcquire();
+    if (!chunk) {
+        // Readers may see the chunk as soon as it is installed, so it starts out zeroed
+        Chunk* fresh = new Chunk();
+        if (entry.testAndSetOrdered(nullptr, fresh)) {
+            chunk = fresh;
+        } else {
+            delete fresh;
+            chunk = entry.loadAcquire();
+        }
+    }
+
+    return &chunk->slots[handle.value() & (ChunkSize - 1)];
+}
+
+void PluginStateTable::publish(PluginHandle handle, int mask, int bits)
+{
+    QAtomicInt* s = writableSlot(handle);
+    if (s) {
+        // Writers are serialized, so only readers can observe the slot in between
+        s->storeRelease((s->loadRelaxed() & ~mask) | bits);
+    }
+}
\ No newline at end of file
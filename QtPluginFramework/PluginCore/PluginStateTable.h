@@ -0,0 +1,118 @@
+#ifndef PLUGINSTATETABLE_H
+#define PLUGINSTATETABLE_H
+
+#include <QAtomicInt>
+#include <QAtomicPointer>
+
+#include "PluginHandle.h"
+
+/**
+ * @brief Enumeration of plugin states
+ */
+enum class PluginState {
+    NotLoaded,
+    Loaded,
+    Initialized,
+    Active,
+    Inactive,      ///< Initialized and deactivated after having been active
+    Failed
+};
+
+/**
+ * @brief The PluginStateTable class holds the state of every plugin in an atomic slot.
+ *
+ * Slots are indexed by PluginHandle and live in fixed-size chunks that are allocated on
+ * first use and never moved or freed while the table exists, so readers need no lock:
+ * a query is one acquire load. Writers publish with release semantics and must be
+ * serialized by the owner of the table.
+ *
+ * Besides the state, each slot records whether a plugin instance is attached, which
+ * answers "is this plugin loaded" without looking at the instance arrays.
+ */
+class PluginStateTable
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    PluginStateTable();
+
+    /**
+     * @brief Destructor
+     */
+    ~PluginStateTable();
+
+    /**
+     * @brief Get the state of a plugin
+     *
+     * @param handle Handle of the plugin
+     * @return State of the plugin, NotLoaded for unknown handles
+     */
+    PluginState state(PluginHandle handle) const;
+
+    /**
+     * @brief Set the state of a plugin
+     *
+     * @param handle Handle of the plugin
+     * @param state New state
+     */
+    void setState(PluginHandle handle, PluginState state);
+
+    /**
+     * @brief Check if a plugin instance is attached
+     *
+     * @param handle Handle of the plugin
+     * @return True if the plugin is loaded, false otherwise
+     */
+    bool isAttached(PluginHandle handle) const;
+
+    /**
+     * @brief Record whether a plugin instance is attached
+     *
+     * @param handle Handle of the plugin
+     * @param attached True if an instance is attached, false otherwise
+     */
+    void setAttached(PluginHandle handle, bool attached);
+
+    /**
+     * @brief Reset every slot to NotLoaded without an instance
+     */
+    void clear();
+
+private:
+    PluginStateTable(const PluginStateTable&) = delete;
+    PluginStateTable& operator=(const PluginStateTable&) = delete;
+
+    static const int ChunkShift = 6;
+    static const int ChunkSize = 1 << ChunkShift;
+    static const int MaxChunks = 1024;      // Room for 65536 plugin handles
+    static const int StateMask = 0xff;
+    static const int AttachedFlag = 0x100;
+
+    struct Chunk {
+        QAtomicInt slots[ChunkSize];
+    };
+
+    /**
+     * @brief Get the slot of a handle for reading
+     *
+     * @return Slot of the handle, or nullptr if it has never been written
+     */
+    const QAtomicInt* slot(PluginHandle handle) const;
+
+    /**
+     * @brief Get the slot of a handle for writing, allocating its chunk if needed
+     *
+     * @return Slot of the handle, or nullptr if the handle is invalid or beyond the table
+     */
+    QAtomicInt* writableSlot(PluginHandle handle);
+
+    /**
+     * @brief Store a new slot value
+     */
+    void publish(PluginHandle handle, int mask, int bits);
+
+    QAtomicPointer<Chunk> m_chunks[MaxChunks];
+};
+
+#endif // PLUGINSTATETABLE_H
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "PluginUsageHistory.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QPair>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// A score halves every two weeks without use
+const double HalfLifeSeconds = 14 * 24 * 3600.0;
+
+// Scores below this belong to plugins that have not been used for months
+const double MinPredictedScore = 0.1;
+
+} // namespace
+
+PluginUsageHistory::PluginUsageHistory() : m_dirty(false)
+{
+}
+
+bool PluginUsageHistory::load(const QString& historyPath)
+{
+    m_entries.clear();
+    m_dirty = false;
+
+    QFile file(historyPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    file.close();
+
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        return false;
+    }
+
+    QJsonObject root = doc.object();
+    if (root.value("version").toInt() != HistoryVersion) {
+        return false;
+    }
+
+    const QJsonArray plugins = root.value("plugins").toArray();
+    for (const QJsonValue& value : plugins) {
+        QJsonObject plugin = value.toObject();
+        QString pluginId = plugin.value("id").toString();
+        if (pluginId.isEmpty()) {
+            continue;
+        }
+
+        Entry entry;
+        entry.activations = plugin.value("activations").toInt();
+        entry.score = plugin.value("score").toDouble();
+        entry.lastActivated = QDateTime::fromString(plugin.value("lastActivated").toString(), Qt::ISODate);
+        if (entry.activations > 0 && entry.lastActivated.isValid()) {
+            m_entries.insert(pluginId, entry);
+        }
+    }
+
+    return true;
+}
+
+bool PluginUsageHistory::save(const QString& historyPath)
+{
+    QJsonArray plugins;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        QJsonObject plugin;
+        plugin["id"] = it.key();
+        plugin["activations"] = it.value().activations;
+        plugin["score"] = it.value().score;
+        plugin["lastActivated"] = it.value().lastActivated.toString(Qt::ISODate);
+        plugins.append(plugin);
+    }
+
+    QJsonObject root;
+    root["version"] = HistoryVersion;
+    root["plugins"] = plugins;
+
+    QSaveFile file(historyPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    file.write(QJsonDocument(root).toJson());
+    if (!file.commit()) {
+        return false;
+    }
+
+    m_dirty = false;
+
+    return true;
+}
+
+void PluginUsageHistory::recordActivation(const QString& pluginId, const QDateTime& when)
+{
+    Entry& entry = m_entries[pluginId];
+    entry.score = decayedScore(entry, when) + 1.0;
+    ++entry.activations;
+    entry.lastActivated = when;
+    m_dirty = true;
+}
+
+double PluginUsageHistory::score(const QString& pluginId, const QDateTime& now) const
+{
+    auto it = m_entries.constFind(pluginId);
+    return it != m_entries.constEnd() ? decayedScore(it.value(), now) : 0.0;
+}
+
+QStringList PluginUsageHistory::predict(int maxPlugins, const QDateTime& now) const
+{
+    QList<QPair<double, QString>> ranked;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        double score = decayedScore(it.value(), now);
+        if (score >= MinPredictedScore) {
+            ranked.append(qMakePair(score, it.key()));
+        }
+    }
+
+    std::sort(ranked.begin(), ranked.end(), [](const QPair<double, QString>& a, const QPair<double, QString>& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+
+    QStringList pluginIds;
+    for (int i = 0; i < ranked.size() && i < maxPlugins; ++i) {
+        pluginIds.append(ranked[i].second);
+    }
+
+    return pluginIds;
+}
+
+void PluginUsageHistory::clear()
+{
+    m_dirty = m_dirty || !m_entries.isEmpty();
+    m_entries.clear();
+}
+
+bool PluginUsageHistory::isDirty() const
+{
+    return m_dirty;
+}
+
+double PluginUsageHistory::decayedScore(const Entry& entry, const QDateTime& now)
+{
+    if (!entry.lastActivated.isValid()) {
+        return entry.score;
+    }
+
+    double ageSeconds = qMax<qint64>(0, entry.lastActivated.secsTo(now));
+    return entry.score * std::pow(0.5, ageSeconds / HalfLifeSeconds);
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#ifndef PLUGINUSAGEHISTORY_H
+#define PLUGINUSAGEHISTORY_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QDateTime>
+
+/**
+ * @brief The PluginUsageHistory class remembers which plugins were activated and when.
+ *
+ * Every activation adds one to a per-plugin score that halves every two weeks, so the
+ * score ranks plugins by how often and how recently they were used. The history is
+ * stored as a small JSON document so that operators can inspect or reset it. Plugins
+ * that were never activated have no entry and are never predicted.
+ */
+class PluginUsageHistory
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    PluginUsageHistory();
+
+    /**
+     * @brief Load the history from a file
+     *
+     * @param historyPath Path to the history file
+     * @return True if the history was loaded, false if it is missing or unreadable
+     */
+    bool load(const QString& historyPath);
+
+    /**
+     * @brief Save the history to a file
+     *
+     * @param historyPath Path to the history file
+     * @return True if saving was successful, false otherwise
+     */
+    bool save(const QString& historyPath);
+
+    /**
+     * @brief Record an activation of a plugin
+     *
+     * @param pluginId ID of the plugin
+     * @param when Time of the activation
+     */
+    void recordActivation(const QString& pluginId, const QDateTime& when = QDateTime::currentDateTimeUtc());
+
+    /**
+     * @brief Get the usage score of a plugin
+     *
+     * @param pluginId ID of the plugin
+     * @param now Time to decay the score to
+     * @return Decayed number of activations, 0 for plugins without history
+     */
+    double score(const QString& pluginId, const QDateTime& now = QDateTime::currentDateTimeUtc()) const;
+
+    /**
+     * @brief Predict the plugins most likely to be used next
+     *
+     * @param maxPlugins Maximum number of plugins to return
+     * @param now Time to decay the scores to
+     * @return IDs of previously used plugins, most likely first
+     */
+    QStringList predict(int maxPlugins, const QDateTime& now = QDateTime::currentDateTimeUtc()) const;
+
+    /**
+     * @brief Remove all entries
+     */
+    void clear();
+
+    /**
+     * @brief Check if the history changed since it was loaded or saved
+     *
+     * @return True if the history has unsaved changes, false otherwise
+     */
+    bool isDirty() const;
+
+private:
+    struct Entry {
+        int activations = 0;            // Total number of activations
+        double score = 0.0;             // Decayed activations as of lastActivated
+        QDateTime lastActivated;
+    };
+
+    /**
+     * @brief Decay the score of an entry to a point in time
+     */
+    static double decayedScore(const Entry& entry, const QDateTime& now);
+
+    QHash<QString, Entry> m_entries;
+    bool m_dirty;
+
+    // Bumped whenever the on-disk layout changes
+    static const int HistoryVersion = 1;
+};
+
+#endif // PLUGINUSAGEHISTORY_H
\ No newline at end of file
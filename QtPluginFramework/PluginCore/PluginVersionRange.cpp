@@ -0,0 +1,185 @@
+#include "PluginVersionRange.h"
+
+#include <QStringList>
+
+namespace {
+
+// Number of leading comparison operator characters in a token
+int operatorLength(const QString& token)
+{
+    int length = 0;
+    while (length < token.size() && QString("<>=^~").contains(token.at(length))) {
+        ++length;
+    }
+    return length;
+}
+
+} // namespace
+
+PluginVersionRange::PluginVersionRange()
+{
+}
+
+PluginVersionRange PluginVersionRange::fromString(const QString& range, bool* ok)
+{
+    PluginVersionRange result;
+    result.m_text = range.trimmed();
+    bool any = false;
+
+    const QStringList alternatives = result.m_text.split("||");
+    for (const QString& alternative : alternatives) {
+        QVector<Comparator> comparators;
+        QString pendingOperator;
+
+        const QStringList tokens = alternative.simplified().split(' ', Qt::SkipEmptyParts);
+        for (const QString& token : tokens) {
+            if (token == "*" || token.compare("x", Qt::CaseInsensitive) == 0) {
+                continue;
+            }
+
+            // An operator written apart from its version, as in ">= 1.2"
+            if (operatorLength(token) == token.size()) {
+                pendingOperator = token;
+                continue;
+            }
+
+            if (!parseComparator(pendingOperator + token, comparators)) {
+                if (ok) {
+                    *ok = false;
+                }
+                return PluginVersionRange();
+            }
+            pendingOperator.clear();
+        }
+
+        if (!pendingOperator.isEmpty()) {
+            if (ok) {
+                *ok = false;
+            }
+            return PluginVersionRange();
+        }
+
+        if (comparators.isEmpty()) {
+            any = true;
+        }
+        result.m_alternatives.append(comparators);
+    }
+
+    if (any) {
+        result.m_alternatives.clear();
+    }
+
+    if (ok) {
+        *ok = true;
+    }
+
+    return result;
+}
+
+bool PluginVersionRange::contains(const QVersionNumber& version) const
+{
+    if (m_alternatives.isEmpty()) {
+        return true;
+    }
+
+    for (const QVector<Comparator>& comparators : m_alternatives) {
+        bool satisfied = true;
+        for (const Comparator& comparator : comparators) {
+            if (!matches(comparator, version)) {
+                satisfied = false;
+                break;
+            }
+        }
+
+        if (satisfied) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool PluginVersionRange::isAny() const
+{
+    return m_alternatives.isEmpty();
+}
+
+QString PluginVersionRange::toString() const
+{
+    return m_text.isEmpty() ? QString("*") : m_text;
+}
+
+bool PluginVersionRange::parseComparator(const QString& token, QVector<Comparator>& comparators)
+{
+    QString op = token.left(operatorLength(token));
+    QString versionText = token.mid(op.size());
+
+    int suffixIndex = 0;
+    QVersionNumber version = QVersionNumber::fromString(versionText, &suffixIndex);
+    if (version.isNull() || suffixIndex != versionText.size()) {
+        return false;
+    }
+
+    int major = version.majorVersion();
+    int minor = version.minorVersion();
+
+    if (op == "<") {
+        comparators.append(Comparator{Operator::Less, version});
+    } else if (op == "<=") {
+        comparators.append(Comparator{Operator::LessEqual, version});
+    } else if (op == ">") {
+        comparators.append(Comparator{Operator::Greater, version});
+    } else if (op == ">=") {
+        comparators.append(Comparator{Operator::GreaterEqual, version});
+    } else if (op.isEmpty() || op == "=" || op == "==") {
+        comparators.append(Comparator{Operator::Equal, version});
+    } else if (op == "^") {
+        // Below 1.0 every minor version may break compatibility, and below 0.1 every patch version
+        QVersionNumber upper = major > 0 ? QVersionNumber(major + 1)
+                             : minor == 0 && version.segmentCount() > 2 ? QVersionNumber(0, 0, version.microVersion() + 1)
+                             : version.segmentCount() > 1 ? QVersionNumber(0, minor + 1)
+                             : QVersionNumber(1);
+        comparators.append(Comparator{Operator::GreaterEqual, version});
+        comparators.append(Comparator{Operator::Less, upper});
+    } else if (op == "~") {
+        QVersionNumber upper = version.segmentCount() > 1 ? QVersionNumber(major, minor + 1) : QVersionNumber(major + 1);
+        comparators.append(Comparator{Operator::GreaterEqual, version});
+        comparators.append(Comparator{Operator::Less, upper});
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+bool PluginVersionRange::matches(const Comparator& comparator, const QVersionNumber& version)
+{
+    if (comparator.op == Operator::Equal) {
+        // Only the comparator's own segments are compared, so 1.2 matches 1.2.0 as well as
+        // 1.2.5; a segment the version lacks counts as 0
+        for (int i = 0; i < comparator.version.segmentCount(); ++i) {
+            if (version.segmentAt(i) != comparator.version.segmentAt(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Normalizing makes 1.2 and 1.2.0 compare equal
+    int order = QVersionNumber::compare(version.normalized(), comparator.version.normalized());
+
+    switch (comparator.op) {
+        case Operator::Less:
+            return order < 0;
+        case Operator::LessEqual:
+            return order <= 0;
+        case Operator::Greater:
+            return order > 0;
+        case Operator::GreaterEqual:
+            return order >= 0;
+        case Operator::Equal:
+            break;
+    }
+
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#ifndef PLUGINVERSIONRANGE_H
+#define PLUGINVERSIONRANGE_H
+
+#include <QString>
+#include <QVector>
+#include <QVersionNumber>
+
+/**
+ * @brief The PluginVersionRange class is a semver-style constraint on a plugin version.
+ *
+ * A range is a list of comparators that must all hold, such as ">=1.2 <2". Alternatives
+ * are separated by "||". Supported comparators are <, <=, >, >=, = (or a bare version),
+ * ^ (same major version; same minor version below 1.0; same patch version below 0.1)
+ * and ~ (same minor version).
+ * A bare or = version with fewer segments matches every version it is a prefix of, so
+ * "1.2" matches 1.2.7. An empty range, "*" and "x" match every version.
+ */
+class PluginVersionRange
+{
+public:
+    /**
+     * @brief Constructs a range matching every version
+     */
+    PluginVersionRange();
+
+    /**
+     * @brief Parse a range
+     *
+     * @param range Text of the range, for example ">=1.2 <2"
+     * @param ok Set to false if the text is not a valid range
+     * @return The parsed range, or a range matching every version if the text is invalid
+     */
+    static PluginVersionRange fromString(const QString& range, bool* ok = nullptr);
+
+    /**
+     * @brief Check if a version lies in the range
+     *
+     * @param version Version to check
+     * @return True if the version satisfies the range, false otherwise
+     */
+    bool contains(const QVersionNumber& version) const;
+
+    /**
+     * @brief Check if the range matches every version
+     *
+     * @return True if the range places no constraint, false otherwise
+     */
+    bool isAny() const;
+
+    /**
+     * @brief Get the text the range was parsed from
+     *
+     * @return The range as written, or "*" for a range matching every version
+     */
+    QString toString() const;
+
+private:
+    enum class Operator {
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        Equal
+    };
+
+    struct Comparator {
+        Operator op;
+        QVersionNumber version;
+    };
+
+    /**
+     * @brief Parse one comparator, expanding ^ and ~ into a pair of bounds
+     *
+     * @return True if the token is a valid comparator, false otherwise
+     */
+    static bool parseComparator(const QString& token, QVector<Comparator>& comparators);
+
+    /**
+     * @brief Check if a version satisfies a comparator
+     */
+    static bool matches(const Comparator& comparator, const QVersionNumber& version);
+
+    QVector<QVector<Comparator>> m_alternatives;   // Empty if every version matches
+    QString m_text;
+};
+
+#endif // PLUGINVERSIONRANGE_H
\ No newline at end of file
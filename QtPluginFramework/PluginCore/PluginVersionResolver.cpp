@@ -0,0 +1,257 @@
+#include "PluginVersionResolver.h"
+
+PluginVersionResolver::PluginVersionResolver()
+{
+}
+
+void PluginVersionResolver::setFrameworkVersion(const QVersionNumber& frameworkVersion)
+{
+    if (m_frameworkVersion == frameworkVersion) {
+        return;
+    }
+
+    m_frameworkVersion = frameworkVersion;
+
+    for (auto it = m_plugins.constBegin(); it != m_plugins.constEnd(); ++it) {
+        markDirty(it.key());
+    }
+}
+
+bool PluginVersionResolver::addVersion(const PluginMetadata& metadata, QStringList* cycle)
+{
+    QString pluginId = metadata.getPluginId();
+    QVersionNumber version = metadata.getVersionNumber().normalized();
+
+    InstalledPlugin plugin = m_plugins.value(pluginId);
+
+    // Rescanning finds the same files again, which must not trigger a resolution
+    auto existing = plugin.versions.constFind(version);
+    if (existing != plugin.versions.constEnd() && existing.value().getMetadataJson() == metadata.getMetadataJson()) {
+        return true;
+    }
+
+    plugin.versions.insert(version, metadata);
+
+    if (!updateDependencies(pluginId, plugin, cycle)) {
+        return false;
+    }
+
+    m_plugins.insert(pluginId, plugin);
+    markDirty(pluginId);
+
+    return true;
+}
+
+void PluginVersionResolver::removePlugin(const QString& pluginId)
+{
+    auto it = m_plugins.find(pluginId);
+    if (it == m_plugins.end() || it->versions.isEmpty()) {
+        return;
+    }
+
+    // The pin stays, so that it applies again when the plugin is reinstalled
+    it->versions.clear();
+    m_graph.removePlugin(pluginId);
+    markDirty(pluginId);
+}
+
+void PluginVersionResolver::clear()
+{
+    // Pins are configuration rather than discovered state, so they survive
+    for (auto it = m_plugins.begin(); it != m_plugins.end();) {
+        if (it->pinnedVersion.isNull()) {
+            it = m_plugins.erase(it);
+        } else {
+            it->versions.clear();
+            ++it;
+        }
+    }
+    m_plan.clear();
+    m_dirty.clear();
+    m_graph.clear();
+}
+
+bool PluginVersionResolver::hasVersion(const QString& pluginId, const QVersionNumber& version) const
+{
+    auto it = m_plugins.constFind(pluginId);
+    return it != m_plugins.constEnd() && it->versions.contains(version.normalized());
+}
+
+QList<PluginMetadata> PluginVersionResolver::versions(const QString& pluginId) const
+{
+    QList<PluginMetadata> result;
+
+    auto it = m_plugins.constFind(pluginId);
+    if (it != m_plugins.constEnd()) {
+        const QList<PluginMetadata> ascending = it->versions.values();
+        for (auto version = ascending.crbegin(); version != ascending.crend(); ++version) {
+            result.append(*version);
+        }
+    }
+
+    return result;
+}
+
+void PluginVersionResolver::setPinnedVersion(const QString& pluginId, const QVersionNumber& version)
+{
+    InstalledPlugin& plugin = m_plugins[pluginId];
+    if (plugin.pinnedVersion == version) {
+        return;
+    }
+
+    plugin.pinnedVersion = version;
+    markDirty(pluginId);
+}
+
+QVersionNumber PluginVersionResolver::pinnedVersion(const QString& pluginId) const
+{
+    return m_plugins.value(pluginId).pinnedVersion;
+}
+
+QStringList PluginVersionResolver::resolve()
+{
+    if (m_dirty.isEmpty()) {
+        return QStringList();
+    }
+
+    // A plugin constrains only its dependencies, so nothing else can change
+    QSet<QString> affected;
+    const QList<QString> dirtyPluginIds = m_dirty.values();
+    for (const QString& pluginId : dirtyPluginIds) {
+        affected.insert(pluginId);
+
+        const QStringList dependencies = m_graph.transitiveDependencies(pluginId);
+        for (const QString& depId : dependencies) {
+            affected.insert(depId);
+        }
+    }
+    m_dirty.clear();
+
+    QStringList changedPluginIds;
+
+    // Every dependent comes before its dependencies, so all constraints on a plugin are
+    // settled when it is reached; unaffected dependents keep their cached resolution
+    const QStringList order = m_graph.unloadOrder(affected.values());
+    for (const QString& pluginId : order) {
+        if (!affected.contains(pluginId)) {
+            continue;
+        }
+
+        auto plugin = m_plugins.constFind(pluginId);
+        if (plugin == m_plugins.constEnd() || plugin->versions.isEmpty()) {
+            if (m_plan.remove(pluginId) > 0) {
+                changedPluginIds.append(pluginId);
+            }
+            continue;
+        }
+
+        Resolution resolution = resolvePlugin(pluginId, plugin.value());
+
+        auto planned = m_plan.constFind(pluginId);
+        if (planned == m_plan.constEnd() || planned->conflict != resolution.conflict ||
+            planned->metadata.getMetadataJson() != resolution.metadata.getMetadataJson()) {
+            m_plan.insert(pluginId, resolution);
+            changedPluginIds.append(pluginId);
+        }
+    }
+
+    return changedPluginIds;
+}
+
+PluginMetadata PluginVersionResolver::resolvedMetadata(const QString& pluginId) const
+{
+    return m_plan.value(pluginId).metadata;
+}
+
+QString PluginVersionResolver::conflict(const QString& pluginId) const
+{
+    return m_plan.value(pluginId).conflict;
+}
+
+PluginVersionResolver::Resolution PluginVersionResolver::resolvePlugin(const QString& pluginId, const InstalledPlugin& plugin) const
+{
+    // Ranges declared by the chosen versions of the dependents
+    QList<PluginVersionRange> ranges;
+    QStringList requirements;
+
+    const QStringList dependents = m_graph.dependents(pluginId);
+    for (const QString& dependentId : dependents) {
+        auto planned = m_plan.constFind(dependentId);
+        if (planned == m_plan.constEnd() || !planned->metadata.dependsOn(pluginId)) {
+            continue;
+        }
+
+        PluginVersionRange range = planned->metadata.getDependencyRange(pluginId);
+        if (!range.isAny()) {
+            ranges.append(range);
+            requirements.append(QString("%1 %2 requires %3").arg(dependentId, planned->metadata.getPluginVersion(), range.toString()));
+        }
+    }
+
+    QVersionNumber pinnedVersion = plugin.pinnedVersion.normalized();
+    bool pinned = !pinnedVersion.isNull() && plugin.versions.contains(pinnedVersion);
+
+    Resolution resolution;
+
+    for (auto it = plugin.versions.constEnd(); it != plugin.versions.constBegin();) {
+        --it;
+
+        if ((pinned && it.key() != pinnedVersion) ||
+            (!m_frameworkVersion.isNull() && !it.value().isCompatibleWithFramework(m_frameworkVersion))) {
+            continue;
+        }
+
+        bool satisfied = true;
+        for (const PluginVersionRange& range : ranges) {
+            if (!range.contains(it.value().getVersionNumber())) {
+                satisfied = false;
+                break;
+            }
+        }
+
+        if (satisfied) {
+            resolution.metadata = it.value();
+            break;
+        }
+    }
+
+    if (!resolution.metadata.isValid()) {
+        resolution.metadata = pinned ? plugin.versions.value(pinnedVersion) : plugin.versions.last();
+        resolution.conflict = requirements.isEmpty()
+            ? QString("No installed version is compatible with framework version %1").arg(m_frameworkVersion.toString())
+            : QString("No installed version satisfies: %1").arg(requirements.join(", "));
+    }
+
+    if (!pinnedVersion.isNull() && !pinned) {
+        QString missing = QString("Pinned version %1 is not installed").arg(plugin.pinnedVersion.toString());
+        resolution.conflict = resolution.conflict.isEmpty() ? missing : missing + "; " + resolution.conflict;
+    }
+
+    return resolution;
+}
+
+bool PluginVersionResolver::updateDependencies(const QString& pluginId, const InstalledPlugin& plugin, QStringList* cycle)
+{
+    QStringList dependencies;
+    for (const PluginMetadata& metadata : plugin.versions) {
+        const QStringList versionDependencies = metadata.getPluginDependencies();
+        for (const QString& depId : versionDependencies) {
+            if (!dependencies.contains(depId)) {
+                dependencies.append(depId);
+            }
+        }
+    }
+
+    return m_graph.setDependencies(pluginId, dependencies, cycle);
+}
+
+void PluginVersionResolver::markDirty(const QString& pluginId)
+{
+    m_dirty.insert(pluginId);
+
+    // The graph may lose the edges of a removed version, but its choice still constrained these
+    const QStringList dependencies = m_plan.value(pluginId).metadata.getPluginDependencies();
+    for (const QString& depId : dependencies) {
+        m_dirty.insert(depId);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,161 @@
+#ifndef PLUGINVERSIONRESOLVER_H
+#define PLUGINVERSIONRESOLVER_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QList>
+#include <QVersionNumber>
+
+#include "PluginDependencyGraph.h"
+#include "PluginMetadata.h"
+
+/**
+ * @brief The PluginVersionResolver class picks one installed version of every plugin.
+ *
+ * Several versions of a plugin may be installed side by side. The resolver keeps all of
+ * them, together with a dependency graph holding the union of their dependencies, and
+ * chooses for each plugin the newest version that satisfies the version ranges declared
+ * by the chosen versions of its dependents, a pinned version if one is set.
+ *
+ * Constraints only flow from dependents to dependencies, so visiting plugins with every
+ * dependent before its dependencies resolves the whole set in one pass. The resulting
+ * plan is cached; after a change only the changed plugins and their transitive
+ * dependencies are resolved again.
+ *
+ * When no installed version satisfies every constraint, the newest candidate is chosen
+ * anyway and the conflict is reported, so that the dependents that cannot be served fail
+ * their dependency check instead of the plugin itself disappearing.
+ */
+class PluginVersionResolver
+{
+public:
+    /**
+     * @brief Constructor
+     */
+    PluginVersionResolver();
+
+    /**
+     * @brief Set the framework version that chosen versions must be compatible with
+     *
+     * @param frameworkVersion Version of the framework
+     */
+    void setFrameworkVersion(const QVersionNumber& frameworkVersion);
+
+    /**
+     * @brief Add an installed version of a plugin, or replace it if it is known
+     *
+     * The version is rejected if its dependencies would create a cycle.
+     *
+     * @param metadata Metadata of the installed version
+     * @param cycle Receives the plugins forming the cycle
+     * @return True if the version was added, false if it would create a cycle
+     */
+    bool addVersion(const PluginMetadata& metadata, QStringList* cycle = nullptr);
+
+    /**
+     * @brief Remove all installed versions of a plugin
+     *
+     * @param pluginId ID of the plugin
+     */
+    void removePlugin(const QString& pluginId);
+
+    /**
+     * @brief Remove all installed versions and the cached plan, keeping the pins
+     */
+    void clear();
+
+    /**
+     * @brief Check if a version of a plugin is installed
+     *
+     * @param pluginId ID of the plugin
+     * @param version Version to look for
+     * @return True if the version is installed, false otherwise
+     */
+    bool hasVersion(const QString& pluginId, const QVersionNumber& version) const;
+
+    /**
+     * @brief Get the installed versions of a plugin
+     *
+     * @param pluginId ID of the plugin
+     * @return Metadata of the installed versions, newest first
+     */
+    QList<PluginMetadata> versions(const QString& pluginId) const;
+
+    /**
+     * @brief Pin a plugin to one of its versions
+     *
+     * @param pluginId ID of the plugin
+     * @param version Version to use, or a null version to remove the pin
+     */
+    void setPinnedVersion(const QString& pluginId, const QVersionNumber& version);
+
+    /**
+     * @brief Get the version a plugin is pinned to
+     *
+     * @param pluginId ID of the plugin
+     * @return The pinned version, or a null version if the plugin is not pinned
+     */
+    QVersionNumber pinnedVersion(const QString& pluginId) const;
+
+    /**
+     * @brief Resolve the plugins affected by changes since the last call
+     *
+     * @return IDs of the plugins whose chosen version or conflict changed
+     */
+    QStringList resolve();
+
+    /**
+     * @brief Get the chosen version of a plugin
+     *
+     * @param pluginId ID of the plugin
+     * @return Metadata of the chosen version, or invalid metadata if none is installed
+     */
+    PluginMetadata resolvedMetadata(const QString& pluginId) const;
+
+    /**
+     * @brief Get the reason the constraints on a plugin could not be satisfied
+     *
+     * @param pluginId ID of the plugin
+     * @return Description of the conflict, or an empty string if there is none
+     */
+    QString conflict(const QString& pluginId) const;
+
+private:
+    struct InstalledPlugin {
+        QMap<QVersionNumber, PluginMetadata> versions;  // Keyed by normalized version
+        QVersionNumber pinnedVersion;
+    };
+
+    struct Resolution {
+        PluginMetadata metadata;
+        QString conflict;
+    };
+
+    /**
+     * @brief Choose a version of a plugin from the constraints of its resolved dependents
+     */
+    Resolution resolvePlugin(const QString& pluginId, const InstalledPlugin& plugin) const;
+
+    /**
+     * @brief Update the union graph edges of a plugin from its installed versions
+     *
+     * @return True if the edges were updated, false if they would create a cycle
+     */
+    bool updateDependencies(const QString& pluginId, const InstalledPlugin& plugin, QStringList* cycle);
+
+    /**
+     * @brief Mark a plugin and the dependencies of its chosen version for resolution
+     */
+    void markDirty(const QString& pluginId);
+
+    QHash<QString, InstalledPlugin> m_plugins;
+    QHash<QString, Resolution> m_plan;
+    QSet<QString> m_dirty;
+    PluginDependencyGraph m_graph;         // Union of the dependencies of all versions
+    QVersionNumber m_frameworkVersion;
+};
+
+#endif // PLUGINVERSIONRESOLVER_H
\ No newline at end of file
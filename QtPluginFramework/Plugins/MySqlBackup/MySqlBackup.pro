@@ -4,6 +4,9 @@ TARGET = MySqlBackup
 TEMPLATE = lib
 CONFIG += plugin
 
+# Build a static library for linking into HostApplication
+static_plugins: CONFIG += static
+
 # The following define makes your compiler emit warnings if you use
 # any feature of Qt which has been marked as deprecated
 DEFINES += QT_DEPRECATED_WARNINGS
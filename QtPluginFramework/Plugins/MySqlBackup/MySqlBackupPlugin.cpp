@@ -20,7 +20,8 @@ MySqlBackupPlugin::MySqlBackupPlugin()
     : m_initialized(false), m_active(false),
       m_dbHost("localhost"), m_dbPort(3306), m_dbName(""),
       m_dbUser("root"), m_dbPassword(""), m_backupDir(""),
-      m_scheduleEnabled(false), m_scheduleInterval(60) // 1 hour
+      m_scheduleEnabled(false), m_scheduleInterval(60), // 1 hour
+      m_backupTimer(this) // Parented so it follows the plugin across threads
 {
     // Load metadata
     QFile metadataFile(":/MySqlBackup.json");
@@ -187,8 +188,40 @@ QJsonObject MySqlBackupPlugin::getPluginMetadata() const
     return m_metadata;
 }
 
-QVariant MySqlBackupPlugin::executeCommand(const QString& command, const QVariantMap& params)
+QList<PluginCommandDescriptor> MySqlBackupPlugin::commandDescriptors() const
+{
+    static const QList<PluginCommandDescriptor> descriptors = {
+        {ShowInfoCommand, "showInfo", "Show Info", {}, true, true, true},
+        {ConfigureCommand, "configure", "Configure...", {}, true, false, true},
+        {BackupCommand, "backup", "Back Up Now", {}, true, false, true},
+        {EnableScheduleCommand, "enableSchedule", "Enable Scheduled Backups", {}, false, true},
+        {DisableScheduleCommand, "disableSchedule", "Disable Scheduled Backups", {}, false, true},
+        {SetScheduleIntervalCommand, "setScheduleInterval", QString(),
+         {{"interval", QMetaType::Int, true}}, false, true}
+    };
+
+    return descriptors;
+}
+
+QVariant MySqlBackupPlugin::invokeCommand(int commandId, const QVariantMap& params)
 {
+    // Jump table indexed by command ID, in the order of the Command enum
+    static const CommandHandler handlers[CommandCount] = {
+        &MySqlBackupPlugin::showInfo,
+        &MySqlBackupPlugin::configure,
+        &MySqlBackupPlugin::backup,
+        &MySqlBackupPlugin::enableSchedule,
+        &MySqlBackupPlugin::disableSchedule,
+        &MySqlBackupPlugin::setScheduleInterval
+    };
+
+    if (commandId < 0 || commandId >= CommandCount) {
+        LOG_WARNING(getPluginId(), QString("Unknown command ID: %1").arg(commandId));
+        return QVariant();
+    }
+
+    QString command = commandDescriptors().at(commandId).name;
+
     if (!m_active) {
         LOG_ERROR(getPluginId(), QString("Cannot execute command: plugin not active - %1").arg(command));
         return QVariant();
@@ -196,145 +229,168 @@ QVariant MySqlBackupPlugin::executeCommand(const QString& command, const QVarian
     
     LOG_INFO(getPluginId(), QString("Executing command: %1").arg(command));
     
-    if (command == "showInfo") {
-        // Show plugin information
-        QString info = QString("MySQL Backup Plugin v%1\n\n").arg(getPluginVersion());
-        info += QString("Database: %1:%2/%3\n").arg(m_dbHost).arg(m_dbPort).arg(m_dbName);
-        info += QString("Backup Directory: %1\n").arg(m_backupDir);
-        info += QString("Scheduled Backups: %1\n").arg(m_scheduleEnabled ? "Enabled" : "Disabled");
-        
-        if (m_scheduleEnabled) {
-            info += QString("Backup Interval: %1 minutes\n").arg(m_scheduleInterval);
-            info += QString("Last Backup: %1\n").arg(m_lastBackupTime.isValid() ? 
-                                                   m_lastBackupTime.toString("yyyy-MM-dd hh:mm:ss") : 
-                                                   "Never");
+    return (this->*handlers[commandId])(params);
+}
+
+QVariant MySqlBackupPlugin::executeCommand(const QString& command, const QVariantMap& params)
+{
+    // Commands addressed by name are mapped to their ID and share the jump table
+    for (const PluginCommandDescriptor& descriptor : commandDescriptors()) {
+        if (descriptor.name == command) {
+            return invokeCommand(descriptor.id, params);
         }
-        
-        QMessageBox::information(nullptr, "MySQL Backup Plugin", info);
-        
-        return true;
     }
-    else if (command == "configure") {
-        // Configure plugin
-        bool ok;
-        QString host = QInputDialog::getText(nullptr, "MySQL Backup Configuration",
-                                           "Database Host:", QLineEdit::Normal,
-                                           m_dbHost, &ok);
-        if (!ok) return false;
-        
-        int port = QInputDialog::getInt(nullptr, "MySQL Backup Configuration",
-                                      "Database Port:", m_dbPort, 1, 65535, 1, &ok);
-        if (!ok) return false;
-        
-        QString name = QInputDialog::getText(nullptr, "MySQL Backup Configuration",
-                                           "Database Name:", QLineEdit::Normal,
-                                           m_dbName, &ok);
-        if (!ok) return false;
-        
-        QString user = QInputDialog::getText(nullptr, "MySQL Backup Configuration",
-                                           "Database User:", QLineEdit::Normal,
-                                           m_dbUser, &ok);
-        if (!ok) return false;
-        
-        QString password = QInputDialog::getText(nullptr, "MySQL Backup Configuration",
-                                               "Database Password:", QLineEdit::Password,
-                                               m_dbPassword, &ok);
-        if (!ok) return false;
-        
-        QString backupDir = QFileDialog::getExistingDirectory(nullptr, "Select Backup Directory",
-                                                            m_backupDir.isEmpty() ? QDir::homePath() : m_backupDir);
-        if (backupDir.isEmpty()) return false;
-        
-        bool scheduleEnabled = QMessageBox::question(nullptr, "MySQL Backup Configuration",
-                                                   "Enable scheduled backups?",
-                                                   QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes;
-        
-        int scheduleInterval = m_scheduleInterval;
-        if (scheduleEnabled) {
-            scheduleInterval = QInputDialog::getInt(nullptr, "MySQL Backup Configuration",
-                                                  "Backup Interval (minutes):", m_scheduleInterval,
-                                                  1, 10080, 1, &ok); // Max 1 week
-            if (!ok) return false;
-        }
-        
-        // Update configuration
-        m_dbHost = host;
-        m_dbPort = port;
-        m_dbName = name;
-        m_dbUser = user;
-        m_dbPassword = password;
-        m_backupDir = backupDir;
-        m_scheduleEnabled = scheduleEnabled;
-        m_scheduleInterval = scheduleInterval;
-        
-        // Save configuration
-        saveConfig();
-        
-        // Update scheduled backups
-        if (m_active) {
-            stopScheduledBackups();
-            if (m_scheduleEnabled) {
-                startScheduledBackups();
-            }
-        }
-        
-        return true;
+    
+    LOG_WARNING(getPluginId(), QString("Unknown command: %1").arg(command));
+    
+    return QVariant();
+}
+
+QVariant MySqlBackupPlugin::showInfo(const QVariantMap&)
+{
+    // Show plugin information
+    QString info = QString("MySQL Backup Plugin v%1\n\n").arg(getPluginVersion());
+    info += QString("Database: %1:%2/%3\n").arg(m_dbHost).arg(m_dbPort).arg(m_dbName);
+    info += QString("Backup Directory: %1\n").arg(m_backupDir);
+    info += QString("Scheduled Backups: %1\n").arg(m_scheduleEnabled ? "Enabled" : "Disabled");
+    
+    if (m_scheduleEnabled) {
+        info += QString("Backup Interval: %1 minutes\n").arg(m_scheduleInterval);
+        info += QString("Last Backup: %1\n").arg(m_lastBackupTime.isValid() ? 
+                                               m_lastBackupTime.toString("yyyy-MM-dd hh:mm:ss") : 
+                                               "Never");
     }
-    else if (command == "backup") {
-        // Perform backup
-        QString backupPath = QDir(m_backupDir).filePath(QString("%1_%2.sql")
-                                                      .arg(m_dbName)
-                                                      .arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")));
-        
-        bool success = performBackup(m_dbHost, m_dbPort, m_dbName, m_dbUser, m_dbPassword, backupPath);
-        
-        if (success) {
-            QMessageBox::information(nullptr, "MySQL Backup", QString("Backup completed successfully:\n%1").arg(backupPath));
-        } else {
-            QMessageBox::warning(nullptr, "MySQL Backup", "Backup failed. Check the log for details.");
-        }
-        
-        return success;
+    
+    QMessageBox::information(nullptr, "MySQL Backup Plugin", info);
+    
+    return true;
+}
+
+QVariant MySqlBackupPlugin::configure(const QVariantMap&)
+{
+    // Configure plugin
+    bool ok;
+    QString host = QInputDialog::getText(nullptr, "MySQL Backup Configuration",
+                                       "Database Host:", QLineEdit::Normal,
+                                       m_dbHost, &ok);
+    if (!ok) return false;
+    
+    int port = QInputDialog::getInt(nullptr, "MySQL Backup Configuration",
+                                  "Database Port:", m_dbPort, 1, 65535, 1, &ok);
+    if (!ok) return false;
+    
+    QString name = QInputDialog::getText(nullptr, "MySQL Backup Configuration",
+                                       "Database Name:", QLineEdit::Normal,
+                                       m_dbName, &ok);
+    if (!ok) return false;
+    
+    QString user = QInputDialog::getText(nullptr, "MySQL Backup Configuration",
+                                       "Database User:", QLineEdit::Normal,
+                                       m_dbUser, &ok);
+    if (!ok) return false;
+    
+    QString password = QInputDialog::getText(nullptr, "MySQL Backup Configuration",
+                                           "Database Password:", QLineEdit::Password,
+                                           m_dbPassword, &ok);
+    if (!ok) return false;
+    
+    QString backupDir = QFileDialog::getExistingDirectory(nullptr, "Select Backup Directory",
+                                                        m_backupDir.isEmpty() ? QDir::homePath() : m_backupDir);
+    if (backupDir.isEmpty()) return false;
+    
+    bool scheduleEnabled = QMessageBox::question(nullptr, "MySQL Backup Configuration",
+                                               "Enable scheduled backups?",
+                                               QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes;
+    
+    int scheduleInterval = m_scheduleInterval;
+    if (scheduleEnabled) {
+        scheduleInterval = QInputDialog::getInt(nullptr, "MySQL Backup Configuration",
+                                              "Backup Interval (minutes):", m_scheduleInterval,
+                                              1, 10080, 1, &ok); // Max 1 week
+        if (!ok) return false;
     }
-    else if (command == "enableSchedule") {
-        m_scheduleEnabled = true;
-        saveConfig();
-        
-        if (m_active) {
+    
+    // Update configuration
+    m_dbHost = host;
+    m_dbPort = port;
+    m_dbName = name;
+    m_dbUser = user;
+    m_dbPassword = password;
+    m_backupDir = backupDir;
+    m_scheduleEnabled = scheduleEnabled;
+    m_scheduleInterval = scheduleInterval;
+    
+    // Save configuration
+    saveConfig();
+    
+    // Update scheduled backups
+    if (m_active) {
+        stopScheduledBackups();
+        if (m_scheduleEnabled) {
             startScheduledBackups();
         }
-        
-        return true;
     }
-    else if (command == "disableSchedule") {
-        m_scheduleEnabled = false;
+    
+    return true;
+}
+
+QVariant MySqlBackupPlugin::backup(const QVariantMap&)
+{
+    // Perform backup
+    QString backupPath = QDir(m_backupDir).filePath(QString("%1_%2.sql")
+                                                  .arg(m_dbName)
+                                                  .arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")));
+    
+    bool success = performBackup(m_dbHost, m_dbPort, m_dbName, m_dbUser, m_dbPassword, backupPath);
+    
+    if (success) {
+        QMessageBox::information(nullptr, "MySQL Backup", QString("Backup completed successfully:\n%1").arg(backupPath));
+    } else {
+        QMessageBox::warning(nullptr, "MySQL Backup", "Backup failed. Check the log for details.");
+    }
+    
+    return success;
+}
+
+QVariant MySqlBackupPlugin::enableSchedule(const QVariantMap&)
+{
+    m_scheduleEnabled = true;
+    saveConfig();
+    
+    if (m_active) {
+        startScheduledBackups();
+    }
+    
+    return true;
+}
+
+QVariant MySqlBackupPlugin::disableSchedule(const QVariantMap&)
+{
+    m_scheduleEnabled = false;
+    saveConfig();
+    
+    if (m_active) {
+        stopScheduledBackups();
+    }
+    
+    return true;
+}
+
+QVariant MySqlBackupPlugin::setScheduleInterval(const QVariantMap& params)
+{
+    if (params.contains("interval")) {
+        m_scheduleInterval = params["interval"].toInt();
         saveConfig();
         
-        if (m_active) {
+        if (m_active && m_scheduleEnabled) {
             stopScheduledBackups();
+            startScheduledBackups();
         }
         
         return true;
     }
-    else if (command == "setScheduleInterval") {
-        if (params.contains("interval")) {
-            m_scheduleInterval = params["interval"].toInt();
-            saveConfig();
-            
-            if (m_active && m_scheduleEnabled) {
-                stopScheduledBackups();
-                startScheduledBackups();
-            }
-            
-            return true;
-        }
-        
-        return false;
-    }
     
-    LOG_WARNING(getPluginId(), QString("Unknown command: %1").arg(command));
-    
-    return QVariant();
+    return false;
 }
 
 void MySqlBackupPlugin::performScheduledBackup()
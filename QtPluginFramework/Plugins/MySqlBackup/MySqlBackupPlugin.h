@@ -10,15 +10,16 @@
 #include <QTimer>
 
 #include "../../PluginCore/IPlugin.h"
+#include "../../PluginCore/ICommandProvider.h"
 
 /**
  * @brief The MySqlBackupPlugin class provides MySQL database backup functionality.
  */
-class MySqlBackupPlugin : public IPlugin
+class MySqlBackupPlugin : public IPlugin, public ICommandProvider
 {
     Q_OBJECT
     Q_PLUGIN_METADATA(IID PluginInterface_iid FILE "MySqlBackup.json")
-    Q_INTERFACES(IPlugin)
+    Q_INTERFACES(IPlugin ICommandProvider)
 
 public:
     /**
@@ -47,6 +48,10 @@ public:
     
     QVariant executeCommand(const QString& command, const QVariantMap& params = QVariantMap()) override;
 
+    // ICommandProvider interface
+    QList<PluginCommandDescriptor> commandDescriptors() const override;
+    QVariant invokeCommand(int commandId, const QVariantMap& params) override;
+
 private slots:
     /**
      * @brief Perform a scheduled backup
@@ -54,6 +59,51 @@ private slots:
     void performScheduledBackup();
 
 private:
+    /**
+     * @brief IDs of the published commands, also indexes of the command jump table
+     */
+    enum Command {
+        ShowInfoCommand,
+        ConfigureCommand,
+        BackupCommand,
+        EnableScheduleCommand,
+        DisableScheduleCommand,
+        SetScheduleIntervalCommand,
+        CommandCount
+    };
+
+    typedef QVariant (MySqlBackupPlugin::*CommandHandler)(const QVariantMap& params);
+
+    /**
+     * @brief Show the plugin configuration in a message box
+     */
+    QVariant showInfo(const QVariantMap& params);
+
+    /**
+     * @brief Ask the user for a new configuration
+     */
+    QVariant configure(const QVariantMap& params);
+
+    /**
+     * @brief Back up the database now and report the outcome
+     */
+    QVariant backup(const QVariantMap& params);
+
+    /**
+     * @brief Turn scheduled backups on
+     */
+    QVariant enableSchedule(const QVariantMap& params);
+
+    /**
+     * @brief Turn scheduled backups off
+     */
+    QVariant disableSchedule(const QVariantMap& params);
+
+    /**
+     * @brief Change the backup interval to the "interval" parameter, in minutes
+     */
+    QVariant setScheduleInterval(const QVariantMap& params);
+
     /**
      * @brief Perform a database backup
      * 
@@ -2,4 +2,7 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     MySqlBackup \
-    SqlServerBackup
\ No newline at end of file
+    SqlServerBackup
+
+DISTFILES += \
+    StaticPlugins.pri
\ No newline at end of file
@@ -23,7 +23,8 @@ SqlServerBackupPlugin::SqlServerBackupPlugin()
     : m_initialized(false), m_active(false),
       m_serverName("localhost\\SQLEXPRESS"), m_dbName(""),
       m_useWindowsAuth(true), m_username("sa"), m_password(""),
-      m_backupDir(""), m_scheduleEnabled(false), m_scheduleInterval(60) // 1 hour
+      m_backupDir(""), m_scheduleEnabled(false), m_scheduleInterval(60), // 1 hour
+      m_backupTimer(this) // Parented so it follows the plugin across threads
 {
     // Load metadata
     QFile metadataFile(":/SqlServerBackup.json");
@@ -190,8 +191,40 @@ QJsonObject SqlServerBackupPlugin::getPluginMetadata() const
     return m_metadata;
 }
 
-QVariant SqlServerBackupPlugin::executeCommand(const QString& command, const QVariantMap& params)
+QList<PluginCommandDescriptor> SqlServerBackupPlugin::commandDescriptors() const
+{
+    static const QList<PluginCommandDescriptor> descriptors = {
+        {ShowInfoCommand, "showInfo", "Show Info", {}, true, true, true},
+        {ConfigureCommand, "configure", "Configure...", {}, true, false, true},
+        {BackupCommand, "backup", "Back Up Now", {}, true, false, true},
+        {EnableScheduleCommand, "enableSchedule", "Enable Scheduled Backups", {}, false, true},
+        {DisableScheduleCommand, "disableSchedule", "Disable Scheduled Backups", {}, false, true},
+        {SetScheduleIntervalCommand, "setScheduleInterval", QString(),
+         {{"interval", QMetaType::Int, true}}, false, true}
+    };
+
+    return descriptors;
+}
+
+QVariant SqlServerBackupPlugin::invokeCommand(int commandId, const QVariantMap& params)
 {
+    // Jump table indexed by command ID, in the order of the Command enum
+    static const CommandHandler handlers[CommandCount] = {
+        &SqlServerBackupPlugin::showInfo,
+        &SqlServerBackupPlugin::configure,
+        &SqlServerBackupPlugin::backup,
+        &SqlServerBackupPlugin::enableSchedule,
+        &SqlServerBackupPlugin::disableSchedule,
+        &SqlServerBackupPlugin::setScheduleInterval
+    };
+
+    if (commandId < 0 || commandId >= CommandCount) {
+        LOG_WARNING(getPluginId(), QString("Unknown command ID: %1").arg(commandId));
+        return QVariant();
+    }
+
+    QString command = commandDescriptors().at(commandId).name;
+
     if (!m_active) {
         LOG_ERROR(getPluginId(), QString("Cannot execute command: plugin not active - %1").arg(command));
         return QVariant();
@@ -199,155 +232,178 @@ QVariant SqlServerBackupPlugin::executeCommand(const QString& command, const QVa
     
     LOG_INFO(getPluginId(), QString("Executing command: %1").arg(command));
     
-    if (command == "showInfo") {
-        // Show plugin information
-        QString info = QString("SQL Server Backup Plugin v%1\n\n").arg(getPluginVersion());
-        info += QString("Server: %1\n").arg(m_serverName);
-        info += QString("Database: %1\n").arg(m_dbName);
-        info += QString("Authentication: %1\n").arg(m_useWindowsAuth ? "Windows Authentication" : "SQL Server Authentication");
-        if (!m_useWindowsAuth) {
-            info += QString("Username: %1\n").arg(m_username);
-        }
-        info += QString("Backup Directory: %1\n").arg(m_backupDir);
-        info += QString("Scheduled Backups: %1\n").arg(m_scheduleEnabled ? "Enabled" : "Disabled");
-        
-        if (m_scheduleEnabled) {
-            info += QString("Backup Interval: %1 minutes\n").arg(m_scheduleInterval);
-            info += QString("Last Backup: %1\n").arg(m_lastBackupTime.isValid() ? 
-                                                   m_lastBackupTime.toString("yyyy-MM-dd hh:mm:ss") : 
-                                                   "Never");
+    return (this->*handlers[commandId])(params);
+}
+
+QVariant SqlServerBackupPlugin::executeCommand(const QString& command, const QVariantMap& params)
+{
+    // Commands addressed by name are mapped to their ID and share the jump table
+    for (const PluginCommandDescriptor& descriptor : commandDescriptors()) {
+        if (descriptor.name == command) {
+            return invokeCommand(descriptor.id, params);
         }
-        
-        QMessageBox::information(nullptr, "SQL Server Backup Plugin", info);
-        
-        return true;
     }
-    else if (command == "configure") {
-        // Configure plugin
-        bool ok;
-        QString serverName = QInputDialog::getText(nullptr, "SQL Server Backup Configuration",
-                                                 "Server Name:", QLineEdit::Normal,
-                                                 m_serverName, &ok);
+    
+    LOG_WARNING(getPluginId(), QString("Unknown command: %1").arg(command));
+    
+    return QVariant();
+}
+
+QVariant SqlServerBackupPlugin::showInfo(const QVariantMap&)
+{
+    // Show plugin information
+    QString info = QString("SQL Server Backup Plugin v%1\n\n").arg(getPluginVersion());
+    info += QString("Server: %1\n").arg(m_serverName);
+    info += QString("Database: %1\n").arg(m_dbName);
+    info += QString("Authentication: %1\n").arg(m_useWindowsAuth ? "Windows Authentication" : "SQL Server Authentication");
+    if (!m_useWindowsAuth) {
+        info += QString("Username: %1\n").arg(m_username);
+    }
+    info += QString("Backup Directory: %1\n").arg(m_backupDir);
+    info += QString("Scheduled Backups: %1\n").arg(m_scheduleEnabled ? "Enabled" : "Disabled");
+    
+    if (m_scheduleEnabled) {
+        info += QString("Backup Interval: %1 minutes\n").arg(m_scheduleInterval);
+        info += QString("Last Backup: %1\n").arg(m_lastBackupTime.isValid() ? 
+                                               m_lastBackupTime.toString("yyyy-MM-dd hh:mm:ss") : 
+                                               "Never");
+    }
+    
+    QMessageBox::information(nullptr, "SQL Server Backup Plugin", info);
+    
+    return true;
+}
+
+QVariant SqlServerBackupPlugin::configure(const QVariantMap&)
+{
+    // Configure plugin
+    bool ok;
+    QString serverName = QInputDialog::getText(nullptr, "SQL Server Backup Configuration",
+                                             "Server Name:", QLineEdit::Normal,
+                                             m_serverName, &ok);
+    if (!ok) return false;
+    
+    QString dbName = QInputDialog::getText(nullptr, "SQL Server Backup Configuration",
+                                         "Database Name:", QLineEdit::Normal,
+                                         m_dbName, &ok);
+    if (!ok) return false;
+    
+    bool useWindowsAuth = QMessageBox::question(nullptr, "SQL Server Backup Configuration",
+                                              "Use Windows Authentication?",
+                                              QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes;
+    
+    QString username = m_username;
+    QString password = m_password;
+    
+    if (!useWindowsAuth) {
+        username = QInputDialog::getText(nullptr, "SQL Server Backup Configuration",
+                                       "Username:", QLineEdit::Normal,
+                                       m_username, &ok);
         if (!ok) return false;
         
-        QString dbName = QInputDialog::getText(nullptr, "SQL Server Backup Configuration",
-                                             "Database Name:", QLineEdit::Normal,
-                                             m_dbName, &ok);
+        password = QInputDialog::getText(nullptr, "SQL Server Backup Configuration",
+                                       "Password:", QLineEdit::Password,
+                                       m_password, &ok);
         if (!ok) return false;
-        
-        bool useWindowsAuth = QMessageBox::question(nullptr, "SQL Server Backup Configuration",
-                                                  "Use Windows Authentication?",
-                                                  QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes;
-        
-        QString username = m_username;
-        QString password = m_password;
-        
-        if (!useWindowsAuth) {
-            username = QInputDialog::getText(nullptr, "SQL Server Backup Configuration",
-                                           "Username:", QLineEdit::Normal,
-                                           m_username, &ok);
-            if (!ok) return false;
-            
-            password = QInputDialog::getText(nullptr, "SQL Server Backup Configuration",
-                                           "Password:", QLineEdit::Password,
-                                           m_password, &ok);
-            if (!ok) return false;
-        }
-        
-        QString backupDir = QFileDialog::getExistingDirectory(nullptr, "Select Backup Directory",
-                                                            m_backupDir.isEmpty() ? QDir::homePath() : m_backupDir);
-        if (backupDir.isEmpty()) return false;
-        
-        bool scheduleEnabled = QMessageBox::question(nullptr, "SQL Server Backup Configuration",
-                                                   "Enable scheduled backups?",
-                                                   QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes;
-        
-        int scheduleInterval = m_scheduleInterval;
-        if (scheduleEnabled) {
-            scheduleInterval = QInputDialog::getInt(nullptr, "SQL Server Backup Configuration",
-                                                  "Backup Interval (minutes):", m_scheduleInterval,
-                                                  1, 10080, 1, &ok); // Max 1 week
-            if (!ok) return false;
-        }
-        
-        // Update configuration
-        m_serverName = serverName;
-        m_dbName = dbName;
-        m_useWindowsAuth = useWindowsAuth;
-        m_username = username;
-        m_password = password;
-        m_backupDir = backupDir;
-        m_scheduleEnabled = scheduleEnabled;
-        m_scheduleInterval = scheduleInterval;
-        
-        // Save configuration
-        saveConfig();
-        
-        // Update scheduled backups
-        if (m_active) {
-            stopScheduledBackups();
-            if (m_scheduleEnabled) {
-                startScheduledBackups();
-            }
-        }
-        
-        return true;
     }
-    else if (command == "backup") {
-        // Perform backup
-        QString backupPath = QDir(m_backupDir).filePath(QString("%1_%2.bak")
-                                                      .arg(m_dbName)
-                                                      .arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")));
-        
-        bool success = performBackup(m_serverName, m_dbName, m_useWindowsAuth, m_username, m_password, backupPath);
-        
-        if (success) {
-            QMessageBox::information(nullptr, "SQL Server Backup", QString("Backup completed successfully:\n%1").arg(backupPath));
-        } else {
-            QMessageBox::warning(nullptr, "SQL Server Backup", "Backup failed. Check the log for details.");
-        }
-        
-        return success;
+    
+    QString backupDir = QFileDialog::getExistingDirectory(nullptr, "Select Backup Directory",
+                                                        m_backupDir.isEmpty() ? QDir::homePath() : m_backupDir);
+    if (backupDir.isEmpty()) return false;
+    
+    bool scheduleEnabled = QMessageBox::question(nullptr, "SQL Server Backup Configuration",
+                                               "Enable scheduled backups?",
+                                               QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes;
+    
+    int scheduleInterval = m_scheduleInterval;
+    if (scheduleEnabled) {
+        scheduleInterval = QInputDialog::getInt(nullptr, "SQL Server Backup Configuration",
+                                              "Backup Interval (minutes):", m_scheduleInterval,
+                                              1, 10080, 1, &ok); // Max 1 week
+        if (!ok) return false;
     }
-    else if (command == "enableSchedule") {
-        m_scheduleEnabled = true;
-        saveConfig();
-        
-        if (m_active) {
+    
+    // Update configuration
+    m_serverName = serverName;
+    m_dbName = dbName;
+    m_useWindowsAuth = useWindowsAuth;
+    m_username = username;
+    m_password = password;
+    m_backupDir = backupDir;
+    m_scheduleEnabled = scheduleEnabled;
+    m_scheduleInterval = scheduleInterval;
+    
+    // Save configuration
+    saveConfig();
+    
+    // Update scheduled backups
+    if (m_active) {
+        stopScheduledBackups();
+        if (m_scheduleEnabled) {
             startScheduledBackups();
         }
-        
-        return true;
     }
-    else if (command == "disableSchedule") {
-        m_scheduleEnabled = false;
+    
+    return true;
+}
+
+QVariant SqlServerBackupPlugin::backup(const QVariantMap&)
+{
+    // Perform backup
+    QString backupPath = QDir(m_backupDir).filePath(QString("%1_%2.bak")
+                                                  .arg(m_dbName)
+                                                  .arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")));
+    
+    bool success = performBackup(m_serverName, m_dbName, m_useWindowsAuth, m_username, m_password, backupPath);
+    
+    if (success) {
+        QMessageBox::information(nullptr, "SQL Server Backup", QString("Backup completed successfully:\n%1").arg(backupPath));
+    } else {
+        QMessageBox::warning(nullptr, "SQL Server Backup", "Backup failed. Check the log for details.");
+    }
+    
+    return success;
+}
+
+QVariant SqlServerBackupPlugin::enableSchedule(const QVariantMap&)
+{
+    m_scheduleEnabled = true;
+    saveConfig();
+    
+    if (m_active) {
+        startScheduledBackups();
+    }
+    
+    return true;
+}
+
+QVariant SqlServerBackupPlugin::disableSchedule(const QVariantMap&)
+{
+    m_scheduleEnabled = false;
+    saveConfig();
+    
+    if (m_active) {
+        stopScheduledBackups();
+    }
+    
+    return true;
+}
+
+QVariant SqlServerBackupPlugin::setScheduleInterval(const QVariantMap& params)
+{
+    if (params.contains("interval")) {
+        m_scheduleInterval = params["interval"].toInt();
         saveConfig();
         
-        if (m_active) {
+        if (m_active && m_scheduleEnabled) {
             stopScheduledBackups();
+            startScheduledBackups();
         }
         
         return true;
     }
-    else if (command == "setScheduleInterval") {
-        if (params.contains("interval")) {
-            m_scheduleInterval = params["interval"].toInt();
-            saveConfig();
-            
-            if (m_active && m_scheduleEnabled) {
-                stopScheduledBackups();
-                startScheduledBackups();
-            }
-            
-            return true;
-        }
-        
-        return false;
-    }
     
-    LOG_WARNING(getPluginId(), QString("Unknown command: %1").arg(command));
-    
-    return QVariant();
+    return false;
 }
 
 void SqlServerBackupPlugin::performScheduledBackup()
@@ -0,0 +1,6 @@
+# Plugins linked into HostApplication when building with CONFIG+=static_plugins.
+# Each entry is the TARGET of a plugin project; its IPlugin class must be named
+# <TARGET>Plugin so that HostApplication can import it with Q_IMPORT_PLUGIN.
+STATIC_PLUGINS = \
+    MySqlBackup \
+    SqlServerBackup
\ No newline at end of file
@@ -3,12 +3,23 @@ TEMPLATE = subdirs
 SUBDIRS += \
     PluginCore \
     HostApplication \
-    Plugins
+    Plugins \
+    Tools \
+    benchmarks
 
 # Explicitly define the build order
 CONFIG += ordered
 HostApplication.depends = PluginCore
 Plugins.depends = PluginCore
+Tools.depends = PluginCore
+benchmarks.depends = PluginCore
+
+# With CONFIG+=static_plugins the plugins are linked into HostApplication,
+# so they have to be built before it
+static_plugins {
+    SUBDIRS = PluginCore Plugins HostApplication Tools benchmarks
+    HostApplication.depends += Plugins
+}
 
 # Create build directories
 system(mkdir -p build/debug)
@@ -0,0 +1,111 @@
+#include "PluginCore/DocumentCodec.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+
+// Converts the plugin metadata and config files of a directory between JSON and CBOR.
+// Each file is written next to its source with the other suffix.
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCoreApplication::setApplicationName("MetadataConverter");
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Convert plugin metadata and config files between JSON and CBOR.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption toCborOption("to-cbor", "Convert *.json files to *.cbor (default).");
+    QCommandLineOption toJsonOption("to-json", "Convert *.cbor files to *.json.");
+    QCommandLineOption removeSourceOption("remove-source", "Remove each source file after it is converted.");
+    parser.addOption(toCborOption);
+    parser.addOption(toJsonOption);
+    parser.addOption(removeSourceOption);
+    parser.addPositionalArgument("directory", "Directory holding the files to convert.");
+
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.size() != 1 || (parser.isSet(toCborOption) && parser.isSet(toJsonOption))) {
+        err << parser.helpText();
+        return 2;
+    }
+
+    QDir dir(arguments.first());
+    if (!dir.exists()) {
+        err << "Directory not found: " << dir.path() << Qt::endl;
+        return 1;
+    }
+
+    bool toJson = parser.isSet(toJsonOption);
+    QString sourceSuffix = toJson ? "cbor" : "json";
+    QString targetSuffix = toJson ? "json" : "cbor";
+    DocumentCodec::Format targetFormat = toJson ? DocumentCodec::Format::Json : DocumentCodec::Format::Cbor;
+
+    int converted = 0;
+    int failed = 0;
+
+    const QFileInfoList sourceFiles = dir.entryInfoList(QStringList() << "*." + sourceSuffix, QDir::Files, QDir::Name);
+    for (const QFileInfo& sourceFile : sourceFiles) {
+        // Dot files are the framework's own caches, which are not documents
+        if (sourceFile.fileName().startsWith('.')) {
+            continue;
+        }
+
+        QFile file(sourceFile.filePath());
+        if (!file.open(QIODevice::ReadOnly)) {
+            err << "Failed to open: " << sourceFile.filePath() << Qt::endl;
+            ++failed;
+            continue;
+        }
+
+        QJsonObject object;
+        bool decoded = DocumentCodec::decode(file.readAll(), object);
+        file.close();
+
+        if (!decoded) {
+            err << "Not a JSON or CBOR object: " << sourceFile.filePath() << Qt::endl;
+            ++failed;
+            continue;
+        }
+
+        QString targetPath = dir.filePath(sourceFile.completeBaseName() + "." + targetSuffix);
+
+        QSaveFile target(targetPath);
+        if (!target.open(QIODevice::WriteOnly)) {
+            err << "Failed to open for writing: " << targetPath << Qt::endl;
+            ++failed;
+            continue;
+        }
+
+        target.write(DocumentCodec::encode(object, targetFormat));
+        if (!target.commit()) {
+            err << "Failed to write: " << targetPath << Qt::endl;
+            ++failed;
+            continue;
+        }
+
+        // Both files would otherwise be loaded, and the stale one could be edited by mistake
+        if (parser.isSet(removeSourceOption) && !QFile::remove(sourceFile.filePath())) {
+            err << "Failed to remove: " << sourceFile.filePath() << Qt::endl;
+            ++failed;
+        }
+
+        out << sourceFile.fileName() << " -> " << QFileInfo(targetPath).fileName() << Qt::endl;
+        ++converted;
+    }
+
+    out << "Converted " << converted << " file(s), " << failed << " failed" << Qt::endl;
+
+    return failed > 0 ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "PluginCore/PluginDependencyGraph.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QVector>
+#include <functional>
+
+// Builds a synthetic dependency graph of many plugins and times registration, which includes
+// the cycle check, and the queries PluginManager makes during deactivation and shutdown.
+// Dependents were found before by scanning the dependency list of every plugin, which is
+// rebuilt here as the baseline for the query figures.
+
+namespace {
+
+const int MaxDependencies = 3;
+
+void report(QTextStream& out, const QString& name, qint64 elapsedNs, int operations)
+{
+    out << QString("%1 %2 ms, %3 us per operation")
+               .arg(name + ":", -44)
+               .arg(elapsedNs / 1e6, 10, 'f', 2)
+               .arg(elapsedNs / 1e3 / qMax(1, operations), 10, 'f', 3)
+        << Qt::endl;
+}
+
+qint64 timeNs(const std::function<void()>& work)
+{
+    QElapsedTimer timer;
+    timer.start();
+    work();
+    return timer.nsecsElapsed();
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCoreApplication::setApplicationName("DependencyGraphBenchmark");
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measure the plugin dependency graph on synthetic plugins.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption pluginsOption("plugins", "Number of synthetic plugins (default 10000).", "count", "10000");
+    QCommandLineOption queriesOption("queries", "Number of dependent queries (default 1000).", "count", "1000");
+    parser.addOption(pluginsOption);
+    parser.addOption(queriesOption);
+
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    bool pluginsOk = false;
+    bool queriesOk = false;
+    int pluginCount = parser.value(pluginsOption).toInt(&pluginsOk);
+    int queryCount = parser.value(queriesOption).toInt(&queriesOk);
+    if (!pluginsOk || !queriesOk || pluginCount <= 0 || queryCount <= 0) {
+        err << parser.helpText();
+        return 2;
+    }
+
+    // Each plugin depends on up to three plugins with lower numbers, mostly close ones, which
+    // gives long chains as well as wide levels and no cycles
+    QRandomGenerator random(42);
+    QStringList pluginIds;
+    QVector<QStringList> dependencies(pluginCount);
+    for (int i = 0; i < pluginCount; ++i) {
+        pluginIds.append(QString("com.benchmark.plugin%1").arg(i));
+        int dependencyCount = i == 0 ? 0 : random.bounded(qMin(i, MaxDependencies) + 1);
+        for (int d = 0; d < dependencyCount; ++d) {
+            int dependency = i - 1 - random.bounded(qMin(i, 64));
+            if (!dependencies[i].contains(pluginIds[dependency])) {
+                dependencies[i].append(pluginIds[dependency]);
+            }
+        }
+    }
+
+    QVector<int> queried;
+    for (int i = 0; i < queryCount; ++i) {
+        queried.append(random.bounded(pluginCount));
+    }
+
+    out << pluginCount << " plugins, " << queryCount << " queries" << Qt::endl;
+
+    // Registration in both orders, since the cycle check searches from either end of the new edges
+    PluginDependencyGraph reverseGraph;
+    report(out, "Register, dependents first", timeNs([&]() {
+        for (int i = pluginCount - 1; i >= 0; --i) {
+            reverseGraph.setDependencies(pluginIds[i], dependencies[i]);
+        }
+    }), pluginCount);
+
+    PluginDependencyGraph graph;
+    report(out, "Register, dependencies first", timeNs([&]() {
+        for (int i = 0; i < pluginCount; ++i) {
+            graph.setDependencies(pluginIds[i], dependencies[i]);
+        }
+    }), pluginCount);
+
+    QStringList cycle;
+    if (graph.setDependencies(pluginIds.first(), QStringList() << pluginIds.last(), &cycle)) {
+        err << "A dependency cycle was not detected" << Qt::endl;
+        return 1;
+    }
+
+    // Before: the dependents of a plugin are the plugins whose list names it
+    QHash<QString, QStringList> dependencyLists;
+    for (int i = 0; i < pluginCount; ++i) {
+        dependencyLists.insert(pluginIds[i], dependencies[i]);
+    }
+
+    int found = 0;
+    report(out, "Direct dependents, scanning (before)", timeNs([&]() {
+        for (int index : queried) {
+            for (auto it = dependencyLists.constBegin(); it != dependencyLists.constEnd(); ++it) {
+                if (it.value().contains(pluginIds[index])) {
+                    ++found;
+                }
+            }
+        }
+    }), queryCount);
+
+    int graphFound = 0;
+    report(out, "Direct dependents, graph", timeNs([&]() {
+        for (int index : queried) {
+            graphFound += graph.dependents(pluginIds[index]).size();
+        }
+    }), queryCount);
+
+    if (found != graphFound) {
+        err << "The graph found " << graphFound << " dependents, the scan " << found << Qt::endl;
+        return 1;
+    }
+
+    report(out, "Transitive dependents, graph", timeNs([&]() {
+        for (int index : queried) {
+            graph.transitiveDependents(pluginIds[index]);
+        }
+    }), queryCount);
+
+    report(out, "Unload order of all plugins, graph", timeNs([&]() {
+        graph.unloadOrder(pluginIds);
+    }), 1);
+
+    return 0;
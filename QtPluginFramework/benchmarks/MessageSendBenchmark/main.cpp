@@ -0,0 +1,142 @@
+#include "PluginCore/LogManager.h"
+#include "PluginCore/PermissionManager.h"
+#include "PluginCore/PluginCommunication.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QTextStream>
+#include <QVector>
+#include <functional>
+
+// Measures synchronous message sends per second across a table of receivers and message types.
+// The handler table PluginCommunication used before, a QMap keyed by "receiver:messageType" that
+// was searched twice per send, is rebuilt here as the baseline. It covers only the lookup and the
+// handler call; the framework figures also include the permission checks and logging of a send.
+
+namespace {
+
+const int ReceiverCount = 50;
+const int MessageTypeCount = 20;
+
+void measure(QTextStream& out, const QString& name, int iterations, const std::function<void(int)>& send)
+{
+    // Warm up outside the timing, so that first-use allocations are not counted
+    for (int i = 0; i < qMin(iterations, 1000); ++i) {
+        send(i);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        send(i);
+    }
+    qint64 elapsedNs = qMax<qint64>(1, timer.nsecsElapsed());
+
+    out << QString("%1 %2 sends/s, %3 ns per send")
+               .arg(name + ":", -36)
+               .arg(iterations * 1e9 / elapsedNs, 12, 'f', 0)
+               .arg(double(elapsedNs) / iterations, 8, 'f', 1)
+        << Qt::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCoreApplication::setApplicationName("MessageSendBenchmark");
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measure synchronous plugin message sends per second.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption iterationsOption("iterations", "Number of sends per measurement (default 1000000).", "count", "1000000");
+    parser.addOption(iterationsOption);
+
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    bool ok = false;
+    int iterations = parser.value(iterationsOption).toInt(&ok);
+    if (!ok || iterations <= 0) {
+        err << parser.helpText();
+        return 2;
+    }
+
+    // Logging would dominate the figures; a failed setup shows in the check below instead
+    LogManager::instance().setMaxLogLevel(LogLevel::Fatal);
+
+    PermissionManager& permissions = PermissionManager::instance();
+    permissions.initialize();
+    permissions.registerPermission("communication.send", "Send messages to other plugins");
+    permissions.registerPermission("communication.receive", "Receive messages from other plugins");
+
+    PluginCommunication& communication = PluginCommunication::instance();
+    communication.initialize();
+
+    const QString sender = "com.benchmark.sender";
+    permissions.grantPermission(sender, "communication.send");
+
+    PluginCommunication::MessageHandlerFunc handler = [](const QString&, const QVariant& data) {
+        return data;
+    };
+
+    QStringList receivers;
+    QStringList messageTypes;
+    for (int i = 0; i < ReceiverCount; ++i) {
+        receivers.append(QString("com.benchmark.receiver%1").arg(i));
+        permissions.grantPermission(receivers.last(), "communication.receive");
+    }
+    for (int i = 0; i < MessageTypeCount; ++i) {
+        messageTypes.append(QString("benchmark.message%1").arg(i));
+    }
+
+    QMap<QString, PluginCommunication::MessageHandlerFunc> legacyHandlers;
+    QVector<PluginCommunication::Route> routes;
+    for (const QString& receiver : receivers) {
+        for (const QString& messageType : messageTypes) {
+            communication.registerMessageHandler(receiver, messageType, handler);
+            legacyHandlers.insert(QString("%1:%2").arg(receiver, messageType), handler);
+            routes.append(communication.resolveRoute(receiver, messageType));
+        }
+    }
+
+    const QVariant data(42);
+
+    if (communication.sendMessage(sender, receivers.first(), messageTypes.first(), data) != data) {
+        err << "Messages are not delivered" << Qt::endl;
+        return 1;
+    }
+
+    out << "Sending to " << ReceiverCount << " receivers with " << MessageTypeCount << " message types each, "
+        << iterations << " sends per measurement" << Qt::endl;
+
+    measure(out, "QMap by \"receiver:type\" (before)", iterations, [&](int i) {
+        const QString& receiver = receivers[i % ReceiverCount];
+        const QString& messageType = messageTypes[(i / ReceiverCount) % MessageTypeCount];
+
+        QString key = QString("%1:%2").arg(receiver, messageType);
+        if (legacyHandlers.contains(key)) {
+            legacyHandlers[key](sender, data);
+        }
+    });
+
+    measure(out, "sendMessage by ID", iterations, [&](int i) {
+        communication.sendMessage(sender, receivers[i % ReceiverCount], messageTypes[(i / ReceiverCount) % MessageTypeCount], data);
+    });
+
+    measure(out, "sendMessage through a route", iterations, [&](int i) {
+        communication.sendMessage(sender, routes[(i % ReceiverCount) * MessageTypeCount + (i / ReceiverCount) % MessageTypeCount], data);
+    });
+
+    communication.shutdown();
+    permissions.shutdown();
+
+    return 0;
+}
\ No newline at end of file
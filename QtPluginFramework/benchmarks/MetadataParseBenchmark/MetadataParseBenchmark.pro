@@ -0,0 +1,36 @@
+QT += core
+QT -= gui
+
+TARGET = MetadataParseBenchmark
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+# The following define makes your compiler emit warnings if you use
+# any feature of Qt which has been marked as deprecated
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# You can also make your code fail to compile if you use deprecated APIs.
+# In order to do so, uncomment the following line.
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+SOURCES += \
+    main.cpp
+
+# Link with PluginCore
+win32:CONFIG(release, debug|release): LIBS += -L$$PWD/../../build/release/ -lPluginCore
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$PWD/../../build/debug/ -lPluginCore
+else:unix: LIBS += -L$$PWD/../../build/release/ -lPluginCore
+
+INCLUDEPATH += $$PWD/../../
+DEPENDPATH += $$PWD/../../
+
+# Output directory
+CONFIG(debug, debug|release) {
+    DESTDIR = $$PWD/../../build/debug
+} else {
+    DESTDIR = $$PWD/../../build/release
+}
+
+OBJECTS_DIR = $$DESTDIR/.obj/MetadataParseBenchmark
+MOC_DIR = $$DESTDIR/.moc/MetadataParseBenchmark
\ No newline at end of file
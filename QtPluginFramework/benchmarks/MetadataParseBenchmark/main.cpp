@@ -0,0 +1,217 @@
+#include "PluginCore/LogManager.h"
+#include "PluginCore/PluginMetadata.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QVector>
+#include <QVersionNumber>
+#include <functional>
+
+// Measures the metadata getters PluginManager calls while resolving dependencies and checking
+// compatibility, and the one-time cost of parsing and interning that pays for them. The getters
+// PluginMetadata had before, which looked each field up in the JSON object and converted it on
+// every call, are rebuilt here as the baseline.
+
+namespace {
+
+const int DependencyCount = 4;
+const int PermissionCount = 3;
+
+// Before: every getter reads and converts the JSON object
+class LegacyMetadata
+{
+public:
+    explicit LegacyMetadata(const QJsonObject& metadata) : m_metadata(metadata) {}
+
+    QString getPluginId() const { return m_metadata.value("id").toString(); }
+
+    QVersionNumber getVersionNumber() const
+    {
+        return QVersionNumber::fromString(m_metadata.value("version").toString());
+    }
+
+    QStringList getPluginDependencies() const
+    {
+        QStringList dependencies;
+        for (const QJsonValue& dep : m_metadata.value("dependencies").toArray()) {
+            dependencies.append(dep.toString());
+        }
+        return dependencies;
+    }
+
+    QStringList getRequiredPermissions() const
+    {
+        QStringList permissions;
+        for (const QJsonValue& perm : m_metadata.value("requiredPermissions").toArray()) {
+            permissions.append(perm.toString());
+        }
+        return permissions;
+    }
+
+    bool isCompatibleWithFramework(const QString& frameworkVersion) const
+    {
+        QVersionNumber pluginMinVersion = QVersionNumber::fromString(m_metadata.value("minFrameworkVersion").toString("1.0.0"));
+        return QVersionNumber::fromString(frameworkVersion) >= pluginMinVersion;
+    }
+
+    bool dependsOn(const QString& pluginId) const { return getPluginDependencies().contains(pluginId); }
+
+private:
+    QJsonObject m_metadata;
+};
+
+void report(QTextStream& out, const QString& name, qint64 elapsedNs, int operations)
+{
+    out << QString("%1 %2 ms, %3 ns per plugin")
+               .arg(name + ":", -40)
+               .arg(elapsedNs / 1e6, 10, 'f', 2)
+               .arg(double(elapsedNs) / qMax(1, operations), 10, 'f', 1)
+        << Qt::endl;
+}
+
+qint64 timeNs(const std::function<void()>& work)
+{
+    QElapsedTimer timer;
+    timer.start();
+    work();
+    return timer.nsecsElapsed();
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCoreApplication::setApplicationName("MetadataParseBenchmark");
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measure plugin metadata parsing and getter calls.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption pluginsOption("plugins", "Number of synthetic plugins (default 10000).", "count", "10000");
+    QCommandLineOption roundsOption("rounds", "Getter rounds per plugin (default 20).", "count", "20");
+    parser.addOption(pluginsOption);
+    parser.addOption(roundsOption);
+
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    bool pluginsOk = false;
+    bool roundsOk = false;
+    int pluginCount = parser.value(pluginsOption).toInt(&pluginsOk);
+    int rounds = parser.value(roundsOption).toInt(&roundsOk);
+    if (!pluginsOk || !roundsOk || pluginCount <= 0 || rounds <= 0) {
+        err << parser.helpText();
+        return 2;
+    }
+
+    // Invalid metadata is reported below; the parser's own messages would only slow it down
+    LogManager::instance().setMaxLogLevel(LogLevel::Fatal);
+
+    QStringList pluginIds;
+    QVector<QJsonObject> documents;
+    for (int i = 0; i < pluginCount; ++i) {
+        pluginIds.append(QString("com.benchmark.plugin%1").arg(i));
+
+        QJsonArray dependencies;
+        for (int d = 1; d <= DependencyCount && d <= i; ++d) {
+            dependencies.append(pluginIds[i - d]);
+        }
+        QJsonArray permissions;
+        for (int p = 0; p < PermissionCount; ++p) {
+            permissions.append(QString("benchmark.permission%1").arg((i + p) % 10));
+        }
+
+        QJsonObject document;
+        document["id"] = pluginIds.last();
+        document["name"] = QString("Benchmark Plugin %1").arg(i);
+        document["version"] = QString("1.%1.%2").arg(i % 10).arg(i % 7);
+        document["vendor"] = "Benchmark";
+        document["minFrameworkVersion"] = "1.0.0";
+        document["dependencies"] = dependencies;
+        document["requiredPermissions"] = permissions;
+        documents.append(document);
+    }
+
+    out << pluginCount << " plugins with up to " << DependencyCount << " dependencies each, " << rounds
+        << " getter rounds per plugin" << Qt::endl;
+
+    QVector<LegacyMetadata> legacy;
+    legacy.reserve(pluginCount);
+    report(out, "Wrap JSON (before)", timeNs([&]() {
+        for (const QJsonObject& document : documents) {
+            legacy.append(LegacyMetadata(document));
+        }
+    }), pluginCount);
+
+    QVector<PluginMetadata> metadata;
+    metadata.reserve(pluginCount);
+    report(out, "Parse", timeNs([&]() {
+        for (const QJsonObject& document : documents) {
+            metadata.append(PluginMetadata(document));
+        }
+    }), pluginCount);
+
+    report(out, "Intern handles", timeNs([&]() {
+        for (PluginMetadata& plugin : metadata) {
+            plugin.internHandles();
+        }
+    }), pluginCount);
+
+    for (int i = 0; i < pluginCount; ++i) {
+        if (!metadata[i].isValid() || metadata[i].getPluginDependencies() != legacy[i].getPluginDependencies()) {
+            err << "The metadata of " << pluginIds[i] << " was not parsed as expected" << Qt::endl;
+            return 1;
+        }
+    }
+
+    // The calls a dependency check makes: identity, version, compatibility and each dependency
+    const QString frameworkVersion = "1.0.0";
+    const QVersionNumber frameworkVersionNumber = QVersionNumber::fromString(frameworkVersion);
+    int matches = 0;
+    report(out, "Getters (before)", timeNs([&]() {
+        for (int round = 0; round < rounds; ++round) {
+            for (int i = 0; i < pluginCount; ++i) {
+                const LegacyMetadata& plugin = legacy[i];
+                matches += plugin.getPluginId() == pluginIds[i];
+                matches += plugin.getVersionNumber().majorVersion();
+                matches += plugin.isCompatibleWithFramework(frameworkVersion);
+                matches += plugin.getRequiredPermissions().size();
+                for (const QString& dependency : plugin.getPluginDependencies()) {
+                    matches += plugin.dependsOn(dependency);
+                }
+            }
+        }
+    }), pluginCount * rounds);
+
+    int legacyMatches = matches;
+    matches = 0;
+    report(out, "Getters", timeNs([&]() {
+        for (int round = 0; round < rounds; ++round) {
+            for (int i = 0; i < pluginCount; ++i) {
+                const PluginMetadata& plugin = metadata[i];
+                matches += plugin.getPluginId() == pluginIds[i];
+                matches += plugin.getVersionNumber().majorVersion();
+                matches += plugin.isCompatibleWithFramework(frameworkVersionNumber);
+                matches += plugin.getRequiredPermissions().size();
+                for (const QString& dependency : plugin.getPluginDependencies()) {
+                    matches += plugin.dependsOn(dependency);
+                }
+            }
+        }
+    }), pluginCount * rounds);
+
+    if (matches != legacyMatches) {
+        err << "The getters disagree with the baseline" << Qt::endl;
+        return 1;
+    }
+
+    return 0;
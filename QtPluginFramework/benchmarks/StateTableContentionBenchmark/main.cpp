@@ -0,0 +1,222 @@
+#include "PluginCore/IPlugin.h"
+#include "PluginCore/LogManager.h"
+#include "PluginCore/PluginManager.h"
+#include <QAtomicInt>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QMap>
+#include <QRecursiveMutex>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QVector>
+#include <QtPlugin>
+#include <functional>
+
+// Measures PluginManager::getPluginState() calls per second from several threads, alone and
+// while the main thread activates and deactivates a plugin whose lifecycle calls are slow.
+// The getter queries by plugin ID, as refreshPluginUI() and the plugin manager dialog do.
+// Before, it looked the ID up in a QMap under the recursive lifecycle mutex, which is
+// rebuilt here as the baseline, with the writer holding the mutex for a whole operation.
+
+namespace {
+
+const int QueriedIdCount = 64;
+const char* const BenchmarkPluginId = "com.benchmark.StateQuery";
+
+// Microseconds each activation and deactivation of the benchmark plugin takes
+int lifecycleHoldUs = 0;
+
+using QueryFunc = std::function<PluginState(const QString&)>;
+using TransitionFunc = std::function<void(int)>;
+
+double run(const QStringList& pluginIds, int readerCount, int durationMs, const QueryFunc& query,
+           const TransitionFunc& transition)
+{
+    QAtomicInt stop(0);
+    QVector<qint64> queryCounts(readerCount);
+    QVector<QThread*> threads;
+
+    for (int reader = 0; reader < readerCount; ++reader) {
+        threads.append(QThread::create([&pluginIds, &query, &stop, &queryCounts, reader]() {
+            qint64 queries = 0;
+            while (!stop.loadRelaxed()) {
+                for (const QString& pluginId : pluginIds) {
+                    query(pluginId);
+                }
+                queries += pluginIds.size();
+            }
+            queryCounts[reader] = queries;
+        }));
+    }
+
+    for (QThread* thread : threads) {
+        thread->start();
+    }
+
+    // The writer runs on this thread, which owns the benchmark plugin
+    QElapsedTimer timer;
+    timer.start();
+    if (transition) {
+        for (int i = 0; timer.elapsed() < durationMs; ++i) {
+            transition(i);
+        }
+    } else {
+        QThread::msleep(durationMs);
+    }
+    stop.storeRelaxed(1);
+    qint64 elapsedMs = qMax<qint64>(1, timer.elapsed());
+
+    for (QThread* thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+
+    qint64 totalQueries = 0;
+    for (qint64 queries : queryCounts) {
+        totalQueries += queries;
+    }
+
+    return totalQueries * 1000.0 / elapsedMs;
+}
+
+void report(QTextStream& out, const QString& name, double queriesPerSecond)
+{
+    out << QString("%1 %2 queries/s").arg(name + ":", -48).arg(queriesPerSecond, 14, 'f', 0) << Qt::endl;
+}
+
+} // namespace
+
+/**
+ * @brief Plugin linked into the benchmark whose activation and deactivation are slow
+ */
+class BenchmarkPlugin : public QObject, public IPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID PluginInterface_iid FILE "BenchmarkPlugin.json")
+    Q_INTERFACES(IPlugin)
+
+public:
+    bool initialize() override { return true; }
+    bool activate() override { QThread::usleep(lifecycleHoldUs); return true; }
+    bool deactivate() override { QThread::usleep(lifecycleHoldUs); return true; }
+    bool shutdown() override { return true; }
+
+    QString getPluginId() const override { return BenchmarkPluginId; }
+    QString getPluginName() const override { return "State Query Benchmark"; }
+    QString getPluginVersion() const override { return "1.0.0"; }
+    QString getPluginVendor() const override { return "Benchmark"; }
+    QString getPluginDescription() const override { return QString(); }
+    QStringList getPluginDependencies() const override { return QStringList(); }
+    QJsonObject getPluginMetadata() const override { return QJsonObject(); }
+
+    QVariant executeCommand(const QString&, const QVariantMap&) override { return QVariant(); }
+};
+
+Q_IMPORT_PLUGIN(BenchmarkPlugin)
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCoreApplication::setApplicationName("StateTableContentionBenchmark");
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measure plugin state queries per second under lifecycle lock contention.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption threadsOption("threads", "Number of reader threads (default: one per core, at least 2).", "count");
+    QCommandLineOption durationOption("duration", "Milliseconds per measurement (default 1000).", "ms", "1000");
+    QCommandLineOption holdOption("hold", "Microseconds each lifecycle operation takes (default 2000).", "us", "2000");
+    parser.addOption(threadsOption);
+    parser.addOption(durationOption);
+    parser.addOption(holdOption);
+
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    bool threadsOk = true;
+    bool durationOk = false;
+    bool holdOk = false;
+    int readerCount = parser.isSet(threadsOption) ? parser.value(threadsOption).toInt(&threadsOk) : qMax(2, QThread::idealThreadCount());
+    int durationMs = parser.value(durationOption).toInt(&durationOk);
+    lifecycleHoldUs = parser.value(holdOption).toInt(&holdOk);
+    if (!threadsOk || !durationOk || !holdOk || readerCount <= 0 || durationMs <= 0 || lifecycleHoldUs < 0) {
+        err << parser.helpText();
+        return 2;
+    }
+
+    // Logging every transition would dominate the writer; failures show in the check below
+    LogManager::instance().setMaxLogLevel(LogLevel::Fatal);
+
+    QTemporaryDir workDir;
+    PluginManager& pluginManager = PluginManager::instance();
+    pluginManager.setLazyLoadingEnabled(false);
+    if (!workDir.isValid() || !pluginManager.initialize(workDir.filePath("plugins"), workDir.filePath("metadata"))) {
+        err << "Failed to initialize the plugin manager" << Qt::endl;
+        return 1;
+    }
+
+    pluginManager.scanForPlugins();
+    if (!pluginManager.loadPlugin(BenchmarkPluginId) || !pluginManager.activatePlugin(BenchmarkPluginId)) {
+        err << "Failed to load the benchmark plugin" << Qt::endl;
+        return 1;
+    }
+
+    // The other IDs are unknown to the manager, as are IDs of plugins that are not installed
+    QStringList pluginIds;
+    pluginIds.append(BenchmarkPluginId);
+    for (int i = 1; i < QueriedIdCount; ++i) {
+        pluginIds.append(QString("com.benchmark.plugin%1").arg(i));
+    }
+
+    // Before: a map guarded by the recursive lifecycle mutex, which readers and writer share
+    QRecursiveMutex lifecycleMutex;
+    QMap<QString, PluginState> lockedStates;
+    lockedStates.insert(BenchmarkPluginId, PluginState::Active);
+
+    QueryFunc lockedQuery = [&lifecycleMutex, &lockedStates](const QString& pluginId) {
+        QRecursiveMutexLocker locker(&lifecycleMutex);
+        return lockedStates.value(pluginId, PluginState::NotLoaded);
+    };
+    TransitionFunc lockedTransition = [&lifecycleMutex, &lockedStates](int i) {
+        QRecursiveMutexLocker locker(&lifecycleMutex);
+        QThread::usleep(lifecycleHoldUs);
+        lockedStates.insert(BenchmarkPluginId, i % 2 ? PluginState::Active : PluginState::Inactive);
+    };
+
+    // After: the real getter and lifecycle operations
+    QueryFunc managerQuery = [&pluginManager](const QString& pluginId) {
+        return pluginManager.getPluginState(pluginId);
+    };
+    bool transitionsOk = true;
+    TransitionFunc managerTransition = [&pluginManager, &transitionsOk](int i) {
+        bool ok = i % 2 ? pluginManager.activatePlugin(BenchmarkPluginId) : pluginManager.deactivatePlugin(BenchmarkPluginId);
+        transitionsOk = transitionsOk && ok;
+    };
+
+    out << readerCount << " reader threads querying " << QueriedIdCount << " plugin IDs for " << durationMs
+        << " ms per measurement; each lifecycle operation takes " << lifecycleHoldUs << " us" << Qt::endl;
+
+    report(out, "Locked map, no writer (before)", run(pluginIds, readerCount, durationMs, lockedQuery, TransitionFunc()));
+    report(out, "Locked map, writer running (before)", run(pluginIds, readerCount, durationMs, lockedQuery, lockedTransition));
+    report(out, "getPluginState, no lifecycle operations", run(pluginIds, readerCount, durationMs, managerQuery, TransitionFunc()));
+    report(out, "getPluginState, activate/deactivate running", run(pluginIds, readerCount, durationMs, managerQuery, managerTransition));
+
+    pluginManager.shutdown();
+
+    if (!transitionsOk) {
+        err << "Activating or deactivating the benchmark plugin failed" << Qt::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+#include "main.moc
\ No newline at end of file
@@ -0,0 +1,7 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    MessageSendBenchmark \
+    StateTableContentionBenchmark \
+    DependencyGraphBenchmark \
+    MetadataParseBenchmark
\ No newline at end of file
@@ -63,5 +63,25 @@ if [ $? -ne 0 ]; then
 fi
 cd ../..
 
+# Build Tools
+cd Tools/MetadataConverter
+qmake CONFIG+=$BUILD_MODE
+make
+if [ $? -ne 0 ]; then
+    echo "Error building MetadataConverter tool"
+    exit 1
+fi
+cd ../..
+
+# Build benchmarks
+cd benchmarks
+qmake CONFIG+=$BUILD_MODE
+make
+if [ $? -ne 0 ]; then
+    echo "Error building benchmarks"
+    exit 1
+fi
+cd ..
+
 echo "Build completed successfully!"
 echo "The application is available in build/$BUILD_MODE/HostApplication"
\ No newline at end of file
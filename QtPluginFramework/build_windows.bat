@@ -61,5 +61,25 @@ if %ERRORLEVEL% neq 0 (
 )
 cd ..\..
 
+REM Build Tools
+cd Tools\MetadataConverter
+qmake CONFIG+=%BUILD_MODE%
+nmake %BUILD_MODE%
+if %ERRORLEVEL% neq 0 (
+    echo Error building MetadataConverter tool
+    exit /b %ERRORLEVEL%
+)
+cd ..\..
+
+REM Build benchmarks
+cd benchmarks
+qmake CONFIG+=%BUILD_MODE%
+nmake %BUILD_MODE%
+if %ERRORLEVEL% neq 0 (
+    echo Error building benchmarks
+    exit /b %ERRORLEVEL%
+)
+cd ..
+
 echo Build completed successfully!
 echo The application is available in build\%BUILD_MODE%\HostApplication.exe
\ No newline at end of file